@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <atomic>
 #include <memory> // Added for std::shared_ptr
 
 #include "src/memllib/synth/maxiPAF.hpp"
@@ -454,6 +455,7 @@ public:
     void setVoiceSpace(size_t i) {
         if (i < voiceSpaces.size()) {
             currentVoiceSpace = voiceSpaces[i].mappingFunction;
+            paramsValid.store(false, std::memory_order_release);
         }
     }
 
@@ -568,6 +570,13 @@ public:
             }
         }
 
+        // Mapping and filter coefficients only depend on params and the voice space
+        // Re-arm in one step so a voice space change arriving meanwhile is not lost
+        if (paramsValid.exchange(true, std::memory_order_acq_rel) && params == lastParams) {
+            return;
+        }
+        lastParams = params;
+
         currentVoiceSpace(params);
         dyn.setAttackHigh(compAttack);
         dyn.setReleaseHigh(compRelease);
@@ -625,6 +634,9 @@ protected:
     bool bypassPrePostGain = false;
     bool bypassInFilters = false;
 
+    std::array<float, NPARAMS> lastParams{};
+    std::atomic<bool> paramsValid{false};  // Cleared by setVoiceSpace() on the control thread
+
     maxiDynamicsLite dyn,   dyn1;
 
     maxiBiquad lowshelf;
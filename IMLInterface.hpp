@@ -25,6 +25,8 @@ public:
         n_iterations_ = 1000;
         input_state_.resize(n_inputs, 0.5f);
         output_state_.resize(n_outputs, 0);
+        sent_output_.resize(n_outputs, 0);
+        output_sent_ = false;
         // Init/reset state machine
         training_mode_ = INFERENCE_MODE;
         perform_inference_ = true;
@@ -130,6 +132,12 @@ public:
         }
     }
 
+    // Outputs that move less than this since the last send are not sent
+    void SetOutputChangeEpsilon(float epsilon)
+    {
+        output_epsilon_ = epsilon;
+    }
+
     void SetIterations(size_t iterations)
     {
         n_iterations_ = iterations;
@@ -150,6 +158,9 @@ protected:
     // Controls/sensors
     std::vector<float> input_state_;
     std::vector<float> output_state_;
+    std::vector<float> sent_output_;
+    bool output_sent_ = false;
+    float output_epsilon_ = 1e-4f;
 
     // MLP core
     std::unique_ptr<Dataset> dataset_;
@@ -210,6 +221,18 @@ protected:
         mlp_->GetOutput(input, &output);
         // Process inferenced data
         output_state_ = output;
+
+        // Skip the send, and the voice-space mapping it triggers, when
+        // no output moved past the epsilon
+        bool changed = !output_sent_;
+        for (size_t i = 0; i < n_outputs_ && !changed; i++) {
+            changed = fabsf(output[i] - sent_output_[i]) > output_epsilon_;
+        }
+        if (!changed) {
+            return;
+        }
+        sent_output_ = output;
+        output_sent_ = true;
         SendParamsToQueue(output);
     }
 
@@ -0,0 +1,612 @@
+// nisps_bench: repeatable microbenchmarks for nisps-core.
+//
+// Usage: nisps_bench [--quick] [output.json]
+//
+// Results are written as JSON (to stdout unless a file is given) so runs
+// can be compared over time; progress goes to stderr.
+
+#include <nisps/nisps.hpp>
+#include <nisps/fourier_features.hpp>
+#include <nisps/gru.hpp>
+#include <nisps/gesture.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+bool g_quick = false;
+
+double ElapsedNs(clock_type::time_point start) {
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+// Summary of per-call timings in nanoseconds
+struct Latency {
+    double mean = 0, p50 = 0, p99 = 0, max = 0;
+};
+
+Latency Summarise(std::vector<double> &ns) {
+    Latency l;
+    if (ns.empty()) {
+        return l;
+    }
+    std::sort(ns.begin(), ns.end());
+    for (double v : ns) {
+        l.mean += v;
+    }
+    l.mean /= static_cast<double>(ns.size());
+    auto pct = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * (ns.size() - 1) + 0.5))]; };
+    l.p50 = pct(0.5);
+    l.p99 = pct(0.99);
+    l.max = ns.back();
+    return l;
+}
+
+// Minimal JSON writer: one flat object per result
+class Json {
+ public:
+    void Begin(const std::string &benchmark) {
+        out_ << (first_ ? "\n" : ",\n") << "    {\"benchmark\": \"" << benchmark << "\"";
+        first_ = false;
+    }
+    void Field(const char *key, const std::string &value) { out_ << ", \"" << key << "\": \"" << value << "\""; }
+    void Field(const char *key, double value) {
+        out_ << ", \"" << key << "\": ";
+        if (std::isfinite(value)) {
+            out_ << value;
+        } else {
+            out_ << "null";
+        }
+    }
+    void Field(const char *key, const Latency &l) {
+        out_ << ", \"" << key << "\": {\"mean_ns\": " << l.mean << ", \"p50_ns\": " << l.p50
+             << ", \"p99_ns\": " << l.p99 << ", \"max_ns\": " << l.max << "}";
+    }
+    void End() { out_ << "}"; }
+    std::string Str() const {
+        return "{\n  \"suite\": \"nisps_bench\",\n  \"quick\": " + std::string(g_quick ? "true" : "false") +
+               ",\n  \"results\": [" + out_.str() + "\n  ]\n}\n";
+    }
+
+ private:
+    std::ostringstream out_;
+    bool first_ = true;
+};
+
+struct Topology {
+    const char *name;
+    size_t inputs;                 // Without the bias input
+    std::vector<size_t> hidden;
+    size_t outputs;
+};
+
+const std::vector<Topology> kTopologies = {
+    {"tiny_2x4x2", 2, {4}, 2},
+    {"default_2x10x10x14x4", 2, {10, 10, 14}, 4},
+    {"wide_4x32x32x8", 4, {32, 32}, 8},
+    {"deep_4x16x16x16x16x4", 4, {16, 16, 16, 16}, 4},
+};
+
+std::string TopologyString(const Topology &t) {
+    std::string s = std::to_string(t.inputs + 1);
+    for (size_t h : t.hidden) {
+        s += '-';
+        s += std::to_string(h);
+    }
+    s += '-';
+    s += std::to_string(t.outputs);
+    return s;
+}
+
+template<typename T>
+const char *TypeName() {
+    return sizeof(T) == sizeof(float) ? "float" : "double";
+}
+
+template<typename T>
+nisps::MLP<T> MakeMLP(const Topology &t) {
+    std::vector<size_t> nodes{t.inputs + 1};
+    nodes.insert(nodes.end(), t.hidden.begin(), t.hidden.end());
+    nodes.push_back(t.outputs);
+    std::vector<nisps::ACTIVATION_FUNCTIONS> activations(t.hidden.size(), nisps::RELU);
+    activations.push_back(nisps::SIGMOID);
+    nisps::MLP<T> mlp(nodes, activations, nisps::loss::LOSS_MSE);
+    mlp.SetSeed(1);
+    mlp.InitXavier();
+    return mlp;
+}
+
+// Canned mappings over [0, 1]^inputs, each output in [0.1, 0.9]
+enum class Mapping { kLinear, kProduct, kSine };
+
+const char *MappingName(Mapping m) {
+    switch (m) {
+        case Mapping::kLinear: return "linear";
+        case Mapping::kProduct: return "product";
+        default: return "sine";
+    }
+}
+
+template<typename T>
+typename nisps::MLP<T>::training_pair_t MakeData(size_t inputs, size_t outputs, size_t n,
+                                                 Mapping mapping, uint64_t seed) {
+    nisps::Random rng(seed);
+    typename nisps::MLP<T>::training_pair_t data;
+    for (size_t s = 0; s < n; s++) {
+        std::vector<T> x(inputs + 1, static_cast<T>(1));
+        for (size_t i = 0; i < inputs; i++) {
+            x[i] = rng.Uniform<T>(0, 1);
+        }
+        std::vector<T> y(outputs);
+        for (size_t k = 0; k < outputs; k++) {
+            const T a = x[k % inputs], b = x[(k + 1) % inputs];
+            T v;
+            switch (mapping) {
+                case Mapping::kLinear: v = (a + b) / 2; break;
+                case Mapping::kProduct: v = a * b; break;
+                default: v = static_cast<T>(0.5 + 0.5 * std::sin(6.0 * a + 3.0 * b * k)); break;
+            }
+            y[k] = static_cast<T>(0.1) + static_cast<T>(0.8) * v;
+        }
+        data.first.push_back(std::move(x));
+        data.second.push_back(std::move(y));
+    }
+    return data;
+}
+
+template<typename T>
+void BenchGetOutput(Json &json, const Topology &t) {
+    auto mlp = MakeMLP<T>(t);
+    const auto data = MakeData<T>(t.inputs, t.outputs, 64, Mapping::kLinear, 2);
+    const size_t n = g_quick ? 2000 : 20000;
+    std::vector<double> ns(n);
+    std::vector<T> y;
+    for (size_t i = 0; i < 100; i++) {
+        mlp.GetOutput(data.first[i % data.first.size()], &y);
+    }
+    for (size_t i = 0; i < n; i++) {
+        const auto start = clock_type::now();
+        mlp.GetOutput(data.first[i % data.first.size()], &y);
+        ns[i] = ElapsedNs(start);
+    }
+    json.Begin("get_output");
+    json.Field("topology", TopologyString(t));
+    json.Field("type", TypeName<T>());
+    json.Field("calls", static_cast<double>(n));
+    json.Field("latency", Summarise(ns));
+    json.End();
+
+    auto frozen = mlp.Freeze();
+    y.resize(t.outputs);
+    for (size_t i = 0; i < n; i++) {
+        const auto start = clock_type::now();
+        frozen.Process(data.first[i % data.first.size()], y);
+        ns[i] = ElapsedNs(start);
+    }
+    json.Begin("frozen_process");
+    json.Field("topology", TopologyString(t));
+    json.Field("type", TypeName<T>());
+    json.Field("calls", static_cast<double>(n));
+    json.Field("bytes", static_cast<double>(frozen.GetFootprintBytes()));
+    json.Field("latency", Summarise(ns));
+    json.End();
+}
+
+void BenchIMLProcess(Json &json, const Topology &t) {
+    nisps::IML<float> iml(t.inputs, t.outputs, t.hidden);
+    const size_t n = g_quick ? 2000 : 20000;
+    std::vector<double> ns(n);
+    std::vector<float> x(t.inputs);
+    nisps::Random rng(3);
+    for (size_t i = 0; i < n; i++) {
+        for (auto &v : x) {
+            v = rng.Uniform<float>(0, 1);
+        }
+        iml.set_inputs(x.data(), x.size());
+        const auto start = clock_type::now();
+        iml.process();
+        ns[i] = ElapsedNs(start);
+    }
+    json.Begin("iml_process");
+    json.Field("topology", TopologyString(t));
+    json.Field("type", "float");
+    json.Field("calls", static_cast<double>(n));
+    json.Field("latency", Summarise(ns));
+    json.End();
+}
+
+template<typename T>
+void BenchTrainThroughput(Json &json, const Topology &t) {
+    const auto data = MakeData<T>(t.inputs, t.outputs, 64, Mapping::kProduct, 4);
+    const int epochs = g_quick ? 20 : 100;
+    for (size_t batch : {size_t(0), size_t(8)}) {
+        auto mlp = MakeMLP<T>(t);
+        const auto start = clock_type::now();
+        const T loss = batch ? mlp.TrainBatch(data, 0.01f, epochs, batch, 0, false)
+                             : mlp.Train(data, 0.01f, epochs, 0, false);
+        const double seconds = ElapsedNs(start) * 1e-9;
+        json.Begin(batch ? "train_batch_throughput" : "train_throughput");
+        json.Field("topology", TopologyString(t));
+        json.Field("type", TypeName<T>());
+        json.Field("batch_size", static_cast<double>(batch));
+        json.Field("epochs", static_cast<double>(epochs));
+        json.Field("samples_per_s", static_cast<double>(epochs) * data.first.size() / seconds);
+        json.Field("final_loss", static_cast<double>(loss));
+        json.End();
+    }
+}
+
+template<typename T>
+void BenchConvergence(Json &json, const Topology &t) {
+    const int max_epochs = g_quick ? 200 : 2000;
+    const int chunk = 10;
+    const T target = static_cast<T>(0.002);
+    for (Mapping m : {Mapping::kLinear, Mapping::kProduct, Mapping::kSine}) {
+        auto mlp = MakeMLP<T>(t);
+        const auto data = MakeData<T>(t.inputs, t.outputs, 32, m, 5);
+        const auto start = clock_type::now();
+        int epochs = 0;
+        T loss = 0;
+        while (epochs < max_epochs) {
+            loss = mlp.TrainBatch(data, 0.01f, chunk, 8, 0, false);
+            epochs += chunk;
+            if (loss < target) {
+                break;
+            }
+        }
+        const double seconds = ElapsedNs(start) * 1e-9;
+        json.Begin("convergence");
+        json.Field("topology", TopologyString(t));
+        json.Field("type", TypeName<T>());
+        json.Field("dataset", MappingName(m));
+        json.Field("target_loss", static_cast<double>(target));
+        json.Field("converged", loss < target ? "yes" : "no");
+        json.Field("epochs", static_cast<double>(epochs));
+        json.Field("seconds", seconds);
+        json.Field("final_loss", static_cast<double>(loss));
+        json.End();
+    }
+}
+
+template<typename T>
+void BenchSerialisation(Json &json, const Topology &t) {
+    auto mlp = MakeMLP<T>(t);
+    auto copy = MakeMLP<T>(t);
+    const size_t n = g_quick ? 200 : 2000;
+    std::vector<uint8_t> buffer(mlp.SerialisedSize());
+    std::vector<double> save_ns(n), load_ns(n);
+    for (size_t i = 0; i < n; i++) {
+        auto start = clock_type::now();
+        mlp.Serialise(buffer);
+        save_ns[i] = ElapsedNs(start);
+        start = clock_type::now();
+        copy.FromSerialised(buffer);
+        load_ns[i] = ElapsedNs(start);
+    }
+
+    const std::string path = std::string("nisps_bench_") + TypeName<T>() + ".nsm";
+    const size_t n_files = g_quick ? 20 : 100;
+    std::vector<double> file_save_ns(n_files), file_load_ns(n_files);
+    for (size_t i = 0; i < n_files; i++) {
+        auto start = clock_type::now();
+        mlp.SaveModel(path);
+        file_save_ns[i] = ElapsedNs(start);
+        start = clock_type::now();
+        copy.LoadModel(path);
+        file_load_ns[i] = ElapsedNs(start);
+    }
+    std::remove(path.c_str());
+
+    json.Begin("serialisation");
+    json.Field("topology", TopologyString(t));
+    json.Field("type", TypeName<T>());
+    json.Field("bytes", static_cast<double>(buffer.size()));
+    json.Field("serialise", Summarise(save_ns));
+    json.Field("from_serialised", Summarise(load_ns));
+    json.Field("save_model", Summarise(file_save_ns));
+    json.Field("load_model", Summarise(file_load_ns));
+    json.End();
+}
+
+void BenchDataset(Json &json) {
+    const size_t n = g_quick ? 2000 : 20000;
+    const std::vector<float> feature{0.1f, 0.2f, 0.3f, 0.4f}, label{0.5f, 0.6f};
+    for (bool replay : {false, true}) {
+        nisps::Dataset dataset;
+        dataset.ReplayMemory(replay);
+        dataset.SetForgetMode(nisps::Dataset::RANDOM_OLDER);
+        std::vector<double> add_ns(n);
+        for (size_t i = 0; i < n; i++) {
+            const auto start = clock_type::now();
+            dataset.Add(feature, label);
+            add_ns[i] = ElapsedNs(start);
+        }
+
+        const size_t n_sample = g_quick ? 200 : 2000;
+        std::vector<double> sample_ns(n_sample);
+        for (size_t i = 0; i < n_sample; i++) {
+            const auto start = clock_type::now();
+            auto batch = dataset.Sample(true);
+            sample_ns[i] = ElapsedNs(start);
+        }
+
+        const size_t n_evict = g_quick ? 200 : 2000;
+        std::vector<double> evict_ns(n_evict);
+        for (size_t i = 0; i < n_evict; i++) {
+            dataset.SetMaxExamples(nisps::Dataset::kMax_examples);
+            while (dataset.GetLabels().size() < nisps::Dataset::kMax_examples) {
+                dataset.Add(feature, label);
+            }
+            const auto start = clock_type::now();
+            dataset.SetMaxExamples(nisps::Dataset::kMax_examples / 2);
+            evict_ns[i] = ElapsedNs(start);
+        }
+
+        json.Begin("dataset");
+        json.Field("replay_memory", replay ? "on" : "off");
+        json.Field("max_examples", static_cast<double>(nisps::Dataset::kMax_examples));
+        json.Field("add", Summarise(add_ns));
+        json.Field("sample", Summarise(sample_ns));
+        json.Field("evict_half", Summarise(evict_ns));
+        json.End();
+    }
+}
+
+// A sharp 2-D mapping: a wide network on the raw inputs against a narrow
+// one on random Fourier features, trained alike. Inference time of the
+// embedded model includes computing the features.
+void BenchFourierFeatures(Json &json) {
+    auto target = [](float a, float b) {
+        return 0.5f + 0.4f * std::tanh(6.0f * std::sin(5.0f * a) * std::cos(4.0f * b));
+    };
+    nisps::Random rng(6);
+    nisps::MLP<float>::training_pair_t train, test;
+    for (auto *set : {&train, &test}) {
+        for (int i = 0; i < 256; i++) {
+            const float a = rng.Uniform<float>(), b = rng.Uniform<float>();
+            set->first.push_back({a, b});
+            set->second.push_back({target(a, b)});
+        }
+    }
+    auto with_bias = [](std::vector<std::vector<float>> rows) {
+        for (auto &r : rows) {
+            r.push_back(1.0f);
+        }
+        return rows;
+    };
+    nisps::FourierFeatures<float>::Config config;
+    config.num_features = 16;
+    config.bandwidth = 1.0f;
+    nisps::FourierFeatures<float> features(2, config);
+    const int epochs = g_quick ? 200 : 600;
+    const size_t n = g_quick ? 2000 : 20000;
+
+    for (bool embedded : {false, true}) {
+        const size_t width = embedded ? 8 : 32;
+        const size_t n_in = embedded ? features.GetNumOutputs() + 1 : 3;
+        std::vector<size_t> nodes{n_in, width, 1};
+        std::vector<nisps::ACTIVATION_FUNCTIONS> activations{nisps::RELU, nisps::SIGMOID};
+        if (!embedded) {
+            nodes.insert(nodes.begin() + 1, width);
+            activations.insert(activations.begin(), nisps::RELU);
+        }
+        nisps::MLP<float> mlp(nodes, activations, nisps::loss::LOSS_MSE);
+        mlp.SetSeed(2);
+        mlp.InitXavier();
+        const auto train_in = embedded ? features.Transform(train.first, 1) : with_bias(train.first);
+        mlp.TrainBatch({train_in, train.second}, 0.01f, epochs, 16, 0, false);
+
+        double mse = 0;
+        std::vector<float> x(n_in, 1.0f), y;
+        for (size_t i = 0; i < test.first.size(); i++) {
+            const auto &raw = test.first[i];
+            if (embedded) {
+                features.Process(raw, std::span<float>(x).first(n_in - 1));
+            } else {
+                std::copy(raw.begin(), raw.end(), x.begin());
+            }
+            mlp.GetOutput(x, &y);
+            mse += (y[0] - test.second[i][0]) * (y[0] - test.second[i][0]);
+        }
+        mse /= static_cast<double>(test.first.size());
+
+        std::vector<double> ns(n);
+        for (size_t i = 0; i < n; i++) {
+            const auto &raw = test.first[i % test.first.size()];
+            const auto start = clock_type::now();
+            if (embedded) {
+                features.Process(raw, std::span<float>(x).first(n_in - 1));
+            } else {
+                std::copy(raw.begin(), raw.end(), x.begin());
+            }
+            mlp.GetOutput(x, &y);
+            ns[i] = ElapsedNs(start);
+        }
+        json.Begin("fourier_features");
+        json.Field("model", embedded ? "embedded" : "plain");
+        json.Field("topology", TopologyString({"", embedded ? n_in - 1 : 2,
+                                               std::vector<size_t>(nodes.begin() + 1, nodes.end() - 1), 1}));
+        json.Field("type", "float");
+        json.Field("features", embedded ? static_cast<double>(config.num_features) : 0.0);
+        json.Field("bandwidth", embedded ? static_cast<double>(config.bandwidth) : 0.0);
+        json.Field("parameters", static_cast<double>(mlp.GetNumParameters()));
+        json.Field("test_mse", mse);
+        json.Field("latency", Summarise(ns));
+        json.End();
+    }
+}
+
+// Per-tick cost of temporal context: a GRU carrying its state against an
+// MLP fed a window of past frames, for growing windows
+void BenchRecurrent(Json &json) {
+    const size_t features = 8, hidden = 16, outputs = 4;
+    const size_t n = g_quick ? 2000 : 20000;
+    nisps::Random rng(8);
+    std::vector<float> frames(features * 256);
+    rng.FillUniform(std::span<float>(frames), 0.0f, 1.0f);
+    std::vector<double> ns(n);
+    std::vector<float> y(outputs);
+
+    nisps::GRU<float> gru(features, hidden, outputs);
+    for (size_t i = 0; i < n; i++) {
+        const std::span<const float> x(frames.data() + (i % 256) * features, features);
+        const auto start = clock_type::now();
+        gru.Step(x, y);
+        ns[i] = ElapsedNs(start);
+    }
+    json.Begin("recurrent_step");
+    json.Field("model", "gru");
+    json.Field("topology", std::to_string(features) + "-gru" + std::to_string(hidden) + "-" + std::to_string(outputs));
+    json.Field("type", "float");
+    json.Field("window", 0.0);
+    json.Field("parameters", static_cast<double>(gru.GetNumParameters()));
+    json.Field("latency", Summarise(ns));
+    json.End();
+
+    for (size_t window : {size_t(4), size_t(16), size_t(64)}) {
+        const Topology t{"", features * window, {hidden}, outputs};
+        auto mlp = MakeMLP<float>(t);
+        // The window slides one frame per tick
+        std::vector<float> x(features * window + 1, 1.0f), out;
+        for (size_t i = 0; i < n; i++) {
+            const float *frame = frames.data() + (i % 256) * features;
+            const auto start = clock_type::now();
+            std::copy(x.begin() + features, x.end() - 1, x.begin());
+            std::copy_n(frame, features, x.end() - 1 - features);
+            mlp.GetOutput(x, &out);
+            ns[i] = ElapsedNs(start);
+        }
+        json.Begin("recurrent_step");
+        json.Field("model", "windowed_mlp");
+        json.Field("topology", TopologyString(t));
+        json.Field("type", "float");
+        json.Field("window", static_cast<double>(window));
+        json.Field("parameters", static_cast<double>(mlp.GetNumParameters()));
+        json.Field("latency", Summarise(ns));
+        json.End();
+    }
+}
+
+// Per-tick DTW gesture matching as templates are added, with the lower
+// bound cascade and without. The stream replays templates, time-warped,
+// between rests.
+void BenchGestureRecogniser(Json &json) {
+    const size_t dims = 2, length = 32, classes = 6;
+    const size_t n = g_quick ? 1000 : 10000;
+    nisps::Random rng(9);
+    // Smooth random trajectories, one family per class
+    auto curve = [&](size_t c, float phase, size_t frames, float warp) {
+        std::vector<std::vector<float>> out;
+        for (size_t i = 0; i < frames; i++) {
+            const float s = std::pow(static_cast<float>(i) / static_cast<float>(frames - 1), warp);
+            std::vector<float> frame(dims);
+            for (size_t d = 0; d < dims; d++) {
+                frame[d] = 0.5f + 0.3f * std::sin(static_cast<float>(c + 1 + d) * 3.0f * s + phase + static_cast<float>(d));
+            }
+            out.push_back(std::move(frame));
+        }
+        return out;
+    };
+    std::vector<std::vector<float>> stream;
+    while (stream.size() < n) {
+        for (int i = 0; i < 20; i++) {
+            stream.push_back({0.5f + 0.01f * rng.Normal<float>(), 0.5f + 0.01f * rng.Normal<float>()});
+        }
+        const auto gesture = curve(rng.Below(classes), 0.1f * rng.Normal<float>(), 30 + rng.Below(8),
+                                   rng.Uniform<float>(0.9f, 1.1f));
+        stream.insert(stream.end(), gesture.begin(), gesture.end());
+    }
+
+    for (size_t per_class : {size_t(1), size_t(4), size_t(16)}) {
+        for (bool prune : {true, false}) {
+            nisps::GestureRecogniser::Config config;
+            config.template_length = length;
+            config.band = 3;
+            config.reject_distance = 0.01f;
+            config.prune = prune;
+            nisps::GestureRecogniser recogniser(dims, config);
+            for (size_t c = 0; c < classes; c++) {
+                for (size_t k = 0; k < per_class; k++) {
+                    recogniser.AddTemplate(curve(c, 0.1f * rng.Normal<float>(), 40, 1.0f), static_cast<int>(c));
+                }
+            }
+            std::vector<double> ns(n);
+            nisps::GestureMatch match;
+            for (size_t i = 0; i < n; i++) {
+                const auto start = clock_type::now();
+                recogniser.Process(stream[i], &match);
+                ns[i] = ElapsedNs(start);
+            }
+            const auto &stats = recogniser.GetStats();
+            json.Begin("gesture_dtw");
+            json.Field("templates", static_cast<double>(recogniser.GetNumTemplates()));
+            json.Field("template_length", static_cast<double>(length));
+            json.Field("band", static_cast<double>(config.band));
+            json.Field("prune", prune ? "on" : "off");
+            json.Field("full_dtw_fraction", static_cast<double>(stats.full) / static_cast<double>(stats.candidates));
+            json.Field("latency", Summarise(ns));
+            json.End();
+        }
+    }
+}
+
+template<typename T>
+void BenchType(Json &json) {
+    for (const auto &t : kTopologies) {
+        std::cerr << "  " << TypeName<T>() << " " << t.name << "\n";
+        BenchGetOutput<T>(json, t);
+        BenchTrainThroughput<T>(json, t);
+        BenchConvergence<T>(json, t);
+        BenchSerialisation<T>(json, t);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            g_quick = true;
+        } else {
+            output = argv[i];
+        }
+    }
+
+    std::cerr << "=== nisps_bench" << (g_quick ? " (quick)" : "") << " ===\n";
+    Json json;
+    BenchType<float>(json);
+    BenchType<double>(json);
+    // IML and Dataset are float-only
+    for (const auto &t : kTopologies) {
+        BenchIMLProcess(json, t);
+    }
+    BenchDataset(json);
+    BenchFourierFeatures(json);
+    BenchRecurrent(json);
+    BenchGestureRecogniser(json);
+
+    if (output) {
+        std::ofstream file(output);
+        file << json.Str();
+        if (!file) {
+            std::cerr << "Could not write " << output << "\n";
+            return 1;
+        }
+        std::cerr << "Wrote " << output << "\n";
+    } else {
+        std::cout << json.Str();
+    }
+    return 0;
+}
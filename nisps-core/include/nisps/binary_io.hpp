@@ -0,0 +1,183 @@
+/**
+ * @file binary_io.hpp
+ * @brief Fixed-width little-endian encoding helpers for NISPS binary file formats
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_BINARY_IO_HPP
+#define NISPS_BINARY_IO_HPP
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace nisps {
+
+/**
+ * @namespace binary_io
+ * @brief Helpers for reading and writing fixed-width little-endian fields.
+ *
+ * All on-disk NISPS formats are little-endian regardless of the host, so
+ * files written on the host can be read on the device and vice versa.
+ */
+namespace binary_io {
+
+/**
+ * @brief True when the host stores scalars in little-endian order, in which
+ * case encoded arrays can be used in place without conversion.
+ */
+inline constexpr bool kHostIsLittleEndian = (std::endian::native == std::endian::little);
+
+/**
+ * @brief Reverses the byte order of an unsigned integer.
+ * @tparam U Unsigned integer type
+ * @param v Value to swap
+ * @return Byte-swapped value
+ */
+template<typename U>
+inline U ByteSwap(U v) {
+    static_assert(std::is_unsigned_v<U>, "ByteSwap requires an unsigned type");
+    U r = 0;
+    for (size_t i = 0; i < sizeof(U); i++) {
+        r = static_cast<U>((r << 8) | (v & 0xFF));
+        v = static_cast<U>(v >> 8);
+    }
+    return r;
+}
+
+/**
+ * @brief Unsigned integer of the same width as T, used to move scalars bitwise.
+ */
+template<typename T>
+using bits_t = std::conditional_t<sizeof(T) == 1, uint8_t,
+               std::conditional_t<sizeof(T) == 2, uint16_t,
+               std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+/**
+ * @brief Stores a trivially copyable scalar at dst in little-endian order.
+ * @tparam T Scalar type (integer, enum or floating point)
+ * @param dst Destination, at least sizeof(T) bytes
+ * @param value Value to store
+ */
+template<typename T>
+inline void Store(uint8_t *dst, T value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Store requires a trivially copyable type");
+    bits_t<T> bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    if constexpr (!kHostIsLittleEndian) {
+        bits = ByteSwap(bits);
+    }
+    std::memcpy(dst, &bits, sizeof(T));
+}
+
+/**
+ * @brief Loads a little-endian scalar from src.
+ * @tparam T Scalar type (integer, enum or floating point)
+ * @param src Source, at least sizeof(T) bytes
+ * @return Decoded value
+ */
+template<typename T>
+inline T Load(const uint8_t *src) {
+    static_assert(std::is_trivially_copyable_v<T>, "Load requires a trivially copyable type");
+    bits_t<T> bits;
+    std::memcpy(&bits, src, sizeof(T));
+    if constexpr (!kHostIsLittleEndian) {
+        bits = ByteSwap(bits);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Stores an array of scalars in little-endian order.
+ *
+ * On little-endian hosts this is a single memcpy.
+ *
+ * @param dst Destination, at least n * sizeof(T) bytes
+ * @param src Source array
+ * @param n Number of elements
+ */
+template<typename T>
+inline void StoreArray(uint8_t *dst, const T *src, size_t n) {
+    if constexpr (kHostIsLittleEndian) {
+        if (n) std::memcpy(dst, src, n * sizeof(T));
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            Store<T>(dst + i * sizeof(T), src[i]);
+        }
+    }
+}
+
+/**
+ * @brief Loads an array of little-endian scalars.
+ *
+ * On little-endian hosts this is a single memcpy.
+ *
+ * @param dst Destination array
+ * @param src Source, at least n * sizeof(T) bytes
+ * @param n Number of elements
+ */
+template<typename T>
+inline void LoadArray(T *dst, const uint8_t *src, size_t n) {
+    if constexpr (kHostIsLittleEndian) {
+        if (n) std::memcpy(dst, src, n * sizeof(T));
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = Load<T>(src + i * sizeof(T));
+        }
+    }
+}
+
+/**
+ * @brief Rounds an offset up to the next multiple of alignment (a power of two).
+ */
+inline constexpr size_t AlignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Lookup table for the reflected CRC-32 polynomial 0xEDB88320.
+ */
+struct Crc32Table {
+    uint32_t entries[256];
+    constexpr Crc32Table() : entries() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+inline constexpr Crc32Table kCrc32Table{};
+
+/**
+ * @brief Computes the CRC-32 (as used by zlib and PNG) of a byte range.
+ *
+ * @param data Bytes to checksum
+ * @param size Number of bytes
+ * @param crc Running CRC from a previous call, to checksum data in pieces
+ * @return Updated CRC
+ */
+inline uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = kCrc32Table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+}  // namespace binary_io
+
+}  // namespace nisps
+
+#endif  // NISPS_BINARY_IO_HPP
@@ -0,0 +1,276 @@
+/**
+ * @file codegen.hpp
+ * @brief Exports a trained network as a self-contained C++ header
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * The generated header needs only <cmath> and <cstddef>. Each layer's
+ * weights are a constexpr row-major array and its biases a second one, so
+ * they are placed in read-only memory (flash on a microcontroller). The
+ * forward function is unrolled for the exact topology: one statement per
+ * unit, bias and multiply-accumulates and activation in one expression,
+ * with constant indices the compiler can fold into immediate loads.
+ * Nothing is read from a file and nothing is allocated at boot.
+ */
+
+#ifndef NISPS_CODEGEN_HPP
+#define NISPS_CODEGEN_HPP
+
+#include "mlp.hpp"
+
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cctype>
+#include <type_traits>
+
+namespace nisps {
+
+/**
+ * @brief Settings for GenerateHeader().
+ */
+struct CodegenOptions {
+    std::string name = "Model";                  /**< Name of the generated struct */
+    std::string name_space = "nisps_model";      /**< Namespace around it; empty for none */
+    std::string source;                          /**< Recorded in the header comment, e.g. the model file */
+    bool fast_activations = false;               /**< Rational tanh and sigmoid instead of std::exp / std::tanh */
+};
+
+namespace codegen {
+
+/**
+ * @brief A literal that reads back to the same value, e.g. "-0.25f" or "1.0f".
+ */
+template<typename T>
+std::string Literal(T value) {
+    char text[40];
+    std::snprintf(text, sizeof(text), std::is_same_v<T, float> ? "%.9g" : "%.17g", static_cast<double>(value));
+    std::string s(text);
+    if (s.find_first_of(".e") == std::string::npos) {
+        s += ".0";
+    }
+    if (std::is_same_v<T, float>) {
+        s += 'f';
+    }
+    return s;
+}
+
+inline const char *ActivationCall(ACTIVATION_FUNCTIONS activation) {
+    switch (activation) {
+        case SIGMOID: return "Sigmoid";
+        case TANH: return "Tanh";
+        case RELU: return "Relu";
+        case HARDSIGMOID: return "HardSigmoid";
+        case HARDSWISH: return "HardSwish";
+        case HARDTANH: return "HardTanh";
+        case LINEAR: return "";
+    }
+    return nullptr;
+}
+
+inline const char *ActivationName(ACTIVATION_FUNCTIONS activation) {
+    switch (activation) {
+        case SIGMOID: return "SIGMOID";
+        case TANH: return "TANH";
+        case RELU: return "RELU";
+        case HARDSIGMOID: return "HARDSIGMOID";
+        case HARDSWISH: return "HARDSWISH";
+        case HARDTANH: return "HARDTANH";
+        case LINEAR: return "LINEAR";
+    }
+    return "?";
+}
+
+}  // namespace codegen
+
+/**
+ * @brief Writes a header evaluating the network with an unrolled forward function.
+ *
+ * The struct has kNumInputs, kNumOutputs and kNumParameters, and
+ * Process(const T *x, T *y) with the same outputs as GetOutput() for
+ * inference, softmax included. Inputs include the bias input if the
+ * network was trained with one.
+ *
+ * @param mlp Network to export
+ * @param options Names and activation variant
+ * @param header Receives the header text
+ * @return false if the network is empty or has a non-finite parameter
+ */
+template<typename T>
+bool GenerateHeader(const MLP<T> &mlp, const CodegenOptions &options, std::string *header) {
+    using codegen::Literal;
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "Exports float or double networks");
+    const char *scalar = std::is_same_v<T, float> ? "float" : "double";
+    const auto &layers = mlp.m_layers;
+    if (layers.empty() || mlp.get_num_inputs() == 0) {
+        return false;
+    }
+    const size_t n_in = static_cast<size_t>(mlp.get_num_inputs());
+    const size_t n_out = static_cast<size_t>(mlp.get_num_outputs());
+    const bool softmax = mlp.GetLossFunctionType() == loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY &&
+                         n_out > 1;
+
+    std::string s;
+    auto line = [&](const std::string &text) {
+        s += text;
+        s += '\n';
+    };
+    std::string guard = (options.name_space.empty() ? "" : options.name_space + "_") + options.name + "_HPP";
+    for (auto &ch : guard) {
+        ch = std::isalnum(static_cast<unsigned char>(ch)) ? static_cast<char>(std::toupper(ch)) : '_';
+    }
+
+    line("// Generated by nisps-export" + (options.source.empty() ? std::string() : " from " + options.source) +
+         ". Do not edit.");
+    std::string topology = "// Topology: " + std::to_string(n_in);
+    for (const auto &layer : layers) {
+        topology += " -> " + std::to_string(layer.GetOutputSize()) + " " +
+                    codegen::ActivationName(layer.GetActivationFunctionType());
+    }
+    line(topology + (softmax ? ", softmax" : "") +
+         (options.fast_activations ? ", fast activations" : ""));
+    line("");
+    line("#ifndef " + guard);
+    line("#define " + guard);
+    line("");
+    line("#include <cmath>");
+    line("#include <cstddef>");
+    line("");
+    if (!options.name_space.empty()) {
+        line("namespace " + options.name_space + " {");
+        line("");
+    }
+    line("struct " + options.name + " {");
+    line(std::string("    using scalar_t = ") + scalar + ";");
+    line("    static constexpr std::size_t kNumInputs = " + std::to_string(n_in) + ";");
+    line("    static constexpr std::size_t kNumOutputs = " + std::to_string(n_out) + ";");
+    line("    static constexpr std::size_t kNumParameters = " + std::to_string(mlp.GetNumParameters()) + ";");
+    line("");
+
+    // Weights and biases, one row per unit
+    for (size_t l = 0; l < layers.size(); l++) {
+        const auto &nodes = layers[l].m_nodes;
+        const size_t cols = layers[l].m_num_inputs_per_node;
+        const std::string id = std::to_string(l);
+        line("    static constexpr scalar_t kW" + id + "[" + std::to_string(nodes.size() * cols) + "] = {");
+        for (const auto &node : nodes) {
+            std::string row = "       ";
+            for (size_t c = 0; c < cols; c++) {
+                if (!std::isfinite(node.m_weights[c])) {
+                    return false;
+                }
+                row += " " + Literal(node.m_weights[c]) + ",";
+            }
+            line(row);
+        }
+        line("    };");
+        std::string biases = "    static constexpr scalar_t kB" + id + "[" + std::to_string(nodes.size()) + "] = {";
+        for (size_t r = 0; r < nodes.size(); r++) {
+            if (!std::isfinite(nodes[r].m_bias)) {
+                return false;
+            }
+            biases += (r ? ", " : "") + Literal(nodes[r].m_bias);
+        }
+        line(biases + "};");
+    }
+    line("");
+
+    // Activations; only those the network uses are emitted
+    bool used[HARDTANH + 1] = {};
+    for (const auto &layer : layers) {
+        used[layer.GetActivationFunctionType()] = true;
+    }
+    const std::string one = Literal(static_cast<T>(1)), zero = Literal(static_cast<T>(0));
+    const std::string three = Literal(static_cast<T>(3)), sixth = Literal(static_cast<T>(1) / static_cast<T>(6));
+    const std::string half = Literal(static_cast<T>(0.5));
+    if (options.fast_activations && (used[TANH] || used[SIGMOID])) {
+        // Pade approximant, exact at 0 and clamped to +-1 from |x| = 3; error below 0.025
+        line("    static inline scalar_t Tanh(scalar_t v) {");
+        line("        if (v <= -" + three + ") return -" + one + ";");
+        line("        if (v >= " + three + ") return " + one + ";");
+        line("        const scalar_t v2 = v * v;");
+        line("        return v * (" + Literal(static_cast<T>(27)) + " + v2) / (" + Literal(static_cast<T>(27)) +
+             " + " + Literal(static_cast<T>(9)) + " * v2);");
+        line("    }");
+        if (used[SIGMOID]) {
+            line("    static inline scalar_t Sigmoid(scalar_t v) { return " + half + " + " + half + " * Tanh(" + half +
+                 " * v); }");
+        }
+    } else {
+        if (used[TANH]) {
+            line("    static inline scalar_t Tanh(scalar_t v) { return std::tanh(v); }");
+        }
+        if (used[SIGMOID]) {
+            line("    static inline scalar_t Sigmoid(scalar_t v) { return " + one + " / (" + one +
+                 " + std::exp(-v)); }");
+        }
+    }
+    if (used[RELU]) {
+        line("    static inline scalar_t Relu(scalar_t v) { return v > " + zero + " ? v : " +
+             Literal(static_cast<T>(utils::kReLUSlope)) + " * v; }");
+    }
+    if (used[HARDSIGMOID]) {
+        line("    static inline scalar_t HardSigmoid(scalar_t v) {");
+        line("        return v <= -" + three + " ? " + zero + " : v >= " + three + " ? " + one + " : (v + " + three +
+             ") * " + sixth + ";");
+        line("    }");
+    }
+    if (used[HARDSWISH]) {
+        line("    static inline scalar_t HardSwish(scalar_t v) {");
+        line("        return v <= -" + three + " ? " + zero + " : v >= " + three + " ? v : v * (v + " + three +
+             ") / " + Literal(static_cast<T>(6)) + ";");
+        line("    }");
+    }
+    if (used[HARDTANH]) {
+        line("    static inline scalar_t HardTanh(scalar_t v) { return v <= -" + one + " ? -" + one + " : v >= " +
+             one + " ? " + one + " : v; }");
+    }
+    line("");
+
+    // Forward pass, one statement per unit
+    line("    static void Process(const scalar_t *x, scalar_t *y) {");
+    for (size_t l = 0; l < layers.size(); l++) {
+        const size_t rows = static_cast<size_t>(layers[l].GetOutputSize());
+        const size_t cols = layers[l].m_num_inputs_per_node;
+        const std::string id = std::to_string(l);
+        const bool last = l + 1 == layers.size();
+        const std::string in = l == 0 ? "x" : "h" + std::to_string(l - 1);
+        const std::string out = last ? "y" : "h" + id;
+        const std::string call = codegen::ActivationCall(layers[l].GetActivationFunctionType());
+        if (!last) {
+            line("        scalar_t " + out + "[" + std::to_string(rows) + "];");
+        }
+        for (size_t r = 0; r < rows; r++) {
+            std::string expr = "kB" + id + "[" + std::to_string(r) + "]";
+            for (size_t c = 0; c < cols; c++) {
+                expr += " + kW" + id + "[" + std::to_string(r * cols + c) + "] * " + in + "[" + std::to_string(c) +
+                        "]";
+            }
+            line("        " + out + "[" + std::to_string(r) + "] = " + call + "(" + expr + ");");
+        }
+    }
+    if (softmax) {
+        line("        scalar_t peak = y[0];");
+        line("        for (std::size_t k = 1; k < kNumOutputs; k++) peak = y[k] > peak ? y[k] : peak;");
+        line("        scalar_t total = " + zero + ";");
+        line("        for (std::size_t k = 0; k < kNumOutputs; k++) total += (y[k] = std::exp(y[k] - peak));");
+        line("        for (std::size_t k = 0; k < kNumOutputs; k++) y[k] /= total;");
+    }
+    line("    }");
+    line("};");
+    if (!options.name_space.empty()) {
+        line("");
+        line("}  // namespace " + options.name_space);
+    }
+    line("");
+    line("#endif  // " + guard);
+    *header = std::move(s);
+    return true;
+}
+
+}  // namespace nisps
+
+#endif  // NISPS_CODEGEN_HPP
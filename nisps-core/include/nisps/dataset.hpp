@@ -18,6 +18,8 @@
 #include <random>
 #include <algorithm>
 
+#include "profile.hpp"
+
 namespace nisps {
 
 /**
@@ -0,0 +1,680 @@
+/**
+ * @file dataset_file.hpp
+ * @brief On-disk binary dataset format, memory-mapped reader and streaming mini-batch loader
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * File layout (all fields little-endian):
+ *
+ *   offset  size  field
+ *   0       4     magic "NSDS"
+ *   4       2     format version
+ *   6       2     header size in bytes (32)
+ *   8       4     feature dimension
+ *   12      4     label dimension
+ *   16      8     number of rows (advisory, rewritten on Flush())
+ *   24      8     reserved, zero
+ *   32      ...   rows: feature_dim float32 values, then label_dim float32 values
+ *
+ * Readers derive the row count from the file size, so rows appended by a
+ * recorder that crashed before its last Flush() are still recovered. A
+ * trailing partial row is ignored and overwritten by the next append.
+ */
+
+#ifndef NISPS_DATASET_FILE_HPP
+#define NISPS_DATASET_FILE_HPP
+
+#include "binary_io.hpp"
+#include "dataset.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <span>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NISPS_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace nisps {
+
+/**
+ * @brief Constants describing the binary dataset file header.
+ */
+struct DatasetFileFormat {
+    static constexpr char kMagic[4] = {'N', 'S', 'D', 'S'};
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 32;
+
+    /**
+     * @brief Encodes a header into a kHeaderSize byte buffer.
+     */
+    static void EncodeHeader(uint8_t *dst, size_t feature_size, size_t label_size, size_t num_rows) {
+        std::memset(dst, 0, kHeaderSize);
+        std::memcpy(dst, kMagic, sizeof(kMagic));
+        binary_io::Store<uint16_t>(dst + 4, kVersion);
+        binary_io::Store<uint16_t>(dst + 6, static_cast<uint16_t>(kHeaderSize));
+        binary_io::Store<uint32_t>(dst + 8, static_cast<uint32_t>(feature_size));
+        binary_io::Store<uint32_t>(dst + 12, static_cast<uint32_t>(label_size));
+        binary_io::Store<uint64_t>(dst + 16, static_cast<uint64_t>(num_rows));
+    }
+
+    /**
+     * @brief Validates and decodes a header.
+     * @return true if the magic, version and dimensions are valid
+     */
+    static bool DecodeHeader(const uint8_t *src, size_t &feature_size, size_t &label_size) {
+        if (std::memcmp(src, kMagic, sizeof(kMagic)) != 0) {
+            return false;
+        }
+        if (binary_io::Load<uint16_t>(src + 4) != kVersion ||
+            binary_io::Load<uint16_t>(src + 6) != kHeaderSize) {
+            return false;
+        }
+        feature_size = binary_io::Load<uint32_t>(src + 8);
+        label_size = binary_io::Load<uint32_t>(src + 12);
+        return (feature_size + label_size) > 0;
+    }
+};
+
+/**
+ * @brief Appends feature-label rows to a binary dataset file while recording.
+ *
+ * Rows are buffered by stdio; call Flush() periodically to push them to disk
+ * and update the row count in the header.
+ */
+class DatasetFileWriter {
+ public:
+    DatasetFileWriter() = default;
+    ~DatasetFileWriter() { Close(); }
+
+    DatasetFileWriter(const DatasetFileWriter &) = delete;
+    DatasetFileWriter &operator=(const DatasetFileWriter &) = delete;
+
+    /**
+     * @brief Opens a dataset file for appending, creating it if it does not exist.
+     *
+     * @param filename Path to the dataset file
+     * @param feature_size Number of features per row
+     * @param label_size Number of labels per row
+     * @return false if the file cannot be opened, or exists with different dimensions
+     */
+    bool Open(const std::string &filename, size_t feature_size, size_t label_size) {
+        Close();
+        if (feature_size + label_size == 0) {
+            return false;
+        }
+        feature_size_ = feature_size;
+        label_size_ = label_size;
+        row_buffer_.resize((feature_size + label_size) * sizeof(float));
+
+        uint8_t header[DatasetFileFormat::kHeaderSize];
+        file_ = fopen(filename.c_str(), "r+b");
+        if (file_) {
+            size_t file_features = 0, file_labels = 0;
+            if (fread(header, sizeof(header), 1, file_) != 1 ||
+                !DatasetFileFormat::DecodeHeader(header, file_features, file_labels) ||
+                file_features != feature_size || file_labels != label_size) {
+                Abort();
+                return false;
+            }
+            if (fseek(file_, 0, SEEK_END) != 0) {
+                Abort();
+                return false;
+            }
+            long file_size = ftell(file_);
+            if (file_size < static_cast<long>(DatasetFileFormat::kHeaderSize)) {
+                Abort();
+                return false;
+            }
+            num_rows_ = (static_cast<size_t>(file_size) - DatasetFileFormat::kHeaderSize) /
+                        row_buffer_.size();
+            // Drop any partial row left by an interrupted append
+            if (fseek(file_, static_cast<long>(RowOffset(num_rows_)), SEEK_SET) != 0) {
+                Abort();
+                return false;
+            }
+        } else {
+            file_ = fopen(filename.c_str(), "w+b");
+            if (!file_) {
+                return false;
+            }
+            num_rows_ = 0;
+            DatasetFileFormat::EncodeHeader(header, feature_size_, label_size_, 0);
+            if (fwrite(header, sizeof(header), 1, file_) != 1) {
+                Abort();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Appends one row.
+     *
+     * @param feature Pointer to feature_size values
+     * @param label Pointer to label_size values
+     * @return true if the row was written
+     */
+    bool Append(const float *feature, const float *label) {
+        if (!file_) {
+            return false;
+        }
+        uint8_t *dst = row_buffer_.data();
+        binary_io::StoreArray(dst, feature, feature_size_);
+        binary_io::StoreArray(dst + feature_size_ * sizeof(float), label, label_size_);
+        if (fwrite(dst, row_buffer_.size(), 1, file_) != 1) {
+            return false;
+        }
+        num_rows_++;
+        return true;
+    }
+
+    /**
+     * @brief Appends one row from vectors, checking their dimensions.
+     */
+    bool Append(const std::vector<float> &feature, const std::vector<float> &label) {
+        if (feature.size() != feature_size_ || label.size() != label_size_) {
+            return false;
+        }
+        return Append(feature.data(), label.data());
+    }
+
+    /**
+     * @brief Writes buffered rows and updates the header row count.
+     * @return true on success
+     */
+    bool Flush() {
+        if (!file_) {
+            return false;
+        }
+        uint8_t header[DatasetFileFormat::kHeaderSize];
+        DatasetFileFormat::EncodeHeader(header, feature_size_, label_size_, num_rows_);
+        bool ok = fseek(file_, 0, SEEK_SET) == 0 &&
+                  fwrite(header, sizeof(header), 1, file_) == 1 &&
+                  fseek(file_, static_cast<long>(RowOffset(num_rows_)), SEEK_SET) == 0 &&
+                  fflush(file_) == 0;
+        return ok;
+    }
+
+    /**
+     * @brief Flushes and closes the file.
+     */
+    void Close() {
+        if (file_) {
+            Flush();
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    bool IsOpen() const { return file_ != nullptr; }
+    size_t GetNumRows() const { return num_rows_; }
+
+ private:
+    /**
+     * @brief Closes the file without touching the header, used when Open() fails.
+     */
+    void Abort() {
+        if (file_) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    size_t RowOffset(size_t row) const {
+        return DatasetFileFormat::kHeaderSize + row * row_buffer_.size();
+    }
+
+    FILE *file_ = nullptr;
+    size_t feature_size_ = 0;
+    size_t label_size_ = 0;
+    size_t num_rows_ = 0;
+    std::vector<uint8_t> row_buffer_;
+};
+
+/**
+ * @brief Read-only view of a binary dataset file.
+ *
+ * On POSIX little-endian hosts the file is memory-mapped and rows are
+ * accessed in place; elsewhere it is read into memory in a single call.
+ */
+class DatasetFile {
+ public:
+    DatasetFile() = default;
+    ~DatasetFile() { Close(); }
+
+    DatasetFile(const DatasetFile &) = delete;
+    DatasetFile &operator=(const DatasetFile &) = delete;
+
+    /**
+     * @brief Opens and validates a dataset file.
+     * @param filename Path to the dataset file
+     * @return false if the file is missing or not a valid dataset file
+     */
+    bool Open(const std::string &filename) {
+        Close();
+#if defined(NISPS_HAVE_MMAP)
+        if constexpr (binary_io::kHostIsLittleEndian) {
+            return OpenMapped(filename);
+        }
+#endif
+        return OpenBuffered(filename);
+    }
+
+    /**
+     * @brief Releases the mapping or buffer.
+     */
+    void Close() {
+#if defined(NISPS_HAVE_MMAP)
+        if (map_base_) {
+            munmap(map_base_, map_size_);
+            map_base_ = nullptr;
+            map_size_ = 0;
+        }
+#endif
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+        rows_ = nullptr;
+        num_rows_ = 0;
+        feature_size_ = 0;
+        label_size_ = 0;
+        row_size_ = 0;
+    }
+
+    bool IsOpen() const { return row_size_ > 0; }
+    size_t GetNumRows() const { return num_rows_; }
+    size_t GetFeatureSize() const { return feature_size_; }
+    size_t GetOutputSize() const { return label_size_; }
+
+    /**
+     * @brief Returns the features of a row.
+     */
+    std::span<const float> Feature(size_t row) const {
+        return { rows_ + row * row_size_, feature_size_ };
+    }
+
+    /**
+     * @brief Returns the labels of a row.
+     */
+    std::span<const float> Label(size_t row) const {
+        return { rows_ + row * row_size_ + feature_size_, label_size_ };
+    }
+
+ private:
+#if defined(NISPS_HAVE_MMAP)
+    bool OpenMapped(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(DatasetFileFormat::kHeaderSize)) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void *base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        map_base_ = base;
+        map_size_ = size;
+        const uint8_t *bytes = static_cast<const uint8_t *>(base);
+        if (!SetLayout(bytes, size)) {
+            Close();
+            return false;
+        }
+        rows_ = reinterpret_cast<const float *>(bytes + DatasetFileFormat::kHeaderSize);
+        madvise(base, size, MADV_SEQUENTIAL);
+        return true;
+    }
+#endif
+
+    bool OpenBuffered(const std::string &filename) {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        std::vector<uint8_t> bytes;
+        bool ok = fseek(file, 0, SEEK_END) == 0;
+        long size = ok ? ftell(file) : -1;
+        ok = ok && size >= static_cast<long>(DatasetFileFormat::kHeaderSize) &&
+             fseek(file, 0, SEEK_SET) == 0;
+        if (ok) {
+            bytes.resize(static_cast<size_t>(size));
+            ok = fread(bytes.data(), bytes.size(), 1, file) == 1;
+        }
+        fclose(file);
+        if (!ok || !SetLayout(bytes.data(), bytes.size())) {
+            Close();
+            return false;
+        }
+        buffer_.resize(num_rows_ * row_size_);
+        binary_io::LoadArray(buffer_.data(), bytes.data() + DatasetFileFormat::kHeaderSize,
+                             buffer_.size());
+        rows_ = buffer_.data();
+        return true;
+    }
+
+    bool SetLayout(const uint8_t *bytes, size_t size) {
+        if (!DatasetFileFormat::DecodeHeader(bytes, feature_size_, label_size_)) {
+            return false;
+        }
+        row_size_ = feature_size_ + label_size_;
+        num_rows_ = (size - DatasetFileFormat::kHeaderSize) / (row_size_ * sizeof(float));
+        return true;
+    }
+
+    const float *rows_ = nullptr;
+    size_t num_rows_ = 0;
+    size_t feature_size_ = 0;
+    size_t label_size_ = 0;
+    size_t row_size_ = 0;
+    std::vector<float> buffer_;
+#if defined(NISPS_HAVE_MMAP)
+    void *map_base_ = nullptr;
+    size_t map_size_ = 0;
+#endif
+};
+
+/**
+ * @brief Writes the contents of a Dataset to a new binary dataset file.
+ *
+ * @param dataset Dataset to save
+ * @param filename Path to the file, which is overwritten
+ * @return true on success
+ */
+inline bool SaveDatasetFile(Dataset &dataset, const std::string &filename) {
+    Dataset::DatasetVector *features, *labels;
+    dataset.Fetch(features, labels);
+    std::remove(filename.c_str());
+    DatasetFileWriter writer;
+    if (!writer.Open(filename, dataset.GetFeatureSize(false), dataset.GetOutputSize())) {
+        return false;
+    }
+    for (size_t i = 0; i < features->size(); i++) {
+        if (!writer.Append((*features)[i], (*labels)[i])) {
+            return false;
+        }
+    }
+    return writer.Flush();
+}
+
+/**
+ * @brief Loads a binary dataset file into a Dataset, replacing its contents.
+ *
+ * Intended for small recordings; use DatasetFile and MiniBatchLoader to
+ * stream large ones.
+ *
+ * @param filename Path to the dataset file
+ * @param dataset Dataset to load into
+ * @return true on success
+ */
+inline bool LoadDatasetFile(const std::string &filename, Dataset &dataset) {
+    DatasetFile file;
+    if (!file.Open(filename)) {
+        return false;
+    }
+    Dataset::DatasetVector features(file.GetNumRows()), labels(file.GetNumRows());
+    for (size_t i = 0; i < file.GetNumRows(); i++) {
+        auto f = file.Feature(i);
+        auto l = file.Label(i);
+        features[i].assign(f.begin(), f.end());
+        labels[i].assign(l.begin(), l.end());
+    }
+    dataset.Load(features, labels);
+    return true;
+}
+
+/**
+ * @brief Streams shuffled mini-batches from a DatasetFile with background prefetching.
+ *
+ * Each epoch visits every row once. Rows are grouped into blocks of
+ * consecutive rows; block order is shuffled and rows are shuffled within
+ * each block, which keeps page access local on memory-mapped files while
+ * still decorrelating consecutive batches. A worker thread prepares the
+ * next batches while the caller trains on the current one.
+ */
+class MiniBatchLoader {
+ public:
+    /**
+     * @brief A mini-batch of rows copied out of the dataset file.
+     */
+    struct Batch {
+        std::vector<float> features; /**< num_rows * feature_size values, row-major */
+        std::vector<float> labels;   /**< num_rows * label_size values, row-major */
+        size_t num_rows = 0;
+        size_t feature_size = 0;
+        size_t label_size = 0;
+
+        std::span<const float> Feature(size_t row) const {
+            return { features.data() + row * feature_size, feature_size };
+        }
+        std::span<const float> Label(size_t row) const {
+            return { labels.data() + row * label_size, label_size };
+        }
+
+        /**
+         * @brief Copies the batch into nested vectors for MLP::TrainBatch().
+         *
+         * The destination vectors are reused, so repeated calls with the
+         * same batch size do not allocate.
+         *
+         * @param out_features Feature vectors, resized to num_rows
+         * @param out_labels Label vectors, resized to num_rows
+         * @param with_bias If true, appends a bias term (1.0f) to each feature vector
+         */
+        void CopyTo(Dataset::DatasetVector &out_features,
+                    Dataset::DatasetVector &out_labels,
+                    bool with_bias = true) const {
+            out_features.resize(num_rows);
+            out_labels.resize(num_rows);
+            for (size_t i = 0; i < num_rows; i++) {
+                auto f = Feature(i);
+                auto l = Label(i);
+                out_features[i].assign(f.begin(), f.end());
+                if (with_bias) {
+                    out_features[i].push_back(1.f);
+                }
+                out_labels[i].assign(l.begin(), l.end());
+            }
+        }
+    };
+
+    /**
+     * @brief Constructs a loader over an open dataset file.
+     *
+     * @param file Dataset file; must outlive the loader
+     * @param batch_size Rows per batch (the last batch of an epoch may be smaller)
+     * @param block_size Rows per shuffle block
+     * @param prefetch_depth Number of batches prepared ahead of the caller
+     * @param seed Shuffle seed
+     */
+    MiniBatchLoader(const DatasetFile &file,
+                    size_t batch_size,
+                    size_t block_size = 4096,
+                    size_t prefetch_depth = 2,
+                    uint32_t seed = std::random_device{}())
+        : file_(file),
+          batch_size_(std::max<size_t>(batch_size, 1)),
+          block_size_(std::max<size_t>(block_size, 1)),
+          slots_(std::max<size_t>(prefetch_depth, 1)),
+          rng_(seed) {}
+
+    ~MiniBatchLoader() { Stop(); }
+
+    MiniBatchLoader(const MiniBatchLoader &) = delete;
+    MiniBatchLoader &operator=(const MiniBatchLoader &) = delete;
+
+    /**
+     * @brief Returns the number of batches in one epoch.
+     */
+    size_t GetBatchesPerEpoch() const {
+        return (file_.GetNumRows() + batch_size_ - 1) / batch_size_;
+    }
+
+    /**
+     * @brief Retrieves the next batch of the current epoch.
+     *
+     * The batch buffers are swapped with an internal slot, so passing the
+     * same Batch object each call avoids allocation after the first epoch.
+     * After returning false, the next call starts a new, reshuffled epoch.
+     *
+     * @param batch Receives the batch
+     * @return false when the epoch is exhausted
+     */
+    bool Next(Batch &batch) {
+        if (!worker_.joinable()) {
+            Start();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !ready_.empty(); });
+        size_t slot = ready_.front();
+        ready_.pop_front();
+        bool end_of_epoch = (slots_[slot].num_rows == 0);
+        if (!end_of_epoch) {
+            std::swap(batch.features, slots_[slot].features);
+            std::swap(batch.labels, slots_[slot].labels);
+            batch.num_rows = slots_[slot].num_rows;
+            batch.feature_size = slots_[slot].feature_size;
+            batch.label_size = slots_[slot].label_size;
+        }
+        free_.push_back(slot);
+        lock.unlock();
+        cv_.notify_all();
+        if (end_of_epoch) {
+            Stop();
+        }
+        return !end_of_epoch;
+    }
+
+    /**
+     * @brief Abandons the current epoch; the next call to Next() starts a new one.
+     */
+    void Reset() { Stop(); }
+
+ private:
+    void Start() {
+        ready_.clear();
+        free_.clear();
+        for (size_t i = 0; i < slots_.size(); i++) {
+            free_.push_back(i);
+        }
+        stop_ = false;
+        worker_ = std::thread(&MiniBatchLoader::Produce, this);
+    }
+
+    void Stop() {
+        if (worker_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            worker_.join();
+        }
+    }
+
+    /**
+     * @brief Worker: fills free slots in shuffled-block order until the epoch ends.
+     */
+    void Produce() {
+        const size_t n_rows = file_.GetNumRows();
+        const size_t n_blocks = (n_rows + block_size_ - 1) / block_size_;
+        std::vector<size_t> block_order(n_blocks);
+        std::iota(block_order.begin(), block_order.end(), 0);
+        std::shuffle(block_order.begin(), block_order.end(), rng_);
+
+        std::vector<size_t> rows_in_block;
+        size_t block_i = 0, row_i = 0;
+        auto next_row = [&](size_t &row) {
+            while (row_i >= rows_in_block.size()) {
+                if (block_i >= n_blocks) {
+                    return false;
+                }
+                size_t first = block_order[block_i++] * block_size_;
+                size_t last = std::min(first + block_size_, n_rows);
+                rows_in_block.resize(last - first);
+                std::iota(rows_in_block.begin(), rows_in_block.end(), first);
+                std::shuffle(rows_in_block.begin(), rows_in_block.end(), rng_);
+                row_i = 0;
+            }
+            row = rows_in_block[row_i++];
+            return true;
+        };
+
+        const size_t fs = file_.GetFeatureSize();
+        const size_t ls = file_.GetOutputSize();
+        bool done = false;
+        while (!done) {
+            size_t slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !free_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                slot = free_.front();
+                free_.pop_front();
+            }
+            Batch &b = slots_[slot];
+            b.feature_size = fs;
+            b.label_size = ls;
+            b.features.resize(batch_size_ * fs);
+            b.labels.resize(batch_size_ * ls);
+            b.num_rows = 0;
+            size_t row;
+            while (b.num_rows < batch_size_ && next_row(row)) {
+                auto f = file_.Feature(row);
+                auto l = file_.Label(row);
+                std::copy(f.begin(), f.end(), b.features.begin() + b.num_rows * fs);
+                std::copy(l.begin(), l.end(), b.labels.begin() + b.num_rows * ls);
+                b.num_rows++;
+            }
+            b.features.resize(b.num_rows * fs);
+            b.labels.resize(b.num_rows * ls);
+            // An empty batch marks the end of the epoch
+            done = (b.num_rows == 0);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(slot);
+            }
+            cv_.notify_all();
+        }
+    }
+
+    const DatasetFile &file_;
+    size_t batch_size_;
+    size_t block_size_;
+    std::vector<Batch> slots_;
+    std::mt19937 rng_;
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<size_t> ready_;
+    std::deque<size_t> free_;
+    bool stop_ = false;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_DATASET_FILE_HPP
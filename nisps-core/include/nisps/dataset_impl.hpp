@@ -37,6 +37,7 @@ inline Dataset::Dataset(DatasetVector &features, DatasetVector &labels)
 
 inline bool Dataset::Add(const std::vector<float> &feature, const std::vector<float> &label)
 {
+    NISPS_PROFILE_SCOPE("Dataset::Add");
     // Enforce consistent dimensions if at least one example exists.
     if (data_size_ > 0) {
         if ((feature.size() != data_size_) ||
@@ -63,6 +64,7 @@ inline bool Dataset::Add(const std::vector<float> &feature, const std::vector<fl
 }
 
 inline void Dataset::RemoveOneExcessExample() {
+    NISPS_PROFILE_SCOPE("Dataset::Evict");
     // Remove one example according to the current forget mode.
     size_t index_to_remove = 0;
     switch (forget_mode_) {
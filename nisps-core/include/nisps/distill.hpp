@@ -0,0 +1,251 @@
+/**
+ * @file distill.hpp
+ * @brief Structured neuron pruning and distillation into smaller networks
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * A trained network (the teacher) is queried on inputs drawn densely from
+ * its input range, and a smaller dense network (the student) is trained to
+ * reproduce the teacher's outputs there. Unlike magnitude pruning, the
+ * result has a genuinely smaller topology, so every inference gets cheaper
+ * without a sparse kernel.
+ *
+ * When the student keeps the teacher's number of hidden layers, it starts
+ * from the teacher's most important neurons: a hidden neuron's importance
+ * is its mean absolute activation over the samples times the L2 norm of
+ * its outgoing weights. Other topologies start from Xavier initialisation.
+ */
+
+#ifndef NISPS_DISTILL_HPP
+#define NISPS_DISTILL_HPP
+
+#include "mlp.hpp"
+#include "random.hpp"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+namespace nisps {
+
+/**
+ * @brief How well a distilled student matches its teacher.
+ */
+template<typename T>
+struct DistillReport {
+    size_t teacher_parameters = 0;
+    size_t student_parameters = 0;
+    T train_loss = 0;          /**< Student loss on the training samples after the last epoch */
+    T mean_abs_error = 0;      /**< Mean |student - teacher| over held-out samples and outputs */
+    T max_abs_error = 0;       /**< Largest |student - teacher| over held-out samples and outputs */
+};
+
+/**
+ * @class Distiller
+ * @brief Shrinks a trained MLP into a smaller one that reproduces its outputs.
+ *
+ * Inputs are drawn uniformly from a box; the trailing bias_inputs inputs
+ * are held at 1, matching the bias input IML appends. The same training
+ * and held-out samples are reused for every student, so several topologies
+ * can be compared fairly.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class Distiller {
+ public:
+    struct Config {
+        size_t train_samples = 1024;    /**< Teacher queries to train the student on */
+        size_t test_samples = 256;      /**< Held-out teacher queries for the report */
+        int epochs = 300;
+        float learning_rate = 0.01f;
+        size_t bias_inputs = 1;         /**< Trailing inputs held at 1 */
+        uint64_t seed = Random::kDefaultSeed;
+    };
+
+    /**
+     * @brief Samples the teacher on [input_min, input_max] per non-bias input.
+     * @param teacher Trained network; only queried
+     * @param input_min Lower bound of each non-bias input
+     * @param input_max Upper bound of each non-bias input
+     * @param config Sampling and training settings
+     */
+    Distiller(MLP<T> &teacher, const std::vector<T> &input_min, const std::vector<T> &input_max,
+              const Config &config)
+        : teacher_(teacher),
+          config_(config),
+          rng_(config.seed) {
+        const size_t n_in = static_cast<size_t>(teacher.get_num_inputs());
+        const size_t n_free = n_in - std::min(n_in, config_.bias_inputs);
+        auto draw = [&](size_t n, typename MLP<T>::training_pair_t &set) {
+            set.first.resize(n);
+            set.second.resize(n);
+            for (size_t s = 0; s < n; s++) {
+                auto &x = set.first[s];
+                x.assign(n_in, static_cast<T>(1));
+                for (size_t i = 0; i < n_free && i < input_min.size() && i < input_max.size(); i++) {
+                    x[i] = rng_.Uniform(input_min[i], input_max[i]);
+                }
+                teacher_.GetOutput(x, &set.second[s]);
+            }
+        };
+        draw(config_.train_samples, train_);
+        draw(config_.test_samples, test_);
+        ComputeImportance();
+    }
+
+    /**
+     * @brief Importance of each neuron of one hidden layer.
+     * @param hidden_layer Hidden layer index, 0 for the first hidden layer
+     */
+    const std::vector<T> &GetImportance(size_t hidden_layer) const { return importance_[hidden_layer]; }
+
+    /**
+     * @brief Builds and trains a student with the given hidden layer sizes.
+     *
+     * Hidden layers use the teacher's hidden activation and the output layer
+     * the teacher's output activation and loss. If the student has as many
+     * hidden layers as the teacher and none is wider, it starts from the
+     * teacher's most important neurons; otherwise from Xavier initialisation.
+     *
+     * @param hidden Sizes of the student's hidden layers; may be empty
+     * @param report Optional error report
+     * @return The trained student
+     */
+    MLP<T> Distil(const std::vector<size_t> &hidden, DistillReport<T> *report = nullptr) {
+        const auto &t_layers = teacher_.m_layers;
+        std::vector<size_t> nodes{static_cast<size_t>(teacher_.get_num_inputs())};
+        nodes.insert(nodes.end(), hidden.begin(), hidden.end());
+        nodes.push_back(static_cast<size_t>(teacher_.get_num_outputs()));
+
+        const bool prunable = hidden.size() + 1 == t_layers.size() &&
+            std::equal(hidden.begin(), hidden.end(), t_layers.begin(),
+                       [](size_t n, const Layer<T> &l) { return n <= static_cast<size_t>(l.GetOutputSize()); });
+        std::vector<ACTIVATION_FUNCTIONS> activations(hidden.size() + 1);
+        for (size_t l = 0; l < hidden.size(); l++) {
+            activations[l] = t_layers[prunable ? l : 0].GetActivationFunctionType();
+        }
+        activations.back() = t_layers.back().GetActivationFunctionType();
+
+        MLP<T> student(nodes, activations, teacher_.GetLossFunctionType());
+        student.SetSeed(config_.seed);
+        if (prunable) {
+            CopyKeptNeurons(student, hidden);
+        } else {
+            student.InitXavier();
+        }
+
+        const T loss = student.Train(train_, config_.learning_rate, config_.epochs, 0, false);
+        if (report) {
+            *report = Evaluate(student);
+            report->train_loss = loss;
+        }
+        return student;
+    }
+
+    /**
+     * @brief Measures how closely a network reproduces the teacher on the held-out samples.
+     */
+    DistillReport<T> Evaluate(MLP<T> &student) {
+        DistillReport<T> r;
+        r.teacher_parameters = teacher_.GetNumParameters();
+        r.student_parameters = student.GetNumParameters();
+        size_t count = 0;
+        for (size_t s = 0; s < test_.first.size(); s++) {
+            student.GetOutput(test_.first[s], &y_);
+            const auto &expected = test_.second[s];
+            for (size_t k = 0; k < y_.size() && k < expected.size(); k++) {
+                const T e = std::abs(y_[k] - expected[k]);
+                r.mean_abs_error += e;
+                r.max_abs_error = std::max(r.max_abs_error, e);
+                count++;
+            }
+        }
+        if (count) {
+            r.mean_abs_error /= static_cast<T>(count);
+        }
+        return r;
+    }
+
+    /**
+     * @brief Teacher samples the student is trained on.
+     */
+    const typename MLP<T>::training_pair_t &GetTrainingSet() const { return train_; }
+
+ private:
+    void ComputeImportance() {
+        const auto &t_layers = teacher_.m_layers;
+        const size_t n_hidden = t_layers.empty() ? 0 : t_layers.size() - 1;
+        importance_.assign(n_hidden, {});
+        for (size_t h = 0; h < n_hidden; h++) {
+            importance_[h].assign(t_layers[h].GetOutputSize(), 0);
+        }
+        std::vector<std::vector<T>> acts;
+        for (const auto &x : train_.first) {
+            acts.clear();
+            teacher_.GetOutput(x, &y_, &acts, false);
+            for (size_t h = 0; h < n_hidden && h + 1 < acts.size(); h++) {
+                for (size_t j = 0; j < importance_[h].size(); j++) {
+                    importance_[h][j] += std::abs(acts[h + 1][j]);
+                }
+            }
+        }
+        for (size_t h = 0; h < n_hidden; h++) {
+            for (size_t j = 0; j < importance_[h].size(); j++) {
+                T norm = 0;
+                for (const auto &node : t_layers[h + 1].m_nodes) {
+                    norm += node.m_weights[j] * node.m_weights[j];
+                }
+                importance_[h][j] *= std::sqrt(norm);
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the most important teacher neurons into the student, in their original order.
+     */
+    void CopyKeptNeurons(MLP<T> &student, const std::vector<size_t> &hidden) {
+        const auto &t_layers = teacher_.m_layers;
+        std::vector<size_t> prev_kept(static_cast<size_t>(teacher_.get_num_inputs()));
+        std::iota(prev_kept.begin(), prev_kept.end(), size_t(0));
+        std::vector<size_t> kept;
+        for (size_t l = 0; l < t_layers.size(); l++) {
+            if (l < hidden.size()) {
+                const auto &imp = importance_[l];
+                kept.resize(imp.size());
+                std::iota(kept.begin(), kept.end(), size_t(0));
+                std::stable_sort(kept.begin(), kept.end(), [&](size_t a, size_t b) { return imp[a] > imp[b]; });
+                kept.resize(hidden[l]);
+                std::sort(kept.begin(), kept.end());
+            } else {
+                kept.resize(t_layers[l].GetOutputSize());
+                std::iota(kept.begin(), kept.end(), size_t(0));
+            }
+            auto &dst = student.m_layers[l].m_nodes;
+            for (size_t n = 0; n < kept.size(); n++) {
+                const auto &src = t_layers[l].m_nodes[kept[n]];
+                for (size_t i = 0; i < prev_kept.size(); i++) {
+                    dst[n].m_weights[i] = src.m_weights[prev_kept[i]];
+                }
+                dst[n].m_bias = src.m_bias;
+            }
+            prev_kept.swap(kept);
+        }
+    }
+
+    MLP<T> &teacher_;
+    const Config config_;
+    Random rng_;
+    typename MLP<T>::training_pair_t train_;
+    typename MLP<T>::training_pair_t test_;
+    std::vector<std::vector<T>> importance_;
+    std::vector<T> y_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_DISTILL_HPP
@@ -0,0 +1,212 @@
+/**
+ * @file es_trainer.hpp
+ * @brief Evolution-strategies trainer for reward-driven mappings
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Follows Salimans et al., "Evolution Strategies as a Scalable Alternative
+ * to Reinforcement Learning" (2017): antithetic Gaussian perturbations
+ * drawn as offsets into one shared noise table, centered-rank fitness
+ * shaping, and a plain gradient-ascent update.
+ */
+
+#ifndef NISPS_ES_TRAINER_HPP
+#define NISPS_ES_TRAINER_HPP
+
+#include "mlp.hpp"
+#include "random.hpp"
+
+#include <vector>
+#include <span>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+
+namespace nisps {
+
+/**
+ * @class EvolutionStrategies
+ * @brief Trains an MLP to maximise a reward using a population of perturbed copies.
+ *
+ * Each generation evaluates population_pairs antithetic pairs
+ * (theta + sigma * eps, theta - sigma * eps) on worker threads, each with its
+ * own copy of the network. A perturbation is stored only as an offset into
+ * the shared noise table, so memory stays O(params) however large the
+ * population is.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class EvolutionStrategies {
+ public:
+    /**
+     * @brief Reward for one candidate network; higher is better.
+     *
+     * Called concurrently from several threads, each with its own network,
+     * so it must not modify shared state without synchronisation.
+     */
+    using RewardFn = std::function<T(MLP<T> &)>;
+
+    struct Config {
+        size_t population_pairs = 16;   /**< Antithetic pairs per generation */
+        T sigma = static_cast<T>(0.05); /**< Perturbation standard deviation */
+        T learning_rate = static_cast<T>(0.02);
+        T weight_decay = 0;             /**< L2 coefficient applied in the update */
+        size_t noise_table_size = 0;    /**< Shared noise values; 0 picks max(2^16, 8 * params) */
+        size_t num_threads = 0;         /**< Evaluation threads; 0 uses the hardware concurrency */
+        uint64_t seed = Random::kDefaultSeed;
+    };
+
+    /**
+     * @brief Prepares the trainer; the network's current parameters are the starting point.
+     * @param mlp Network to train; updated after every generation
+     * @param config Trainer settings
+     */
+    EvolutionStrategies(MLP<T> &mlp, const Config &config)
+        : mlp_(mlp),
+          config_(config),
+          num_params_(mlp.GetNumParameters()),
+          rng_(config.seed),
+          theta_(num_params_),
+          gradient_(num_params_),
+          offsets_(config.population_pairs),
+          rewards_(2 * config.population_pairs),
+          shaped_(2 * config.population_pairs),
+          order_(2 * config.population_pairs) {
+        const size_t table_size = config_.noise_table_size
+            ? std::max(config_.noise_table_size, num_params_)
+            : std::max<size_t>(size_t(1) << 16, 8 * num_params_);
+        noise_.resize(table_size);
+        rng_.FillNormal(std::span<T>(noise_));
+
+        size_t threads = config_.num_threads ? config_.num_threads
+                                             : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, std::max<size_t>(rewards_.size(), 1));
+        for (size_t t = 0; t < threads; t++) {
+            workers_.push_back(std::make_unique<MLP<T>>(mlp_));
+            candidates_.emplace_back(num_params_);
+        }
+        mlp_.GetParameters(theta_);
+    }
+
+    /**
+     * @brief Runs one generation and updates the network.
+     * @param reward Reward function
+     * @return Mean reward of the population
+     */
+    T Step(const RewardFn &reward) {
+        const size_t n_pairs = offsets_.size();
+        if (n_pairs == 0) {
+            return 0;
+        }
+        const size_t max_offset = noise_.size() - num_params_ + 1;
+        for (auto &offset : offsets_) {
+            offset = rng_.Below(static_cast<uint32_t>(max_offset));
+        }
+
+        // Evaluate members 2i (+eps) and 2i+1 (-eps) on the worker threads
+        std::atomic<size_t> next{0};
+        auto evaluate = [&](size_t worker) {
+            MLP<T> &net = *workers_[worker];
+            std::vector<T> &candidate = candidates_[worker];
+            for (size_t m = next.fetch_add(1); m < rewards_.size(); m = next.fetch_add(1)) {
+                const T *eps = noise_.data() + offsets_[m / 2];
+                const T scale = (m % 2 == 0) ? config_.sigma : -config_.sigma;
+                for (size_t i = 0; i < num_params_; i++) {
+                    candidate[i] = theta_[i] + scale * eps[i];
+                }
+                net.SetParameters(candidate);
+                rewards_[m] = reward(net);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t w = 1; w < workers_.size(); w++) {
+            threads.emplace_back(evaluate, w);
+        }
+        evaluate(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        // Centered ranks in [-0.5, 0.5] make the update invariant to reward scale
+        const size_t n = rewards_.size();
+        std::iota(order_.begin(), order_.end(), 0);
+        std::sort(order_.begin(), order_.end(),
+                  [this](size_t a, size_t b) { return rewards_[a] < rewards_[b]; });
+        for (size_t r = 0; r < n; r++) {
+            shaped_[order_[r]] = (n > 1) ? static_cast<T>(r) / static_cast<T>(n - 1) - static_cast<T>(0.5) : 0;
+        }
+
+        std::fill(gradient_.begin(), gradient_.end(), static_cast<T>(0));
+        for (size_t p = 0; p < n_pairs; p++) {
+            const T w = shaped_[2 * p] - shaped_[2 * p + 1];
+            if (w == 0) {
+                continue;
+            }
+            const T *eps = noise_.data() + offsets_[p];
+            for (size_t i = 0; i < num_params_; i++) {
+                gradient_[i] += w * eps[i];
+            }
+        }
+        const T step = config_.learning_rate / (static_cast<T>(n_pairs) * config_.sigma);
+        const T decay = config_.learning_rate * config_.weight_decay;
+        for (size_t i = 0; i < num_params_; i++) {
+            theta_[i] += step * gradient_[i] - decay * theta_[i];
+        }
+        mlp_.SetParameters(theta_);
+
+        T mean = 0;
+        for (T r : rewards_) {
+            mean += r;
+        }
+        return mean / static_cast<T>(n);
+    }
+
+    /**
+     * @brief Runs several generations.
+     * @param reward Reward function
+     * @param generations Number of generations
+     * @return Mean population reward of the last generation
+     */
+    T Train(const RewardFn &reward, size_t generations) {
+        T mean = 0;
+        for (size_t g = 0; g < generations; g++) {
+            mean = Step(reward);
+        }
+        return mean;
+    }
+
+    /**
+     * @brief Restarts from the network's current parameters, e.g. after it was edited.
+     */
+    void Sync() {
+        mlp_.GetParameters(theta_);
+    }
+
+    size_t GetNumThreads() const { return workers_.size(); }
+
+ private:
+    MLP<T> &mlp_;
+    const Config config_;
+    const size_t num_params_;
+    Random rng_;
+    std::vector<T> noise_;                          /**< Shared N(0, 1) table */
+    std::vector<T> theta_;                          /**< Current parameters */
+    std::vector<T> gradient_;
+    std::vector<size_t> offsets_;                   /**< Noise offset of each pair */
+    std::vector<T> rewards_;
+    std::vector<T> shaped_;
+    std::vector<size_t> order_;
+    std::vector<std::unique_ptr<MLP<T>>> workers_;  /**< One network copy per thread */
+    std::vector<std::vector<T>> candidates_;        /**< One parameter buffer per thread */
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_ES_TRAINER_HPP
@@ -0,0 +1,104 @@
+/**
+ * @file extrapolator.hpp
+ * @brief First-order output tracking between inference ticks
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_EXTRAPOLATOR_HPP
+#define NISPS_EXTRAPOLATOR_HPP
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <limits>
+
+namespace nisps {
+
+/**
+ * @class OutputExtrapolator
+ * @brief Follows input movement between full inferences using the Jacobian.
+ *
+ * At each inference tick, Anchor() stores the input, the outputs and the
+ * Jacobian from MLP::GetOutputWithJacobian(). Between ticks, Extrapolate()
+ * returns y0 + J (x - x0) for the current input, which costs
+ * outputs * inputs multiply-adds and can run once per audio block.
+ *
+ * @tparam T Scalar type
+ */
+template<typename T>
+class OutputExtrapolator {
+ public:
+    /**
+     * @param num_inputs Network inputs, including any bias input
+     * @param num_outputs Network outputs
+     */
+    OutputExtrapolator(size_t num_inputs, size_t num_outputs)
+        : x0_(num_inputs),
+          y0_(num_outputs),
+          jacobian_(num_inputs * num_outputs) {}
+
+    /**
+     * @brief Clamps extrapolated outputs, e.g. to [0, 1] for sigmoid outputs.
+     */
+    void SetOutputRange(T lo, T hi) {
+        lo_ = lo;
+        hi_ = hi;
+    }
+
+    /**
+     * @brief Stores a new linearisation point from a full inference.
+     * @param input Input the inference ran on
+     * @param output Outputs of that inference
+     * @param jacobian d output[k] / d input[i] at [k * inputs + i]
+     * @return false if the sizes do not match
+     */
+    bool Anchor(std::span<const T> input, std::span<const T> output, std::span<const T> jacobian) {
+        if (input.size() != x0_.size() || output.size() != y0_.size() ||
+            jacobian.size() != jacobian_.size()) {
+            return false;
+        }
+        std::copy(input.begin(), input.end(), x0_.begin());
+        std::copy(output.begin(), output.end(), y0_.begin());
+        std::copy(jacobian.begin(), jacobian.end(), jacobian_.begin());
+        anchored_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Estimates the outputs for an input near the anchor.
+     * @param input Current input
+     * @param output Receives the estimate
+     * @return false if not anchored yet or the sizes do not match
+     */
+    bool Extrapolate(std::span<const T> input, std::span<T> output) const {
+        if (!anchored_ || input.size() != x0_.size() || output.size() != y0_.size()) {
+            return false;
+        }
+        const size_t n_in = x0_.size();
+        for (size_t k = 0; k < y0_.size(); k++) {
+            const T *row = jacobian_.data() + k * n_in;
+            T y = y0_[k];
+            for (size_t i = 0; i < n_in; i++) {
+                y += row[i] * (input[i] - x0_[i]);
+            }
+            output[k] = std::clamp(y, lo_, hi_);
+        }
+        return true;
+    }
+
+ private:
+    std::vector<T> x0_;
+    std::vector<T> y0_;
+    std::vector<T> jacobian_;  /**< Row-major, outputs x inputs */
+    T lo_ = std::numeric_limits<T>::lowest();
+    T hi_ = std::numeric_limits<T>::max();
+    bool anchored_ = false;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_EXTRAPOLATOR_HPP
@@ -0,0 +1,213 @@
+/**
+ * @file fourier_features.hpp
+ * @brief Fixed random Fourier feature embedding of network inputs
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * A small ReLU network on a few slow inputs (a joystick, say) learns
+ * smooth mappings; sharp transitions need wide hidden layers. Feeding it
+ * sin(2 pi b.x) and cos(2 pi b.x) for a set of random frequency vectors b
+ * instead lets a much narrower network fit them. The bandwidth (standard
+ * deviation of the frequencies, in cycles per unit input) sets how sharp:
+ * too low and nothing changes, too high and the mapping turns to noise.
+ *
+ * The frequencies are drawn once and never trained. Serialise() stores
+ * them next to the model, so a reloaded mapping sees identical features.
+ */
+
+#ifndef NISPS_FOURIER_FEATURES_HPP
+#define NISPS_FOURIER_FEATURES_HPP
+
+#include "random.hpp"
+#include "kernels.hpp"
+#include "binary_io.hpp"
+#include "realtime.hpp"
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace nisps {
+
+/**
+ * @class FourierFeatures
+ * @brief Maps x to [sin(2 pi B x), cos(2 pi B x), x] for a fixed random B.
+ *
+ * @tparam T Scalar type
+ */
+template<typename T>
+class FourierFeatures {
+ public:
+    struct Config {
+        size_t num_features = 16;          /**< Frequency vectors; each gives a sine and a cosine */
+        T bandwidth = 1;                   /**< Standard deviation of the frequencies, in cycles per unit input */
+        bool include_input = true;         /**< Append the raw inputs after the features */
+        uint64_t seed = Random::kDefaultSeed;
+    };
+
+    static constexpr char kMagic[4] = {'N', 'S', 'P', 'F'};
+    static constexpr size_t kHeaderSize = 16;
+
+    FourierFeatures() = default;
+
+    /**
+     * @param num_inputs Inputs to embed; leave any bias input out
+     * @param config Number of features, bandwidth and seed
+     */
+    FourierFeatures(size_t num_inputs, const Config &config)
+        : num_inputs_(num_inputs),
+          num_features_(config.num_features),
+          include_input_(config.include_input),
+          freqs_(config.num_features * num_inputs),
+          turns_(config.num_features) {
+        Random rng(config.seed);
+        rng.FillNormal(std::span<T>(freqs_), static_cast<T>(0), config.bandwidth);
+    }
+
+    size_t GetNumInputs() const { return num_inputs_; }
+    size_t GetNumFeatures() const { return num_features_; }
+
+    /**
+     * @brief Width of the embedding: two per feature, plus the inputs if included.
+     */
+    size_t GetNumOutputs() const { return 2 * num_features_ + (include_input_ ? num_inputs_ : 0); }
+
+    /**
+     * @brief Row-major num_features x num_inputs frequencies, in cycles per unit input.
+     */
+    std::span<const T> GetFrequencies() const { return freqs_; }
+
+    /**
+     * @brief Embeds one input. Does not allocate.
+     * @param x GetNumInputs() values
+     * @param out At least GetNumOutputs() values: sines, then cosines, then the inputs
+     * @return false if a size does not match
+     */
+    bool Process(std::span<const T> x, std::span<T> out) {
+        if (x.size() != num_inputs_ || out.size() < GetNumOutputs()) {
+            return false;
+        }
+        NISPS_RT_SECTION("FourierFeatures::Process");
+        for (size_t f = 0; f < num_features_; f++) {
+            const T *row = freqs_.data() + f * num_inputs_;
+            T acc = 0;
+            for (size_t i = 0; i < num_inputs_; i++) {
+                acc += row[i] * x[i];
+            }
+            turns_[f] = acc;
+        }
+        kernels::SinCos2Pi(turns_.data(), out.data(), out.data() + num_features_, num_features_);
+        if (include_input_) {
+            std::copy(x.begin(), x.end(), out.begin() + 2 * num_features_);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Embeds a set of inputs, e.g. a training set.
+     * @param inputs Rows of GetNumInputs() values; longer rows are cut
+     * @param bias_inputs Constant 1 inputs appended to each embedded row
+     * @return One embedded row per input row, or nothing if any row is too short
+     */
+    std::vector<std::vector<T>> Transform(const std::vector<std::vector<T>> &inputs,
+                                          size_t bias_inputs = 0) {
+        for (const auto &row : inputs) {
+            if (row.size() < num_inputs_) {
+                return {};
+            }
+        }
+        std::vector<std::vector<T>> out(inputs.size());
+        for (size_t r = 0; r < inputs.size(); r++) {
+            out[r].assign(GetNumOutputs() + bias_inputs, static_cast<T>(1));
+            Process(std::span<const T>(inputs[r].data(), num_inputs_), out[r]);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Bytes Serialise() writes.
+     */
+    size_t SerialisedSize() const { return kHeaderSize + freqs_.size() * sizeof(T); }
+
+    /**
+     * @brief Writes the embedding, little-endian: magic, scalar size, flags, sizes and frequencies.
+     * @param buffer At least SerialisedSize() bytes
+     * @return Bytes written, or 0 if the buffer is too small
+     */
+    size_t Serialise(std::span<uint8_t> buffer) const {
+        const size_t size = SerialisedSize();
+        if (buffer.size() < size) {
+            return 0;
+        }
+        uint8_t *dst = buffer.data();
+        std::memcpy(dst, kMagic, sizeof(kMagic));
+        binary_io::Store<uint16_t>(dst + 4, static_cast<uint16_t>(sizeof(T)));
+        binary_io::Store<uint16_t>(dst + 6, include_input_ ? 1 : 0);
+        binary_io::Store<uint32_t>(dst + 8, static_cast<uint32_t>(num_inputs_));
+        binary_io::Store<uint32_t>(dst + 12, static_cast<uint32_t>(num_features_));
+        binary_io::StoreArray(dst + kHeaderSize, freqs_.data(), freqs_.size());
+        return size;
+    }
+
+    /**
+     * @brief Size of the embedding Serialise() wrote at the start of a buffer.
+     * @return Bytes, or 0 if the buffer does not start with a whole embedding of this scalar type
+     */
+    static size_t RecordSize(std::span<const uint8_t> buffer) {
+        if (buffer.size() < kHeaderSize || std::memcmp(buffer.data(), kMagic, sizeof(kMagic)) != 0 ||
+            binary_io::Load<uint16_t>(buffer.data() + 4) != sizeof(T)) {
+            return 0;
+        }
+        const size_t n_in = binary_io::Load<uint32_t>(buffer.data() + 8);
+        const size_t n_feat = binary_io::Load<uint32_t>(buffer.data() + 12);
+        // Bound the sizes by the bytes present before multiplying, so a bad header cannot wrap
+        if (n_in == 0 || n_feat > (buffer.size() - kHeaderSize) / sizeof(T) / n_in) {
+            return 0;
+        }
+        return kHeaderSize + n_in * n_feat * sizeof(T);
+    }
+
+    /**
+     * @brief GetNumOutputs() of the embedding in a buffer RecordSize() accepts.
+     */
+    static size_t RecordNumOutputs(std::span<const uint8_t> buffer) {
+        const size_t n_in = binary_io::Load<uint32_t>(buffer.data() + 8);
+        const size_t n_feat = binary_io::Load<uint32_t>(buffer.data() + 12);
+        return 2 * n_feat + (binary_io::Load<uint16_t>(buffer.data() + 6) != 0 ? n_in : 0);
+    }
+
+    /**
+     * @brief Restores an embedding written by Serialise().
+     * @return false if the bytes are not a serialised embedding of this scalar type; the object is then unchanged
+     */
+    bool FromSerialised(std::span<const uint8_t> buffer) {
+        if (RecordSize(buffer) == 0) {
+            return false;
+        }
+        const size_t n_in = binary_io::Load<uint32_t>(buffer.data() + 8);
+        const size_t n_feat = binary_io::Load<uint32_t>(buffer.data() + 12);
+        num_inputs_ = n_in;
+        num_features_ = n_feat;
+        include_input_ = binary_io::Load<uint16_t>(buffer.data() + 6) != 0;
+        freqs_.resize(n_in * n_feat);
+        binary_io::LoadArray(freqs_.data(), buffer.data() + kHeaderSize, freqs_.size());
+        turns_.resize(n_feat);
+        return true;
+    }
+
+ private:
+    size_t num_inputs_ = 0;
+    size_t num_features_ = 0;
+    bool include_input_ = true;
+    std::vector<T> freqs_;
+    std::vector<T> turns_;              /**< b.x per feature, reused across calls */
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_FOURIER_FEATURES_HPP
@@ -0,0 +1,223 @@
+/**
+ * @file frozen.hpp
+ * @brief Compact, immutable inference-only networks
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * A trainable MLP keeps optimizer state, gradient accumulators and cached
+ * outputs next to every weight. FrozenMLP keeps only what the forward pass
+ * reads: per layer a row-major weight matrix and a bias vector, packed with
+ * the layer descriptors and the forward-pass scratch into one allocation,
+ * taken from a caller-chosen std::pmr::memory_resource.
+ */
+
+#ifndef NISPS_FROZEN_HPP
+#define NISPS_FROZEN_HPP
+
+#include "utils.hpp"
+#include "kernels.hpp"
+#include "realtime.hpp"
+
+#include <vector>
+#include <span>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace nisps {
+
+template<typename T>
+class MLP;
+
+/**
+ * @brief Affine maps folded into a frozen network.
+ *
+ * The network sees (x - input_offset) * input_scale, and its outputs are
+ * reported as y * output_scale + output_offset. Empty vectors mean identity.
+ */
+template<typename T>
+struct FreezeNormalisation {
+    std::vector<T> input_offset;   /**< One per network input, including any bias input */
+    std::vector<T> input_scale;
+    std::vector<T> output_scale;   /**< One per output */
+    std::vector<T> output_offset;
+};
+
+/**
+ * @class FrozenMLP
+ * @brief Inference-only copy of an MLP; create with MLP::Freeze().
+ *
+ * Input normalisation is folded into the first layer's weights and biases.
+ * Output normalisation is folded into the last layer when its activation
+ * is LINEAR and applied after the activation otherwise. The model cannot
+ * be modified after freezing.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class FrozenMLP {
+ public:
+    FrozenMLP(FrozenMLP &&) noexcept = default;
+    FrozenMLP &operator=(FrozenMLP &&) noexcept = default;
+    FrozenMLP(const FrozenMLP &) = delete;
+    FrozenMLP &operator=(const FrozenMLP &) = delete;
+
+    /**
+     * @brief Evaluates the network.
+     * @param input get_num_inputs() values
+     * @param output get_num_outputs() values
+     * @return false if a size does not match
+     */
+    bool Process(std::span<const T> input, std::span<T> output) {
+        NISPS_RT_SECTION("FrozenMLP::Process");
+        if (input.size() != num_inputs_ || output.size() != num_outputs_ || num_layers_ == 0) {
+            return false;
+        }
+        const T *x = input.data();
+        T *bufs[2] = {scratch_, scratch_ + max_width_};
+        for (size_t l = 0; l < num_layers_; l++) {
+            const Desc &d = descs_[l];
+            T *y = (l + 1 == num_layers_) ? output.data() : bufs[l & 1];
+            kernels::Gemv(params_ + d.weights, params_ + d.biases, d.rows, d.cols, x, y);
+            for (size_t r = 0; r < d.rows; r++) {
+                y[r] = d.activation(y[r]);
+            }
+            x = y;
+        }
+        if (softmax_ && num_outputs_ > 1) {
+            Softmax(output);
+        }
+        if (output_affine_) {
+            const T *scale = params_ + output_affine_;
+            const T *offset = scale + num_outputs_;
+            for (size_t k = 0; k < num_outputs_; k++) {
+                output[k] = output[k] * scale[k] + offset[k];
+            }
+        }
+        return true;
+    }
+
+    size_t get_num_inputs() const { return num_inputs_; }
+    size_t get_num_outputs() const { return num_outputs_; }
+    size_t GetNumLayers() const { return num_layers_; }
+
+    /**
+     * @brief Total number of weights and biases.
+     */
+    size_t GetNumParameters() const { return num_params_; }
+
+    /**
+     * @brief Bytes owned by the model: the object plus its single allocation.
+     */
+    size_t GetFootprintBytes() const { return sizeof(*this) + bytes_; }
+
+ private:
+    template<typename> friend class MLP;
+
+    struct Desc {
+        uint32_t rows;
+        uint32_t cols;
+        size_t weights;                     /**< Offset into params_ of the row-major matrix */
+        size_t biases;                      /**< Offset into params_ of the bias vector */
+        activation_func_t<T> activation;
+    };
+
+    /**
+     * @param nodes Layer sizes, inputs first
+     * @param activations Activation of each layer after the input
+     * @param softmax Apply a softmax to the outputs
+     * @param output_affine Reserve an output scale and offset applied after the activation
+     * @param resource Where the block is allocated
+     */
+    FrozenMLP(std::span<const size_t> nodes, std::span<const activation_func_t<T>> activations,
+              bool softmax, bool output_affine, std::pmr::memory_resource *resource)
+        : num_layers_(nodes.size() - 1),
+          num_inputs_(nodes.front()),
+          num_outputs_(nodes.back()),
+          softmax_(softmax) {
+        for (size_t l = 0; l < num_layers_; l++) {
+            num_params_ += nodes[l + 1] * (nodes[l] + 1);
+            if (l + 1 < num_layers_) {
+                max_width_ = std::max(max_width_, nodes[l + 1]);
+            }
+        }
+        const size_t n_values = num_params_ + (output_affine ? 2 * num_outputs_ : 0) + 2 * max_width_;
+        const size_t params_at = AlignUp(num_layers_ * sizeof(Desc), alignof(T));
+        bytes_ = params_at + n_values * sizeof(T);
+        block_ = Block(static_cast<std::byte *>(resource->allocate(bytes_, kBlockAlign)),
+                       BlockDeleter{resource, bytes_});
+        descs_ = new (block_.get()) Desc[num_layers_];
+        params_ = reinterpret_cast<T *>(block_.get() + params_at);
+        std::fill(params_, params_ + n_values, static_cast<T>(0));
+
+        size_t at = 0;
+        for (size_t l = 0; l < num_layers_; l++) {
+            Desc &d = descs_[l];
+            d.rows = static_cast<uint32_t>(nodes[l + 1]);
+            d.cols = static_cast<uint32_t>(nodes[l]);
+            d.weights = at;
+            at += static_cast<size_t>(d.rows) * d.cols;
+            d.biases = at;
+            at += d.rows;
+            d.activation = activations[l];
+        }
+        if (output_affine) {
+            output_affine_ = at;
+            std::fill(params_ + at, params_ + at + num_outputs_, static_cast<T>(1));
+            at += 2 * num_outputs_;
+        }
+        scratch_ = params_ + at;
+    }
+
+    static constexpr size_t kBlockAlign = std::max(alignof(Desc), alignof(T));
+
+    struct BlockDeleter {
+        std::pmr::memory_resource *resource = nullptr;
+        size_t bytes = 0;
+        void operator()(std::byte *p) const { resource->deallocate(p, bytes, kBlockAlign); }
+    };
+    using Block = std::unique_ptr<std::byte, BlockDeleter>;
+
+    static size_t AlignUp(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+    T *Weights(size_t layer) { return params_ + descs_[layer].weights; }
+    T *Biases(size_t layer) { return params_ + descs_[layer].biases; }
+    T *OutputScale() { return params_ + output_affine_; }
+    T *OutputOffset() { return params_ + output_affine_ + num_outputs_; }
+
+    static void Softmax(std::span<T> y) {
+        const T peak = *std::max_element(y.begin(), y.end());
+        T total = 0;
+        for (auto &v : y) {
+            v = std::exp(v - peak);
+            total += v;
+        }
+        for (auto &v : y) {
+            v /= total;
+        }
+    }
+
+    Block block_;
+    Desc *descs_ = nullptr;
+    T *params_ = nullptr;
+    T *scratch_ = nullptr;
+    size_t bytes_ = 0;
+    size_t num_layers_ = 0;
+    size_t num_inputs_ = 0;
+    size_t num_outputs_ = 0;
+    size_t num_params_ = 0;
+    size_t max_width_ = 0;
+    size_t output_affine_ = 0;              /**< Offset of the output scale in params_; 0 if folded */
+    bool softmax_ = false;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_FROZEN_HPP
@@ -0,0 +1,359 @@
+/**
+ * @file gesture.hpp
+ * @brief Streaming gesture recognition by dynamic time warping against recorded templates
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Each template is a recorded trajectory (joystick positions, analysis
+ * features) resampled to a fixed number of frames and stored in a Dataset,
+ * flattened, with its class as the label. Every tick the newest frame
+ * joins a sliding window of the same length, and the window is matched
+ * against every template with dynamic time warping, constrained to a
+ * Sakoe-Chiba band so a gesture may run a little faster or slower than
+ * recorded.
+ *
+ * Most templates never reach the full DTW. A cascade of lower bounds
+ * discards them first: the distance of the first and last frames (LB_Kim),
+ * then the distance of the window from each template's band envelope
+ * (LB_Keogh), both abandoned as soon as they pass the threshold. The DTW
+ * itself stops once a row, plus the LB_Keogh bound on the rows left,
+ * exceeds it. The threshold is the best distance so far for the leading
+ * class and the runner-up's for the others, so the pruning never changes
+ * the winner or its margin; it only bounds the per-tick cost as templates
+ * are added.
+ */
+
+#ifndef NISPS_GESTURE_HPP
+#define NISPS_GESTURE_HPP
+
+#include "dataset.hpp"
+#include "realtime.hpp"
+
+#include <vector>
+#include <span>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+namespace nisps {
+
+/**
+ * @brief What GestureRecogniser::Process() found at one tick.
+ */
+struct GestureMatch {
+    int class_id = -1;            /**< Best matching class, or -1 if none is under the reject distance */
+    float confidence = 0;         /**< 1 - distance / runner-up class distance, in [0, 1] */
+    float distance = std::numeric_limits<float>::infinity();  /**< Mean squared distance per frame */
+    bool onset = false;           /**< The class differs from the previous tick's: trigger on this */
+};
+
+/**
+ * @brief Work done since the last ResetStats(), to check that the pruning holds.
+ */
+struct GestureStats {
+    uint64_t ticks = 0;
+    uint64_t candidates = 0;      /**< Template comparisons */
+    uint64_t pruned_kim = 0;      /**< Discarded by the first and last frames */
+    uint64_t pruned_keogh = 0;    /**< Discarded by the envelope bound */
+    uint64_t abandoned = 0;       /**< DTW started and abandoned */
+    uint64_t full = 0;            /**< DTW run to the end */
+};
+
+/**
+ * @class GestureRecogniser
+ * @brief Subsequence DTW classifier run one frame per control tick.
+ */
+class GestureRecogniser {
+ public:
+    struct Config {
+        size_t template_length = 32;       /**< Frames per template, and in the matching window */
+        size_t band = 4;                   /**< Sakoe-Chiba radius, in frames */
+        float reject_distance = std::numeric_limits<float>::infinity();  /**< Per frame; worse is no match */
+        size_t max_templates = Dataset::kMax_examples;
+        bool prune = true;                 /**< Off runs the full DTW for every template, for comparison */
+    };
+
+    /**
+     * @param num_inputs Values per frame
+     * @param config Template length, band, reject distance and capacity
+     */
+    GestureRecogniser(size_t num_inputs, const Config &config)
+        : num_inputs_(num_inputs),
+          length_(std::max<size_t>(config.template_length, 2)),
+          band_(std::min(config.band, length_ - 1)),
+          reject_(config.reject_distance * static_cast<float>(length_)),
+          prune_(config.prune),
+          window_(2 * length_ * num_inputs),
+          row_(length_),
+          prev_row_(length_),
+          cum_bound_(length_ + 1) {
+        templates_.SetMaxExamples(config.max_templates);
+    }
+
+    size_t GetNumInputs() const { return num_inputs_; }
+    size_t GetTemplateLength() const { return length_; }
+    size_t GetNumTemplates() const { return classes_.size(); }
+
+    /**
+     * @brief Records a template, resampled linearly to GetTemplateLength() frames.
+     * @param frames At least two frames of GetNumInputs() values
+     * @param class_id Reported when the template matches, from 0
+     * @return false if the frames are malformed or the template store is full
+     */
+    bool AddTemplate(const std::vector<std::vector<float>> &frames, int class_id) {
+        if (frames.size() < 2 || class_id < 0) {
+            return false;
+        }
+        std::vector<float> flat(length_ * num_inputs_);
+        const float step = static_cast<float>(frames.size() - 1) / static_cast<float>(length_ - 1);
+        for (size_t i = 0; i < length_; i++) {
+            const float pos = static_cast<float>(i) * step;
+            const size_t a = std::min(static_cast<size_t>(pos), frames.size() - 2);
+            const float frac = pos - static_cast<float>(a);
+            if (frames[a].size() != num_inputs_ || frames[a + 1].size() != num_inputs_) {
+                return false;
+            }
+            for (size_t d = 0; d < num_inputs_; d++) {
+                flat[i * num_inputs_ + d] = frames[a][d] + frac * (frames[a + 1][d] - frames[a][d]);
+            }
+        }
+        if (!templates_.Add(flat, {static_cast<float>(class_id)})) {
+            return false;
+        }
+        Rebuild();
+        return true;
+    }
+
+    void ClearTemplates() {
+        templates_.Clear();
+        Rebuild();
+    }
+
+    /**
+     * @brief The stored templates; call Rebuild() after changing them directly.
+     */
+    Dataset &GetTemplates() { return templates_; }
+
+    /**
+     * @brief Recomputes the envelopes of the stored templates. Skips any of the wrong size.
+     */
+    void Rebuild() {
+        Dataset::DatasetVector *features = nullptr, *labels = nullptr;
+        templates_.Fetch(features, labels);
+        const size_t size = length_ * num_inputs_;
+        series_.clear();
+        upper_.clear();
+        lower_.clear();
+        classes_.clear();
+        for (size_t k = 0; k < features->size(); k++) {
+            const auto &t = (*features)[k];
+            if (t.size() != size || (*labels)[k].empty()) {
+                continue;
+            }
+            series_.insert(series_.end(), t.begin(), t.end());
+            for (size_t i = 0; i < length_; i++) {
+                const size_t lo = i > band_ ? i - band_ : 0, hi = std::min(i + band_, length_ - 1);
+                for (size_t d = 0; d < num_inputs_; d++) {
+                    float u = t[lo * num_inputs_ + d];
+                    float l = u;
+                    for (size_t j = lo + 1; j <= hi; j++) {
+                        u = std::max(u, t[j * num_inputs_ + d]);
+                        l = std::min(l, t[j * num_inputs_ + d]);
+                    }
+                    upper_.push_back(u);
+                    lower_.push_back(l);
+                }
+            }
+            classes_.push_back(static_cast<int>((*labels)[k][0]));
+        }
+        last_best_ = 0;
+    }
+
+    /**
+     * @brief Forgets the frames seen so far, e.g. when the input source changes.
+     */
+    void Reset() {
+        frames_seen_ = 0;
+        head_ = 0;
+        last_class_ = -1;
+    }
+
+    /**
+     * @brief Adds one frame and matches the latest GetTemplateLength() frames. Does not allocate.
+     * @param frame GetNumInputs() values
+     * @param match Receives the best class; -1 until a full window has been seen
+     * @return false if the frame has the wrong size
+     */
+    bool Process(std::span<const float> frame, GestureMatch *match) {
+        if (frame.size() != num_inputs_) {
+            return false;
+        }
+        NISPS_RT_SECTION("GestureRecogniser::Process");
+        // Each frame is written twice, so the window is always contiguous
+        std::copy(frame.begin(), frame.end(), window_.begin() + head_ * num_inputs_);
+        std::copy(frame.begin(), frame.end(), window_.begin() + (head_ + length_) * num_inputs_);
+        head_ = head_ + 1 == length_ ? 0 : head_ + 1;
+        frames_seen_++;
+        stats_.ticks++;
+
+        *match = GestureMatch();
+        if (frames_seen_ < length_ || classes_.empty()) {
+            last_class_ = -1;
+            return true;
+        }
+        const float *q = window_.data() + head_ * num_inputs_;
+
+        // Best distance and class, and the best distance of any other class
+        float best = reject_, second = reject_;
+        int best_class = -1;
+        size_t best_index = last_best_;
+        const size_t n = classes_.size();
+        for (size_t c = 0; c < n; c++) {
+            // Last tick's winner first, as it most likely still tightens the threshold
+            const size_t k = c == 0 ? last_best_ : (c <= last_best_ ? c - 1 : c);
+            const int cls = classes_[k];
+            const float limit = cls == best_class ? best : second;
+            const float distance = Compare(q, k, limit);
+            if (distance >= limit) {
+                continue;
+            }
+            if (cls == best_class) {
+                best = distance;
+                best_index = k;
+            } else if (distance < best) {
+                second = best;
+                best = distance;
+                best_class = cls;
+                best_index = k;
+            } else {
+                second = distance;
+            }
+        }
+
+        if (best_class >= 0) {
+            last_best_ = best_index;
+            match->class_id = best_class;
+            match->distance = best / static_cast<float>(length_);
+            match->confidence = second < std::numeric_limits<float>::infinity() && second > 0
+                                    ? 1.0f - best / second
+                                    : 1.0f;
+            match->onset = best_class != last_class_;
+        }
+        last_class_ = best_class;
+        return true;
+    }
+
+    const GestureStats &GetStats() const { return stats_; }
+    void ResetStats() { stats_ = GestureStats(); }
+
+ private:
+    static float FrameDistance(const float *a, const float *b, size_t n) {
+        float sum = 0;
+        for (size_t d = 0; d < n; d++) {
+            const float diff = a[d] - b[d];
+            sum += diff * diff;
+        }
+        return sum;
+    }
+
+    // Banded DTW between the window and template k, or some value >= limit once it cannot beat it
+    float Compare(const float *q, size_t k, float limit) {
+        const size_t D = num_inputs_, L = length_;
+        const float *t = series_.data() + k * L * D;
+        const float inf = std::numeric_limits<float>::infinity();
+        stats_.candidates++;
+
+        if (prune_) {
+            // LB_Kim: every path starts at the first frames and ends at the last
+            const float kim = FrameDistance(q, t, D) + FrameDistance(q + (L - 1) * D, t + (L - 1) * D, D);
+            if (kim >= limit) {
+                stats_.pruned_kim++;
+                return kim;
+            }
+            // LB_Keogh: each window frame is at least as far as the template envelope around it
+            const float *u = upper_.data() + k * L * D, *l = lower_.data() + k * L * D;
+            float lb = 0;
+            for (size_t i = 0; i < L; i++) {
+                float frame = 0;
+                for (size_t d = 0; d < D; d++) {
+                    const float v = q[i * D + d];
+                    const float e = v > u[i * D + d] ? v - u[i * D + d] : v < l[i * D + d] ? l[i * D + d] - v : 0.0f;
+                    frame += e * e;
+                }
+                row_[i] = frame;
+                lb += frame;
+                if (lb >= limit) {
+                    stats_.pruned_keogh++;
+                    return lb;
+                }
+            }
+            // Bound on the cost of rows i.. of the path
+            cum_bound_[L] = 0;
+            for (size_t i = L; i-- > 0;) {
+                cum_bound_[i] = cum_bound_[i + 1] + row_[i];
+            }
+        }
+
+        // Rows are window frames, columns template frames within the band
+        std::fill(prev_row_.begin(), prev_row_.end(), inf);
+        for (size_t i = 0; i < L; i++) {
+            const size_t lo = i > band_ ? i - band_ : 0, hi = std::min(i + band_, L - 1);
+            std::fill(row_.begin() + lo, row_.begin() + hi + 1, inf);
+            if (lo > 0) {
+                row_[lo - 1] = inf;
+            }
+            float row_min = inf;
+            for (size_t j = lo; j <= hi; j++) {
+                float prior;
+                if (i == 0 && j == 0) {
+                    prior = 0;
+                } else {
+                    prior = prev_row_[j];
+                    if (j > 0) {
+                        prior = std::min(prior, std::min(prev_row_[j - 1], row_[j - 1]));
+                    }
+                }
+                row_[j] = prior + FrameDistance(q + i * D, t + j * D, D);
+                row_min = std::min(row_min, row_[j]);
+            }
+            if (prune_ && row_min + cum_bound_[i + 1] >= limit) {
+                stats_.abandoned++;
+                return row_min + cum_bound_[i + 1];
+            }
+            std::swap(row_, prev_row_);
+            // Cells outside the next band must read as unreachable
+            if (hi + 1 < L) {
+                prev_row_[hi + 1] = inf;
+            }
+        }
+        stats_.full++;
+        return prev_row_[L - 1];
+    }
+
+    size_t num_inputs_;
+    size_t length_;
+    size_t band_;
+    float reject_;                      /**< Reject distance summed over the window */
+    bool prune_;
+
+    Dataset templates_;
+    std::vector<float> series_;         /**< Templates back to back, as read by Compare() */
+    std::vector<float> upper_, lower_;  /**< Band envelopes, same layout */
+    std::vector<int> classes_;
+
+    std::vector<float> window_;         /**< Latest frames, stored twice over */
+    size_t head_ = 0;                   /**< Oldest frame of the window */
+    size_t frames_seen_ = 0;
+    std::vector<float> row_, prev_row_;
+    std::vector<float> cum_bound_;
+    size_t last_best_ = 0;
+    int last_class_ = -1;
+    GestureStats stats_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_GESTURE_HPP
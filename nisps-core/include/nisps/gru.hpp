@@ -0,0 +1,391 @@
+/**
+ * @file gru.hpp
+ * @brief Small gated recurrent unit network for streaming sequence mappings
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * An MLP only sees the current frame. Giving it context means feeding it a
+ * window of past frames, so its cost grows with the window. A GRU instead
+ * carries a fixed-size hidden state from tick to tick: Step() costs the
+ * same whatever the history it summarises, and the state is the only
+ * memory kept between calls.
+ *
+ * One GRU layer with a dense readout:
+ *
+ *   z = sigmoid(Wxz x + bxz + Whz h + bhz)          update gate
+ *   r = sigmoid(Wxr x + bxr + Whr h + bhr)          reset gate
+ *   n = tanh(Wxn x + bxn + r * (Whn h + bhn))       candidate
+ *   h = (1 - z) * n + z * h
+ *   y = act(Wy h + by)
+ *
+ * The three gates are stacked so each step is two kernels::Gemv() calls
+ * plus the readout. Training is truncated backpropagation through time
+ * over recorded sequences, with the same RMSProp update and gradient norm
+ * clipping as MLP::TrainBatch().
+ */
+
+#ifndef NISPS_GRU_HPP
+#define NISPS_GRU_HPP
+
+#include "utils.hpp"
+#include "random.hpp"
+#include "kernels.hpp"
+#include "binary_io.hpp"
+#include "realtime.hpp"
+
+#include <vector>
+#include <span>
+#include <utility>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace nisps {
+
+/**
+ * @class GRU
+ * @brief Gated recurrent unit with a dense readout, streamed one frame at a time.
+ *
+ * @tparam T Scalar type
+ */
+template<typename T>
+class GRU {
+ public:
+    /** Inputs and targets of one recorded sequence, one row per tick */
+    using sequence_t = std::pair<std::vector<std::vector<T>>, std::vector<std::vector<T>>>;
+
+    static constexpr char kMagic[4] = {'N', 'S', 'P', 'G'};
+    static constexpr size_t kHeaderSize = 20;
+
+    GRU() = default;
+
+    /**
+     * @param num_inputs Features per frame; no bias input, the gates have their own biases
+     * @param num_hidden Size of the recurrent state
+     * @param num_outputs Outputs per frame
+     * @param output_activation Readout activation
+     * @param seed Seed for the initial weights and the sequence order during training
+     */
+    GRU(size_t num_inputs, size_t num_hidden, size_t num_outputs,
+        ACTIVATION_FUNCTIONS output_activation = SIGMOID, uint64_t seed = Random::kDefaultSeed)
+        : rng_(seed) {
+        Resize(num_inputs, num_hidden, num_outputs, output_activation);
+        Init();
+    }
+
+    size_t GetNumInputs() const { return num_inputs_; }
+    size_t GetNumHidden() const { return num_hidden_; }
+    size_t GetNumOutputs() const { return num_outputs_; }
+    size_t GetNumParameters() const { return params_.size(); }
+    ACTIVATION_FUNCTIONS GetOutputActivation() const { return output_activation_; }
+
+    /**
+     * @brief All weights and biases: Wx, bx, Wh, bh, Wy, by, each row-major.
+     */
+    std::span<const T> GetParameters() const { return params_; }
+
+    /**
+     * @brief Redraws the weights uniformly in +-1/sqrt(num_hidden) and clears the state.
+     */
+    void Init() {
+        const T bound = static_cast<T>(1) / std::sqrt(static_cast<T>(num_hidden_));
+        rng_.FillUniform(std::span<T>(params_), -bound, bound);
+        std::fill(sq_avg_.begin(), sq_avg_.end(), static_cast<T>(0));
+        ResetState();
+    }
+
+    void SetSeed(uint64_t seed) { rng_ = Random(seed); }
+
+    /**
+     * @brief Zeroes the hidden state, e.g. at the start of a new phrase.
+     */
+    void ResetState() { std::fill(h_.begin(), h_.end(), static_cast<T>(0)); }
+
+    std::span<const T> GetState() const { return h_; }
+
+    /**
+     * @brief Advances the state by one frame and computes its output. Does not allocate.
+     * @param x GetNumInputs() values
+     * @param y At least GetNumOutputs() values
+     * @return false if a size does not match
+     */
+    bool Step(std::span<const T> x, std::span<T> y) {
+        if (x.size() != num_inputs_ || y.size() < num_outputs_) {
+            return false;
+        }
+        NISPS_RT_SECTION("GRU::Step");
+        const size_t H = num_hidden_;
+        kernels::Gemv(Wx(), Bx(), 3 * H, num_inputs_, x.data(), gx_.data());
+        kernels::Gemv(Wh(), Bh(), 3 * H, H, h_.data(), gh_.data());
+        for (size_t j = 0; j < H; j++) {
+            const T z = utils::sigmoid(gx_[j] + gh_[j]);
+            const T r = utils::sigmoid(gx_[H + j] + gh_[H + j]);
+            const T n = std::tanh(gx_[2 * H + j] + r * gh_[2 * H + j]);
+            h_[j] = (1 - z) * n + z * h_[j];
+        }
+        kernels::Gemv(Wy(), By(), num_outputs_, H, h_.data(), y.data());
+        for (size_t k = 0; k < num_outputs_; k++) {
+            y[k] = activation_(y[k]);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Trains on recorded sequences with truncated backpropagation through time.
+     *
+     * Each sequence starts from a zero state and is cut into windows of
+     * bptt_steps frames. Gradients flow back only within a window, but the
+     * state carries over to the next one, so the network still learns to
+     * use context older than a window when it can. Weights are updated once
+     * per window. The streaming state is cleared afterwards.
+     *
+     * @param sequences Inputs and targets per tick; a sequence's two sides must be the same length
+     * @param learning_rate RMSProp learning rate
+     * @param max_iterations Passes over all sequences, in shuffled order
+     * @param bptt_steps Frames per window
+     * @param min_error_cost Stops once the mean squared error per frame falls below this
+     * @return Mean squared error per frame over the last pass, or NaN without
+     *         training if any input or target row has the wrong width
+     */
+    T Train(const std::vector<sequence_t> &sequences, float learning_rate, int max_iterations,
+            size_t bptt_steps = 16, float min_error_cost = 0) {
+        const size_t H = num_hidden_, I = num_inputs_, O = num_outputs_;
+        for (const auto &seq : sequences) {
+            const auto wrong_width = [](size_t width) {
+                return [width](const std::vector<T> &row) { return row.size() != width; };
+            };
+            if (std::any_of(seq.first.begin(), seq.first.end(), wrong_width(I)) ||
+                std::any_of(seq.second.begin(), seq.second.end(), wrong_width(O))) {
+                return std::numeric_limits<T>::quiet_NaN();
+            }
+        }
+        bptt_steps = std::max<size_t>(bptt_steps, 1);
+        // Per frame: input, previous state, z, r, n, Whn h + bhn, output pre-activation
+        const size_t stride = I + 5 * H + O;
+        std::vector<T> cache(bptt_steps * stride);
+        std::vector<T> grads(params_.size());
+        std::vector<T> h(H), dh(H), dh_prev(H), dg(3 * H), dgh(3 * H), dy(O), gx(3 * H), gh(3 * H);
+        std::vector<size_t> order(sequences.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        T loss = 0;
+        for (int iter = 0; iter < max_iterations; iter++) {
+            std::shuffle(order.begin(), order.end(), rng_);
+            T sum = 0;
+            size_t frames = 0;
+            for (size_t s : order) {
+                const auto &inputs = sequences[s].first;
+                const auto &targets = sequences[s].second;
+                const size_t len = std::min(inputs.size(), targets.size());
+                std::fill(h.begin(), h.end(), static_cast<T>(0));
+                for (size_t start = 0; start < len; start += bptt_steps) {
+                    const size_t steps = std::min(bptt_steps, len - start);
+
+                    // Forward through the window, keeping what the backward pass needs
+                    for (size_t t = 0; t < steps; t++) {
+                        T *c = cache.data() + t * stride;
+                        T *cx = c, *hp = c + I, *z = hp + H, *r = z + H, *n = r + H, *ghn = n + H, *a = ghn + H;
+                        std::copy_n(inputs[start + t].data(), I, cx);
+                        std::copy(h.begin(), h.end(), hp);
+                        kernels::Gemv(Wx(), Bx(), 3 * H, I, cx, gx.data());
+                        kernels::Gemv(Wh(), Bh(), 3 * H, H, hp, gh.data());
+                        for (size_t j = 0; j < H; j++) {
+                            z[j] = utils::sigmoid(gx[j] + gh[j]);
+                            r[j] = utils::sigmoid(gx[H + j] + gh[H + j]);
+                            ghn[j] = gh[2 * H + j];
+                            n[j] = std::tanh(gx[2 * H + j] + r[j] * ghn[j]);
+                            h[j] = (1 - z[j]) * n[j] + z[j] * hp[j];
+                        }
+                        kernels::Gemv(Wy(), By(), O, H, h.data(), a);
+                    }
+
+                    // Backward, newest frame first
+                    std::fill(grads.begin(), grads.end(), static_cast<T>(0));
+                    std::fill(dh_prev.begin(), dh_prev.end(), static_cast<T>(0));
+                    T window_loss = 0;
+                    for (size_t t = steps; t-- > 0;) {
+                        const T *c = cache.data() + t * stride;
+                        const T *cx = c, *hp = c + I, *z = hp + H, *r = z + H, *n = r + H, *ghn = n + H, *a = ghn + H;
+                        const auto &target = targets[start + t];
+                        for (size_t k = 0; k < O; k++) {
+                            const T diff = activation_(a[k]) - target[k];
+                            window_loss += diff * diff / static_cast<T>(O);
+                            dy[k] = static_cast<T>(2) * diff / static_cast<T>(O) * deriv_activation_(a[k]);
+                        }
+                        // h of this frame is the next frame's previous state, or h itself for the last one
+                        const T *ht = t + 1 < steps ? cache.data() + (t + 1) * stride + I : h.data();
+                        kernels::Ger(GradWy(grads), O, H, dy.data(), ht);
+                        AddTo(GradBy(grads), dy.data(), O);
+                        std::copy(dh_prev.begin(), dh_prev.end(), dh.begin());
+                        kernels::GemvT(Wy(), O, H, dy.data(), dh.data());
+                        for (size_t j = 0; j < H; j++) {
+                            const T dn = dh[j] * (1 - z[j]) * (1 - n[j] * n[j]);
+                            const T dz = dh[j] * (hp[j] - n[j]) * z[j] * (1 - z[j]);
+                            const T dr = dn * ghn[j] * r[j] * (1 - r[j]);
+                            dg[j] = dz;
+                            dg[H + j] = dr;
+                            dg[2 * H + j] = dn;
+                            dgh[j] = dz;
+                            dgh[H + j] = dr;
+                            dgh[2 * H + j] = dn * r[j];
+                            dh_prev[j] = dh[j] * z[j];
+                        }
+                        kernels::Ger(GradWx(grads), 3 * H, I, dg.data(), cx);
+                        AddTo(GradBx(grads), dg.data(), 3 * H);
+                        kernels::Ger(GradWh(grads), 3 * H, H, dgh.data(), hp);
+                        AddTo(GradBh(grads), dgh.data(), 3 * H);
+                        kernels::GemvT(Wh(), 3 * H, H, dgh.data(), dh_prev.data());
+                    }
+                    Apply(grads, learning_rate, static_cast<T>(1) / static_cast<T>(steps));
+                    sum += window_loss;
+                    frames += steps;
+                }
+            }
+            loss = frames ? sum / static_cast<T>(frames) : static_cast<T>(0);
+            if (loss < min_error_cost) {
+                break;
+            }
+        }
+        ResetState();
+        return loss;
+    }
+
+    /**
+     * @brief Bytes Serialise() writes.
+     */
+    size_t SerialisedSize() const { return kHeaderSize + params_.size() * sizeof(T); }
+
+    /**
+     * @brief Writes the network, little-endian: magic, scalar size, readout activation, sizes and parameters.
+     *
+     * The recurrent state is not stored.
+     *
+     * @param buffer At least SerialisedSize() bytes
+     * @return Bytes written, or 0 if the buffer is too small
+     */
+    size_t Serialise(std::span<uint8_t> buffer) const {
+        const size_t size = SerialisedSize();
+        if (buffer.size() < size) {
+            return 0;
+        }
+        uint8_t *dst = buffer.data();
+        std::memcpy(dst, kMagic, sizeof(kMagic));
+        binary_io::Store<uint16_t>(dst + 4, static_cast<uint16_t>(sizeof(T)));
+        binary_io::Store<uint16_t>(dst + 6, static_cast<uint16_t>(output_activation_));
+        binary_io::Store<uint32_t>(dst + 8, static_cast<uint32_t>(num_inputs_));
+        binary_io::Store<uint32_t>(dst + 12, static_cast<uint32_t>(num_hidden_));
+        binary_io::Store<uint32_t>(dst + 16, static_cast<uint32_t>(num_outputs_));
+        binary_io::StoreArray(dst + kHeaderSize, params_.data(), params_.size());
+        return size;
+    }
+
+    /**
+     * @brief Restores a network written by Serialise(), with a cleared state and optimizer.
+     * @return false if the bytes are not a serialised GRU of this scalar type; the object is then unchanged
+     */
+    bool FromSerialised(std::span<const uint8_t> buffer) {
+        if (buffer.size() < kHeaderSize || std::memcmp(buffer.data(), kMagic, sizeof(kMagic)) != 0 ||
+            binary_io::Load<uint16_t>(buffer.data() + 4) != sizeof(T)) {
+            return false;
+        }
+        const auto activation = static_cast<ACTIVATION_FUNCTIONS>(binary_io::Load<uint16_t>(buffer.data() + 6));
+        const size_t I = binary_io::Load<uint32_t>(buffer.data() + 8);
+        const size_t H = binary_io::Load<uint32_t>(buffer.data() + 12);
+        const size_t O = binary_io::Load<uint32_t>(buffer.data() + 16);
+        if (activation > HARDTANH || buffer.size() < kHeaderSize + CountParameters(I, H, O) * sizeof(T)) {
+            return false;
+        }
+        Resize(I, H, O, activation);
+        binary_io::LoadArray(params_.data(), buffer.data() + kHeaderSize, params_.size());
+        std::fill(sq_avg_.begin(), sq_avg_.end(), static_cast<T>(0));
+        ResetState();
+        return true;
+    }
+
+ private:
+    static size_t CountParameters(size_t I, size_t H, size_t O) {
+        return 3 * H * (I + 1) + 3 * H * (H + 1) + O * (H + 1);
+    }
+
+    void Resize(size_t I, size_t H, size_t O, ACTIVATION_FUNCTIONS activation) {
+        num_inputs_ = I;
+        num_hidden_ = H;
+        num_outputs_ = O;
+        output_activation_ = activation;
+        std::pair<utils::activation_func_t<T>, utils::activation_func_t<T>> *pair = nullptr;
+        utils::ActivationFunctionsManager<T>::Singleton().GetActivationFunctionPair(activation, &pair);
+        activation_ = pair->first;
+        deriv_activation_ = pair->second;
+        params_.assign(CountParameters(I, H, O), static_cast<T>(0));
+        sq_avg_.assign(params_.size(), static_cast<T>(0));
+        h_.assign(H, static_cast<T>(0));
+        gx_.assign(3 * H, static_cast<T>(0));
+        gh_.assign(3 * H, static_cast<T>(0));
+    }
+
+    // Offsets of each block in the flat layout; gradients use the same layout
+    size_t OffBx() const { return 3 * num_hidden_ * num_inputs_; }
+    size_t OffWh() const { return OffBx() + 3 * num_hidden_; }
+    size_t OffBh() const { return OffWh() + 3 * num_hidden_ * num_hidden_; }
+    size_t OffWy() const { return OffBh() + 3 * num_hidden_; }
+    size_t OffBy() const { return OffWy() + num_outputs_ * num_hidden_; }
+
+    const T *Wx() const { return params_.data(); }
+    const T *Bx() const { return params_.data() + OffBx(); }
+    const T *Wh() const { return params_.data() + OffWh(); }
+    const T *Bh() const { return params_.data() + OffBh(); }
+    const T *Wy() const { return params_.data() + OffWy(); }
+    const T *By() const { return params_.data() + OffBy(); }
+    T *GradWx(std::vector<T> &g) const { return g.data(); }
+    T *GradBx(std::vector<T> &g) const { return g.data() + OffBx(); }
+    T *GradWh(std::vector<T> &g) const { return g.data() + OffWh(); }
+    T *GradBh(std::vector<T> &g) const { return g.data() + OffBh(); }
+    T *GradWy(std::vector<T> &g) const { return g.data() + OffWy(); }
+    T *GradBy(std::vector<T> &g) const { return g.data() + OffBy(); }
+
+    static void AddTo(T *dst, const T *src, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] += src[i];
+        }
+    }
+
+    // RMSProp with the constants of Node::ApplyAccumulatedGradients(), after clipping the norm to 5
+    void Apply(std::vector<T> &grads, float learning_rate, T scale) {
+        T sumsq = 0;
+        for (T &g : grads) {
+            g *= scale;
+            sumsq += g * g;
+        }
+        const T norm = std::sqrt(sumsq);
+        const T clip = norm > static_cast<T>(5) ? static_cast<T>(5) / norm : static_cast<T>(1);
+        for (size_t i = 0; i < params_.size(); i++) {
+            const T g = std::clamp(grads[i] * clip, static_cast<T>(-10), static_cast<T>(10));
+            sq_avg_[i] = std::min(static_cast<T>(0.9) * sq_avg_[i] + static_cast<T>(0.1) * g * g, static_cast<T>(1e6));
+            const T rate = std::min(static_cast<T>(learning_rate) / (std::sqrt(sq_avg_[i]) + static_cast<T>(1e-6)),
+                                    static_cast<T>(1));
+            params_[i] -= rate * g;
+        }
+    }
+
+    size_t num_inputs_ = 0;
+    size_t num_hidden_ = 0;
+    size_t num_outputs_ = 0;
+    ACTIVATION_FUNCTIONS output_activation_ = SIGMOID;
+    utils::activation_func_t<T> activation_ = nullptr;
+    utils::activation_func_t<T> deriv_activation_ = nullptr;
+    Random rng_;
+    std::vector<T> params_;
+    std::vector<T> sq_avg_;             /**< RMSProp squared-gradient averages */
+    std::vector<T> h_;                  /**< Streaming state */
+    std::vector<T> gx_, gh_;            /**< Stacked gate inputs, reused across steps */
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_GRU_HPP
@@ -3,6 +3,10 @@
 
 #include "mlp.hpp"
 #include "dataset.hpp"
+#include "journal.hpp"
+#include "snapshot.hpp"
+#include "rls.hpp"
+#include "incremental.hpp"
 #include <vector>
 #include <cstddef>
 #include <functional>
@@ -14,6 +18,8 @@ class IML {
 public:
     enum class Mode { Inference, Training };
 
+    static constexpr size_t kUndoDepth = 16;
+
     using LogFn = void(*)(const char*);
 
     IML(size_t n_inputs, size_t n_outputs,
@@ -36,7 +42,16 @@ public:
     void set_outputs(const Float* values, size_t count);
 
     // Runtime
-    void process();
+    // Returns true if any output moved by more than the change epsilon, from new
+    // inputs or since train(), undo(), redo(), randomise_weights() or set_seed()
+    bool process();
+    // Update outputs from the inputs that changed instead of recomputing the network
+    void set_incremental_inference(bool enabled, Float tolerance = static_cast<Float>(1e-5));
+
+    // Change notification: bit i is set when output i moved by more than the
+    // epsilon since it was last reported (outputs from 63 up share bit 63)
+    void set_change_epsilon(Float epsilon) { change_epsilon_ = epsilon; }
+    uint64_t get_changed_mask() const { return changed_mask_; }
 
     // Training workflow
     void set_mode(Mode mode);
@@ -45,6 +60,21 @@ public:
     void add_example(const Float* inputs, size_t n_in, const Float* outputs, size_t n_out);
     void clear_dataset();
     void randomise_weights();
+    // Reseed the network's generator and redraw the initial weights, for reproducible
+    // sessions; the network is then as constructed, with no undo history
+    void set_seed(uint64_t seed);
+    bool undo();
+    bool redo();
+
+    // Online adaptation: each new example immediately refits the output layer;
+    // train() still runs the full retrain
+    void set_online_adaptation(bool enabled);
+    bool get_online_adaptation() const { return rls_ != nullptr; }
+
+    // Session journal (optional, not owned)
+    void set_journal(SessionJournal* journal) { journal_ = journal; }
+    bool checkpoint();
+    bool recover(const std::string& filename);
 
     // Optional logging
     void set_logger(LogFn fn) { log_fn_ = fn; }
@@ -54,6 +84,9 @@ private:
         if (log_fn_) log_fn_(msg);
     }
     void train();
+    void refresh_outputs();
+    void update_changed_mask();
+    void adapt(const std::vector<Float>& inputs, const std::vector<Float>& outputs);
 
     size_t n_inputs_;
     size_t n_outputs_;
@@ -66,13 +99,24 @@ private:
     bool perform_inference_ = true;
 
     std::vector<Float> input_state_;
+    std::vector<Float> input_with_bias_;   /**< Inputs plus the bias term, reused by process() */
     std::vector<Float> output_state_;
+    std::vector<Float> reported_outputs_;
+    Float change_epsilon_ = 0;
+    uint64_t changed_mask_ = 0;
+    bool outputs_refreshed_ = false;       /**< Outputs recomputed outside process(), not yet reported */
 
     std::unique_ptr<Dataset> dataset_;
     std::unique_ptr<MLP<Float>> mlp_;
-    typename MLP<Float>::mlp_weights stored_weights_;
+    std::unique_ptr<ParameterSnapshots<Float>> snapshots_;
+    std::unique_ptr<LastLayerRLS<Float>> rls_;
+    std::unique_ptr<IncrementalInference<Float>> incremental_;
     bool weights_randomised_ = false;
 
+    SessionJournal* journal_ = nullptr;
+    bool replaying_ = false;
+    std::vector<uint8_t> checkpoint_buffer_;
+
     LogFn log_fn_ = nullptr;
 };
 
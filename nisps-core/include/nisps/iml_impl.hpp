@@ -40,8 +40,12 @@ IML<Float>::IML(size_t n_inputs, size_t n_outputs,
         0.0f    // constant_weight_init
     );
 
+    snapshots_ = std::make_unique<ParameterSnapshots<Float>>(*mlp_, kUndoDepth);
+
     input_state_.resize(n_inputs, static_cast<Float>(0.5));
+    input_with_bias_.assign(n_inputs + 1, static_cast<Float>(1.0));
     output_state_.resize(n_outputs, static_cast<Float>(0));
+    reported_outputs_ = output_state_;
 }
 
 template<typename Float>
@@ -81,27 +85,59 @@ void IML<Float>::set_outputs(const Float* values, size_t count) {
 }
 
 template<typename Float>
-void IML<Float>::process() {
-    if (!perform_inference_ || !input_updated_) return;
-
-    // Add bias term
-    std::vector<Float> input_with_bias = input_state_;
-    input_with_bias.push_back(static_cast<Float>(1.0));
+bool IML<Float>::process() {
+    NISPS_PROFILE_SCOPE("IML::process");
+    NISPS_RT_SECTION("IML::process");
+    changed_mask_ = 0;
+    const bool infer = perform_inference_ && input_updated_;
+    if (!infer && !outputs_refreshed_) return false;
+
+    if (infer) {
+        // Run inference; the bias term stays in the last slot
+        std::copy(input_state_.begin(), input_state_.end(), input_with_bias_.begin());
+        if (incremental_) {
+            output_state_ = incremental_->Process(input_with_bias_);
+        } else {
+            mlp_->GetOutput(input_with_bias_, &output_state_);
+        }
+        input_updated_ = false;
+    }
+    // Outputs changed by training, undo and the like are reported here too
+    outputs_refreshed_ = false;
+    update_changed_mask();
+    return changed_mask_ != 0;
+}
 
-    // Run inference
-    std::vector<Float> output(n_outputs_);
-    mlp_->GetOutput(input_with_bias, &output);
+template<typename Float>
+void IML<Float>::update_changed_mask() {
+    changed_mask_ = 0;
+    for (size_t i = 0; i < n_outputs_; ++i) {
+        if (std::abs(output_state_[i] - reported_outputs_[i]) > change_epsilon_) {
+            reported_outputs_[i] = output_state_[i];
+            changed_mask_ |= uint64_t(1) << std::min<size_t>(i, 63);
+        }
+    }
+}
 
-    output_state_ = output;
-    input_updated_ = false;
+template<typename Float>
+void IML<Float>::set_incremental_inference(bool enabled, Float tolerance) {
+    if (enabled) {
+        incremental_ = std::make_unique<IncrementalInference<Float>>(*mlp_, tolerance);
+    } else {
+        incremental_.reset();
+    }
 }
 
 template<typename Float>
 void IML<Float>::set_mode(Mode mode) {
-    if (mode == Mode::Inference && mode_ == Mode::Training) {
+    const bool retrain = mode == Mode::Inference && mode_ == Mode::Training;
+    mode_ = mode;
+    if (journal_ && !replaying_) {
+        journal_->LogModeChange(static_cast<uint32_t>(mode));
+    }
+    if (retrain) {
         train();
     }
-    mode_ = mode;
 }
 
 template<typename Float>
@@ -116,13 +152,14 @@ void IML<Float>::save_example() {
     // Second call: store the example
     dataset_->Add(input_state_, output_state_);
     perform_inference_ = true;
+    adapt(input_state_, output_state_);
+
+    if (journal_ && !replaying_) {
+        journal_->LogExample(input_state_.data(), n_inputs_, output_state_.data(), n_outputs_);
+    }
 
     // Run inference with new example
-    std::vector<Float> input_with_bias = input_state_;
-    input_with_bias.push_back(static_cast<Float>(1.0));
-    std::vector<Float> output(n_outputs_);
-    mlp_->GetOutput(input_with_bias, &output);
-    output_state_ = output;
+    refresh_outputs();
 
     log("Example saved.");
 }
@@ -134,12 +171,22 @@ void IML<Float>::add_example(const Float* inputs, size_t n_in, const Float* outp
     std::vector<Float> out_vec(outputs, outputs + std::min(n_out, n_outputs_));
     out_vec.resize(n_outputs_, static_cast<Float>(0));
     dataset_->Add(in_vec, out_vec);
+    if (journal_ && !replaying_) {
+        journal_->LogExample(in_vec.data(), n_inputs_, out_vec.data(), n_outputs_);
+    }
+    if (rls_) {
+        adapt(in_vec, out_vec);
+        refresh_outputs();
+    }
 }
 
 template<typename Float>
 void IML<Float>::clear_dataset() {
     if (mode_ == Mode::Training) {
         dataset_->Clear();
+        if (journal_ && !replaying_) {
+            journal_->LogClearDataset();
+        }
         log("Dataset cleared.");
     }
 }
@@ -147,26 +194,75 @@ void IML<Float>::clear_dataset() {
 template<typename Float>
 void IML<Float>::randomise_weights() {
     if (mode_ == Mode::Training) {
-        stored_weights_ = mlp_->GetWeights();
+        snapshots_->Capture(*mlp_);
         mlp_->DrawWeights();
         weights_randomised_ = true;
+        if (rls_) {
+            rls_->Reset();
+        }
 
         // Run inference to show effect
-        std::vector<Float> input_with_bias = input_state_;
-        input_with_bias.push_back(static_cast<Float>(1.0));
-        std::vector<Float> output(n_outputs_);
-        mlp_->GetOutput(input_with_bias, &output);
-        output_state_ = output;
+        refresh_outputs();
 
         log("Weights randomised.");
     }
 }
 
+template<typename Float>
+void IML<Float>::set_seed(uint64_t seed) {
+    // Back to a freshly constructed network: weights drawn the way the
+    // constructor draws them (uniform in [-1, 1], in layer and node order),
+    // zero biases, and no earlier weights for train() or undo() to restore
+    mlp_->SetSeed(seed);
+    for (auto& layer : mlp_->m_layers) {
+        for (auto& node : layer.m_nodes) {
+            node.WeightInitialization(node.GetInputSize(), false, 0, &mlp_->GetRandom());
+            node.SetBias(0);
+        }
+    }
+    mlp_->ResetOptimizerState();
+    snapshots_->Clear();
+    weights_randomised_ = false;
+    if (rls_) {
+        rls_->Reset();
+    }
+    refresh_outputs();
+}
+
+template<typename Float>
+bool IML<Float>::undo() {
+    if (!snapshots_->Undo(*mlp_)) {
+        return false;
+    }
+    weights_randomised_ = false;
+    if (rls_) {
+        rls_->Reset();
+    }
+    refresh_outputs();
+    log("Undo.");
+    return true;
+}
+
+template<typename Float>
+bool IML<Float>::redo() {
+    if (!snapshots_->Redo(*mlp_)) {
+        return false;
+    }
+    weights_randomised_ = false;
+    if (rls_) {
+        rls_->Reset();
+    }
+    refresh_outputs();
+    log("Redo.");
+    return true;
+}
+
 template<typename Float>
 void IML<Float>::train() {
+    NISPS_PROFILE_SCOPE("IML::train");
     // Restore weights if they were randomised
     if (weights_randomised_) {
-        mlp_->SetWeights(stored_weights_);
+        snapshots_->Undo(*mlp_);
         weights_randomised_ = false;
     }
 
@@ -189,14 +285,126 @@ void IML<Float>::train() {
         false  // output_log
     );
 
+    // The hidden features changed, so earlier online updates no longer apply
+    if (rls_) {
+        rls_->Reset();
+    }
+
     // Run inference after training
-    std::vector<Float> input_with_bias = input_state_;
-    input_with_bias.push_back(static_cast<Float>(1.0));
-    std::vector<Float> output(n_outputs_);
-    mlp_->GetOutput(input_with_bias, &output);
-    output_state_ = output;
+    refresh_outputs();
 
     log("Training complete.");
+
+    if (journal_ && !replaying_) {
+        checkpoint();
+    }
+}
+
+template<typename Float>
+void IML<Float>::set_online_adaptation(bool enabled) {
+    if (!enabled) {
+        rls_.reset();
+    } else if (!rls_) {
+        rls_ = std::make_unique<LastLayerRLS<Float>>(*mlp_);
+    }
+}
+
+template<typename Float>
+void IML<Float>::adapt(const std::vector<Float>& inputs, const std::vector<Float>& outputs) {
+    if (!rls_) {
+        return;
+    }
+    std::vector<Float> input_with_bias = inputs;
+    input_with_bias.push_back(static_cast<Float>(1.0));
+    rls_->Update(input_with_bias, outputs);
+}
+
+template<typename Float>
+void IML<Float>::refresh_outputs() {
+    // Called after every weight change, so incremental state restarts here
+    if (incremental_) {
+        incremental_->Reset();
+    }
+    std::copy(input_state_.begin(), input_state_.end(), input_with_bias_.begin());
+    mlp_->GetOutput(input_with_bias_, &output_state_);
+    outputs_refreshed_ = true;
+}
+
+template<typename Float>
+bool IML<Float>::checkpoint() {
+    if (!journal_) {
+        return false;
+    }
+    checkpoint_buffer_.resize(mlp_->SerialisedSize(ModelFormat::kSectionAll));
+    if (!mlp_->Serialise(checkpoint_buffer_, ModelFormat::kSectionAll)) {
+        return false;
+    }
+    return journal_->Checkpoint(static_cast<uint32_t>(mode_), checkpoint_buffer_, *dataset_);
+}
+
+template<typename Float>
+bool IML<Float>::recover(const std::string& filename) {
+    replaying_ = true;
+    bool needs_training = false;
+    std::vector<float> in_vec, out_vec;
+
+    bool ok = SessionJournal::Replay(filename, [&](const SessionJournal::Record& record) {
+        uint32_t mode;
+        switch (record.type) {
+            case SessionJournal::kCheckpoint: {
+                std::span<const uint8_t> model;
+                if (!SessionJournal::DecodeCheckpoint(record.payload, mode, model, *dataset_) ||
+                    !mlp_->FromSerialised(model, ModelFormat::kSectionAll)) {
+                    return false;
+                }
+                mode_ = static_cast<Mode>(mode);
+                needs_training = false;
+                break;
+            }
+            case SessionJournal::kAddExample:
+                if (!SessionJournal::DecodeExample(record.payload, in_vec, out_vec) ||
+                    in_vec.size() != n_inputs_ || out_vec.size() != n_outputs_) {
+                    return false;
+                }
+                dataset_->Add(in_vec, out_vec);
+                break;
+            case SessionJournal::kClearDataset:
+                dataset_->Clear();
+                break;
+            case SessionJournal::kModeChange:
+                if (!SessionJournal::DecodeModeChange(record.payload, mode)) {
+                    return false;
+                }
+                // Training that was interrupted before its checkpoint is redone below
+                if (static_cast<Mode>(mode) == Mode::Inference && mode_ == Mode::Training) {
+                    needs_training = true;
+                }
+                mode_ = static_cast<Mode>(mode);
+                break;
+        }
+        return true;
+    });
+
+    if (ok && needs_training) {
+        train();
+    }
+    replaying_ = false;
+    snapshots_->Clear();
+    if (rls_) {
+        rls_->Reset();
+    }
+    weights_randomised_ = false;
+    perform_inference_ = true;
+    refresh_outputs();
+
+    if (ok) {
+        log("Session recovered.");
+        // Start the live journal from the recovered state
+        if (journal_) {
+            checkpoint();
+        }
+    }
+    return ok;
 }
 
 } // namespace nisps
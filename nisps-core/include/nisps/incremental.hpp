@@ -0,0 +1,211 @@
+/**
+ * @file incremental.hpp
+ * @brief Delta-propagation inference for slowly changing inputs
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_INCREMENTAL_HPP
+#define NISPS_INCREMENTAL_HPP
+
+#include "mlp.hpp"
+
+#include <vector>
+#include <span>
+#include <cmath>
+
+namespace nisps {
+
+/**
+ * @class IncrementalInference
+ * @brief Updates an MLP's outputs from input changes instead of recomputing them.
+ *
+ * Each node's pre-activation is kept between calls. When input i moves by
+ * dx, the first layer's pre-activations are updated with z += W[:, i] * dx,
+ * touching one weight column instead of the whole matrix. A hidden unit is
+ * only propagated to the next layer when its activation has moved more than
+ * the tolerance since it was last propagated, so small ripples stop early.
+ *
+ * Rounding in the running sums and withheld sub-tolerance changes are
+ * bounded by a full recompute every full_recompute_period calls.
+ *
+ * Call Reset() whenever the network's weights change.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class IncrementalInference {
+ public:
+    /**
+     * @param mlp Network to evaluate
+     * @param tolerance Smallest hidden activation change that is propagated
+     * @param full_recompute_period Calls between full recomputes; 0 never forces one
+     */
+    explicit IncrementalInference(MLP<T> &mlp, T tolerance = static_cast<T>(1e-5),
+                                  size_t full_recompute_period = 256)
+        : mlp_(mlp),
+          tolerance_(tolerance),
+          period_(full_recompute_period) {
+        const size_t n_layers = mlp.m_layers.size();
+        z_.resize(n_layers);
+        a_.resize(n_layers);
+        delta_.resize(n_layers);
+        changed_.resize(n_layers);
+        for (size_t l = 0; l < n_layers; l++) {
+            const size_t n = mlp.m_layers[l].GetOutputSize();
+            z_[l].resize(n);
+            a_[l].resize(n);
+            delta_[l].resize(n);
+            changed_[l].reserve(n);
+        }
+        x_.resize(mlp.m_layers.empty() ? 0 : mlp.m_layers[0].GetInputSize());
+        dx_.resize(x_.size());
+        changed_inputs_.reserve(x_.size());
+        output_.resize(mlp.m_layers.empty() ? 0 : mlp.m_layers.back().GetOutputSize());
+    }
+
+    /**
+     * @brief Forces a full recompute on the next Process() call.
+     */
+    void Reset() {
+        valid_ = false;
+    }
+
+    /**
+     * @brief Evaluates the network for a new input.
+     * @param input Network input (including any bias input the network expects)
+     * @return Network outputs, valid until the next call
+     */
+    const std::vector<T> &Process(std::span<const T> input) {
+        if (input.size() != x_.size() || mlp_.m_layers.empty()) {
+            return output_;
+        }
+        if (!valid_ || (period_ && ++calls_ >= period_)) {
+            FullRecompute(input);
+        } else {
+            work_ = 0;
+            changed_inputs_.clear();
+            for (size_t i = 0; i < x_.size(); i++) {
+                if (input[i] != x_[i]) {
+                    dx_[i] = input[i] - x_[i];
+                    x_[i] = input[i];
+                    changed_inputs_.push_back(i);
+                }
+            }
+            if (!changed_inputs_.empty()) {
+                Propagate(changed_inputs_, dx_);
+            }
+        }
+        return output_;
+    }
+
+    /**
+     * @brief Multiply-accumulates performed by the last Process() call.
+     */
+    size_t GetLastWork() const { return work_; }
+
+ private:
+    /**
+     * @brief Applies input deltas to the first layer and continues with the units that moved.
+     */
+    void Propagate(const std::vector<size_t> &changed, const std::vector<T> &delta) {
+        const std::vector<size_t> *in_changed = &changed;
+        const std::vector<T> *in_delta = &delta;
+        const size_t n_layers = mlp_.m_layers.size();
+        for (size_t l = 0; l < n_layers; l++) {
+            auto &layer = mlp_.m_layers[l];
+            auto activation = layer.GetActivationFunction();
+            std::vector<T> &z = z_[l];
+            for (size_t j = 0; j < z.size(); j++) {
+                const T *w = layer.m_nodes[j].m_weights.data();
+                T acc = 0;
+                for (size_t i : *in_changed) {
+                    acc += w[i] * (*in_delta)[i];
+                }
+                z[j] += acc;
+            }
+            work_ += z.size() * in_changed->size();
+
+            if (l + 1 == n_layers) {
+                for (size_t j = 0; j < z.size(); j++) {
+                    output_[j] = activation(z[j]);
+                }
+                FinishOutput();
+                break;
+            }
+
+            // Only units that moved past the tolerance feed the next layer
+            std::vector<size_t> &moved = changed_[l];
+            moved.clear();
+            for (size_t j = 0; j < z.size(); j++) {
+                const T a = activation(z[j]);
+                if (std::abs(a - a_[l][j]) > tolerance_) {
+                    delta_[l][j] = a - a_[l][j];
+                    a_[l][j] = a;
+                    moved.push_back(j);
+                }
+            }
+            if (moved.empty()) {
+                break;
+            }
+            in_changed = &moved;
+            in_delta = &delta_[l];
+        }
+    }
+
+    void FullRecompute(std::span<const T> input) {
+        calls_ = 0;
+        work_ = 0;
+        std::copy(input.begin(), input.end(), x_.begin());
+        std::span<const T> in(x_);
+        const size_t n_layers = mlp_.m_layers.size();
+        for (size_t l = 0; l < n_layers; l++) {
+            auto &layer = mlp_.m_layers[l];
+            auto activation = layer.GetActivationFunction();
+            for (size_t j = 0; j < z_[l].size(); j++) {
+                const auto &node = layer.m_nodes[j];
+                T acc = node.m_bias;
+                for (size_t i = 0; i < in.size(); i++) {
+                    acc += node.m_weights[i] * in[i];
+                }
+                z_[l][j] = acc;
+                a_[l][j] = activation(acc);
+            }
+            work_ += z_[l].size() * in.size();
+            in = std::span<const T>(a_[l]);
+        }
+        std::copy(a_.back().begin(), a_.back().end(), output_.begin());
+        FinishOutput();
+        valid_ = true;
+    }
+
+    void FinishOutput() {
+        if (mlp_.GetLossFunctionType() == loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY &&
+            output_.size() > 1) {
+            utils::Softmax(&output_);
+        }
+    }
+
+    MLP<T> &mlp_;
+    const T tolerance_;
+    const size_t period_;
+    bool valid_ = false;
+    size_t calls_ = 0;
+    size_t work_ = 0;
+
+    std::vector<T> x_;                          /**< Input at the last call */
+    std::vector<T> dx_;
+    std::vector<size_t> changed_inputs_;
+    std::vector<std::vector<T>> z_;             /**< Pre-activations per layer */
+    std::vector<std::vector<T>> a_;             /**< Last propagated activations per layer */
+    std::vector<std::vector<T>> delta_;         /**< Activation deltas being propagated */
+    std::vector<std::vector<size_t>> changed_;  /**< Units that moved past the tolerance */
+    std::vector<T> output_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_INCREMENTAL_HPP
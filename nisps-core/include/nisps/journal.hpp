@@ -0,0 +1,558 @@
+/**
+ * @file journal.hpp
+ * @brief Append-only session journal with checkpoints and crash recovery
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Journal layout (all fields little-endian):
+ *
+ *   file header  16 bytes: magic "NSJL", u16 version, zero padding
+ *   record       u8 type, 3 bytes zero, u32 payload size, payload,
+ *                u32 CRC-32 of type, size and payload
+ *
+ * Records are appended in the order they happened. A checkpoint record
+ * holds the full model (weights and optimizer state), the dataset and the
+ * mode, so recovery only has to replay the records after the last intact
+ * checkpoint. A torn record at the end of the file (power cut mid-write)
+ * fails its CRC and is discarded.
+ *
+ * Every batch is synced to the storage device once written, so a power
+ * cut loses at most the records of one flush interval.
+ */
+
+#ifndef NISPS_JOURNAL_HPP
+#define NISPS_JOURNAL_HPP
+
+#include "binary_io.hpp"
+#include "spsc_ring.hpp"
+#include "dataset.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <span>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
+
+namespace nisps {
+
+/**
+ * @class SessionJournal
+ * @brief Log-structured persistence for an interactive training session.
+ *
+ * The Log*() methods only encode a record into a preallocated scratch
+ * buffer and push it into a wait-free ring, so they can be called from the
+ * control loop. A background writer thread drains the ring, checksums the
+ * records and appends them to the file in batches every flush interval.
+ * If a write fails (e.g. the disk is full) the journal stops appending,
+ * since records after a torn one could never be replayed, and reports it
+ * from HasWriteError(), Flush(), Checkpoint() and the Log*() methods.
+ *
+ * All Log*() and Checkpoint() calls must come from the same thread.
+ */
+class SessionJournal {
+ public:
+    /**
+     * @brief Record types stored in the journal.
+     */
+    enum RecordType : uint8_t {
+        kAddExample = 1,   /**< One input/output example added to the dataset */
+        kClearDataset = 2, /**< Dataset cleared */
+        kModeChange = 3,   /**< Training/inference mode changed */
+        kCheckpoint = 4    /**< Full model, dataset and mode snapshot */
+    };
+
+    /**
+     * @brief A record read back from the journal.
+     */
+    struct Record {
+        RecordType type;
+        std::span<const uint8_t> payload;
+    };
+
+    static constexpr char kMagic[4] = {'N', 'S', 'J', 'L'};
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kFileHeaderSize = 16;
+    static constexpr size_t kRecordHeaderSize = 8;
+    static constexpr size_t kRecordCrcSize = 4;
+    /** @brief Largest example (inputs plus outputs) that Log*() accepts. */
+    static constexpr size_t kMaxExampleValues = 512;
+
+    /**
+     * @brief Constructs a closed journal.
+     * @param ring_bytes Capacity of the queue between the control loop and the writer
+     * @param flush_interval_ms How often the writer appends queued records to the file
+     */
+    explicit SessionJournal(size_t ring_bytes = 64 * 1024,
+                            unsigned int flush_interval_ms = 50)
+        : ring_(ring_bytes),
+          flush_interval_(flush_interval_ms),
+          scratch_(kRecordHeaderSize + 8 + kMaxExampleValues * sizeof(float)) {}
+
+    ~SessionJournal() { Close(); }
+
+    SessionJournal(const SessionJournal &) = delete;
+    SessionJournal &operator=(const SessionJournal &) = delete;
+
+    /**
+     * @brief Opens a journal for appending, creating it if needed, and starts the writer.
+     *
+     * An existing journal is validated and any torn record at its end is
+     * truncated before new records are appended.
+     *
+     * @param filename Path to the journal file
+     * @return false if the file cannot be created or is not a journal
+     */
+    bool Open(const std::string &filename) {
+        Close();
+        std::vector<uint8_t> bytes;
+        if (ReadFile(filename, bytes)) {
+            size_t valid_end = 0;
+            if (!Scan(bytes, valid_end, nullptr)) {
+                return false;
+            }
+            if (valid_end != bytes.size()) {
+                std::error_code ec;
+                std::filesystem::resize_file(filename, valid_end, ec);
+                if (ec) {
+                    return false;
+                }
+            }
+            file_ = fopen(filename.c_str(), "ab");
+        } else {
+            file_ = fopen(filename.c_str(), "wb");
+            if (file_) {
+                uint8_t header[kFileHeaderSize] = {};
+                std::memcpy(header, kMagic, sizeof(kMagic));
+                binary_io::Store<uint16_t>(header + 4, kVersion);
+                if (fwrite(header, sizeof(header), 1, file_) != 1) {
+                    fclose(file_);
+                    file_ = nullptr;
+                }
+            }
+        }
+        if (!file_) {
+            return false;
+        }
+        stop_ = false;
+        write_error_.store(false, std::memory_order_relaxed);
+        writer_ = std::thread(&SessionJournal::WriterLoop, this);
+        return true;
+    }
+
+    /**
+     * @brief Writes everything queued, then stops the writer and closes the file.
+     */
+    void Close() {
+        if (writer_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            writer_.join();
+        }
+        if (file_) {
+            fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    bool IsOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Queues an added example. Real-time safe.
+     * @return false if the journal is closed, the example is too large or the queue is full
+     */
+    bool LogExample(const float *inputs, size_t n_in, const float *outputs, size_t n_out) {
+        if (n_in + n_out > kMaxExampleValues) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint8_t *payload = scratch_.data() + kRecordHeaderSize;
+        binary_io::Store<uint32_t>(payload, static_cast<uint32_t>(n_in));
+        binary_io::Store<uint32_t>(payload + 4, static_cast<uint32_t>(n_out));
+        binary_io::StoreArray(payload + 8, inputs, n_in);
+        binary_io::StoreArray(payload + 8 + n_in * sizeof(float), outputs, n_out);
+        return Push(kAddExample, 8 + (n_in + n_out) * sizeof(float));
+    }
+
+    /**
+     * @brief Queues a dataset clear. Real-time safe.
+     */
+    bool LogClearDataset() {
+        return Push(kClearDataset, 0);
+    }
+
+    /**
+     * @brief Queues a mode change. Real-time safe.
+     * @param mode Application-defined mode value
+     */
+    bool LogModeChange(uint32_t mode) {
+        binary_io::Store<uint32_t>(scratch_.data() + kRecordHeaderSize, mode);
+        return Push(kModeChange, 4);
+    }
+
+    /**
+     * @brief Queues a checkpoint after all previously logged records. Not real-time safe.
+     *
+     * @param mode Application-defined mode value at the checkpoint
+     * @param model Serialised model container (see MLP::Serialise())
+     * @param dataset Dataset contents at the checkpoint
+     * @return false if the journal is closed or a write has failed; a failure
+     *         writing this checkpoint is reported by Flush() and later calls
+     */
+    bool Checkpoint(uint32_t mode, std::span<const uint8_t> model, Dataset &dataset) {
+        if (!file_ || HasWriteError()) {
+            return false;
+        }
+        Dataset::DatasetVector *features, *labels;
+        dataset.Fetch(features, labels);
+        const size_t n_rows = features->size();
+        const size_t n_in = n_rows ? (*features)[0].size() : 0;
+        const size_t n_out = n_rows ? (*labels)[0].size() : 0;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Only one checkpoint may be in flight at a time
+        done_cv_.wait(lock, [this] { return pending_checkpoint_.empty(); });
+        std::vector<uint8_t> &p = pending_checkpoint_;
+        p.resize(kRecordHeaderSize + 8 + model.size() + 12 + n_rows * (n_in + n_out) * sizeof(float));
+        uint8_t *dst = p.data() + kRecordHeaderSize;
+        binary_io::Store<uint32_t>(dst, mode);
+        binary_io::Store<uint32_t>(dst + 4, static_cast<uint32_t>(model.size()));
+        std::memcpy(dst + 8, model.data(), model.size());
+        dst += 8 + model.size();
+        binary_io::Store<uint32_t>(dst, static_cast<uint32_t>(n_rows));
+        binary_io::Store<uint32_t>(dst + 4, static_cast<uint32_t>(n_in));
+        binary_io::Store<uint32_t>(dst + 8, static_cast<uint32_t>(n_out));
+        dst += 12;
+        for (size_t i = 0; i < n_rows; i++) {
+            binary_io::StoreArray(dst, (*features)[i].data(), n_in);
+            dst += n_in * sizeof(float);
+            binary_io::StoreArray(dst, (*labels)[i].data(), n_out);
+            dst += n_out * sizeof(float);
+        }
+        EncodeRecordHeader(p.data(), kCheckpoint, p.size() - kRecordHeaderSize);
+        lock.unlock();
+
+        // An empty checkpoint record in the queue marks where the snapshot goes
+        uint8_t marker[kRecordHeaderSize];
+        EncodeRecordHeader(marker, kCheckpoint, 0);
+        while (!ring_.TryPush(marker, sizeof(marker))) {
+            cv_.notify_all();
+            std::this_thread::yield();
+        }
+        cv_.notify_all();
+        return true;
+    }
+
+    /**
+     * @brief Blocks until every record queued so far has been written and synced.
+     * @return false if the journal is closed or a write has failed
+     */
+    bool Flush() {
+        if (!writer_.joinable()) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t request = ++flush_requested_;
+        cv_.notify_all();
+        done_cv_.wait(lock, [&] { return flush_completed_ >= request; });
+        return !HasWriteError();
+    }
+
+    /**
+     * @brief True once a write, flush or sync has failed; cleared by Open().
+     */
+    bool HasWriteError() const {
+        return write_error_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of records dropped because the queue was full or they were too large.
+     */
+    size_t GetDroppedRecords() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Reads a journal and replays it from the last intact checkpoint.
+     *
+     * @param filename Path to the journal file
+     * @param fn Called for each record in order; returning false aborts the replay
+     * @return false if the file is missing or invalid, or fn aborted
+     */
+    static bool Replay(const std::string &filename, const std::function<bool(const Record &)> &fn) {
+        std::vector<uint8_t> bytes;
+        size_t valid_end = 0;
+        std::vector<Record> records;
+        if (!ReadFile(filename, bytes) || !Scan(bytes, valid_end, &records)) {
+            return false;
+        }
+        size_t first = 0;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (records[i].type == kCheckpoint) {
+                first = i;
+            }
+        }
+        for (size_t i = first; i < records.size(); i++) {
+            if (!fn(records[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Decodes a kAddExample payload.
+     */
+    static bool DecodeExample(std::span<const uint8_t> payload,
+                              std::vector<float> &inputs, std::vector<float> &outputs) {
+        if (payload.size() < 8) {
+            return false;
+        }
+        const size_t n_in = binary_io::Load<uint32_t>(payload.data());
+        const size_t n_out = binary_io::Load<uint32_t>(payload.data() + 4);
+        if (payload.size() != 8 + (n_in + n_out) * sizeof(float)) {
+            return false;
+        }
+        inputs.resize(n_in);
+        outputs.resize(n_out);
+        binary_io::LoadArray(inputs.data(), payload.data() + 8, n_in);
+        binary_io::LoadArray(outputs.data(), payload.data() + 8 + n_in * sizeof(float), n_out);
+        return true;
+    }
+
+    /**
+     * @brief Decodes a kModeChange payload.
+     */
+    static bool DecodeModeChange(std::span<const uint8_t> payload, uint32_t &mode) {
+        if (payload.size() != 4) {
+            return false;
+        }
+        mode = binary_io::Load<uint32_t>(payload.data());
+        return true;
+    }
+
+    /**
+     * @brief Decodes a kCheckpoint payload, loading its rows into a dataset.
+     *
+     * @param payload Record payload
+     * @param mode Receives the mode at the checkpoint
+     * @param model Receives a view of the serialised model inside the payload
+     * @param dataset Receives the dataset contents
+     */
+    static bool DecodeCheckpoint(std::span<const uint8_t> payload, uint32_t &mode,
+                                 std::span<const uint8_t> &model, Dataset &dataset) {
+        if (payload.size() < 8) {
+            return false;
+        }
+        mode = binary_io::Load<uint32_t>(payload.data());
+        const size_t model_size = binary_io::Load<uint32_t>(payload.data() + 4);
+        if (payload.size() < 8 + model_size + 12) {
+            return false;
+        }
+        model = payload.subspan(8, model_size);
+        const uint8_t *src = payload.data() + 8 + model_size;
+        const size_t n_rows = binary_io::Load<uint32_t>(src);
+        const size_t n_in = binary_io::Load<uint32_t>(src + 4);
+        const size_t n_out = binary_io::Load<uint32_t>(src + 8);
+        src += 12;
+        if (payload.size() != 8 + model_size + 12 + n_rows * (n_in + n_out) * sizeof(float)) {
+            return false;
+        }
+        Dataset::DatasetVector features(n_rows, std::vector<float>(n_in));
+        Dataset::DatasetVector labels(n_rows, std::vector<float>(n_out));
+        for (size_t i = 0; i < n_rows; i++) {
+            binary_io::LoadArray(features[i].data(), src, n_in);
+            src += n_in * sizeof(float);
+            binary_io::LoadArray(labels[i].data(), src, n_out);
+            src += n_out * sizeof(float);
+        }
+        dataset.Clear();
+        dataset.Load(features, labels);
+        return true;
+    }
+
+ private:
+    static void EncodeRecordHeader(uint8_t *dst, RecordType type, size_t payload_size) {
+        dst[0] = type;
+        dst[1] = dst[2] = dst[3] = 0;
+        binary_io::Store<uint32_t>(dst + 4, static_cast<uint32_t>(payload_size));
+    }
+
+    bool Push(RecordType type, size_t payload_size) {
+        if (!file_ || HasWriteError()) {
+            return false;
+        }
+        EncodeRecordHeader(scratch_.data(), type, payload_size);
+        if (!ring_.TryPush(scratch_.data(), kRecordHeaderSize + payload_size)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    static bool ReadFile(const std::string &filename, std::vector<uint8_t> &bytes) {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        bool ok = fseek(file, 0, SEEK_END) == 0;
+        long size = ok ? ftell(file) : -1;
+        ok = ok && size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+        if (ok) {
+            bytes.resize(static_cast<size_t>(size));
+            ok = bytes.empty() || fread(bytes.data(), bytes.size(), 1, file) == 1;
+        }
+        fclose(file);
+        return ok;
+    }
+
+    /**
+     * @brief Validates the file header and walks intact records.
+     * @param bytes Whole journal
+     * @param valid_end Receives the end offset of the last intact record
+     * @param records If not null, receives the intact records
+     * @return false if the file header is invalid
+     */
+    static bool Scan(std::span<const uint8_t> bytes, size_t &valid_end, std::vector<Record> *records) {
+        if (bytes.size() < kFileHeaderSize ||
+            std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0 ||
+            binary_io::Load<uint16_t>(bytes.data() + 4) != kVersion) {
+            return false;
+        }
+        size_t offset = kFileHeaderSize;
+        while (offset + kRecordHeaderSize + kRecordCrcSize <= bytes.size()) {
+            const uint8_t *rec = bytes.data() + offset;
+            const size_t payload_size = binary_io::Load<uint32_t>(rec + 4);
+            const size_t body = kRecordHeaderSize + payload_size;
+            if (payload_size > bytes.size() - offset - kRecordHeaderSize - kRecordCrcSize ||
+                rec[0] < kAddExample || rec[0] > kCheckpoint ||
+                binary_io::Load<uint32_t>(rec + body) != binary_io::Crc32(rec, body)) {
+                break;
+            }
+            if (records) {
+                records->push_back({ static_cast<RecordType>(rec[0]),
+                                     bytes.subspan(offset + kRecordHeaderSize, payload_size) });
+            }
+            offset += body + kRecordCrcSize;
+        }
+        valid_end = offset;
+        return true;
+    }
+
+    /**
+     * @brief Appends one record with its CRC to the write batch.
+     */
+    void Stage(const uint8_t *record, size_t size) {
+        const size_t at = batch_.size();
+        batch_.resize(at + size + kRecordCrcSize);
+        std::memcpy(batch_.data() + at, record, size);
+        binary_io::Store<uint32_t>(batch_.data() + at + size, binary_io::Crc32(record, size));
+    }
+
+    /**
+     * @brief Moves every queued record into the write batch.
+     */
+    void Drain() {
+        uint8_t header[kRecordHeaderSize];
+        while (ring_.TryPop(header, kRecordHeaderSize) == kRecordHeaderSize) {
+            const size_t payload_size = binary_io::Load<uint32_t>(header + 4);
+            if (header[0] == kCheckpoint && payload_size == 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!pending_checkpoint_.empty()) {
+                    Stage(pending_checkpoint_.data(), pending_checkpoint_.size());
+                    pending_checkpoint_.clear();
+                    done_cv_.notify_all();
+                }
+                continue;
+            }
+            record_.resize(kRecordHeaderSize + payload_size);
+            std::memcpy(record_.data(), header, kRecordHeaderSize);
+            // Records are pushed whole, so the payload is already in the ring
+            ring_.TryPop(record_.data() + kRecordHeaderSize, payload_size);
+            Stage(record_.data(), record_.size());
+        }
+    }
+
+    /**
+     * @brief Pushes the file's written data to the storage device.
+     */
+    static bool SyncFile(FILE *file) {
+#if defined(__unix__) || defined(__APPLE__)
+        return fsync(fileno(file)) == 0;
+#elif defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#else
+        return fflush(file) == 0;
+#endif
+    }
+
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait_for(lock, flush_interval_, [this] {
+                return stop_ || flush_completed_ < flush_requested_ || !pending_checkpoint_.empty();
+            });
+            const bool stopping = stop_;
+            const uint64_t request = flush_requested_;
+            lock.unlock();
+
+            // Still drained after a failure, so producers and checkpoints never block on it
+            Drain();
+            if (!batch_.empty() && !HasWriteError()) {
+                if (fwrite(batch_.data(), batch_.size(), 1, file_) != 1 ||
+                    fflush(file_) != 0 || !SyncFile(file_)) {
+                    write_error_.store(true, std::memory_order_release);
+                }
+            }
+            batch_.clear();
+
+            lock.lock();
+            flush_completed_ = request;
+            done_cv_.notify_all();
+            if (stopping) {
+                break;
+            }
+        }
+    }
+
+    SpscRing<uint8_t> ring_;
+    std::chrono::milliseconds flush_interval_;
+    std::vector<uint8_t> scratch_;          /**< Producer-side record encoding buffer */
+    std::vector<uint8_t> record_;           /**< Writer-side record buffer */
+    std::vector<uint8_t> batch_;            /**< Writer-side batch of records for one fwrite */
+    std::vector<uint8_t> pending_checkpoint_;
+    std::atomic<size_t> dropped_{0};
+    std::atomic<bool> write_error_{false};  /**< Sticky until the next Open() */
+
+    FILE *file_ = nullptr;
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    bool stop_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_JOURNAL_HPP
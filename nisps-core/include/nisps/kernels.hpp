@@ -0,0 +1,190 @@
+/**
+ * @file kernels.hpp
+ * @brief Flat-buffer numeric kernels
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Plain loops over contiguous arrays with no aliasing between inputs and
+ * outputs, written so the compiler can vectorize them on any target.
+ */
+
+#ifndef NISPS_KERNELS_HPP
+#define NISPS_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace nisps {
+
+namespace kernels {
+
+/** @brief Elements processed per block, sized to stay in L1 across all sources. */
+constexpr size_t kBlockSize = 256;
+
+/**
+ * @brief dst[i] = sum_k weights[k] * srcs[k][i]
+ *
+ * Walks the arrays once in blocks; within a block the partial sum stays in
+ * cache while each source is accumulated.
+ *
+ * @param srcs Array of num_srcs source pointers, each of n values
+ * @param weights Array of num_srcs weights
+ * @param num_srcs Number of sources, at least 1
+ * @param dst Destination of n values, not overlapping any source
+ * @param n Number of values
+ */
+template<typename T>
+inline void WeightedSum(const T *const *srcs, const T *weights, size_t num_srcs,
+                        T *__restrict dst, size_t n) {
+    for (size_t start = 0; start < n; start += kBlockSize) {
+        const size_t len = (n - start < kBlockSize) ? n - start : kBlockSize;
+        T *__restrict out = dst + start;
+        {
+            const T *__restrict in = srcs[0] + start;
+            const T w = weights[0];
+            for (size_t i = 0; i < len; i++) {
+                out[i] = w * in[i];
+            }
+        }
+        for (size_t k = 1; k < num_srcs; k++) {
+            const T *__restrict in = srcs[k] + start;
+            const T w = weights[k];
+            for (size_t i = 0; i < len; i++) {
+                out[i] += w * in[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief y = W x + b for a dense row-major matrix
+ *
+ * @param w rows x cols weights, row-major
+ * @param bias rows values
+ * @param rows Number of outputs
+ * @param cols Number of inputs
+ * @param x cols input values
+ * @param y rows output values, not overlapping any input
+ */
+template<typename T>
+inline void Gemv(const T *__restrict w, const T *__restrict bias, size_t rows, size_t cols,
+                 const T *__restrict x, T *__restrict y) {
+    for (size_t r = 0; r < rows; r++) {
+        const T *__restrict row = w + r * cols;
+        T acc = 0;
+        for (size_t c = 0; c < cols; c++) {
+            acc += row[c] * x[c];
+        }
+        y[r] = acc + bias[r];
+    }
+}
+
+/**
+ * @brief y += W^T x for a dense row-major matrix
+ *
+ * Walks W by rows, so the inner loop runs over contiguous columns.
+ *
+ * @param w rows x cols weights, row-major
+ * @param rows Number of rows (length of x)
+ * @param cols Number of columns (length of y)
+ * @param x rows input values
+ * @param y cols values to accumulate into, not overlapping any input
+ */
+template<typename T>
+inline void GemvT(const T *__restrict w, size_t rows, size_t cols, const T *__restrict x, T *__restrict y) {
+    for (size_t r = 0; r < rows; r++) {
+        const T *__restrict row = w + r * cols;
+        const T xr = x[r];
+        for (size_t c = 0; c < cols; c++) {
+            y[c] += row[c] * xr;
+        }
+    }
+}
+
+/**
+ * @brief G += a b^T, the rank-1 update that accumulates a dense layer's weight gradient
+ *
+ * @param g rows x cols values, row-major
+ * @param rows Length of a
+ * @param cols Length of b
+ * @param a rows values
+ * @param b cols values
+ */
+template<typename T>
+inline void Ger(T *__restrict g, size_t rows, size_t cols, const T *__restrict a, const T *__restrict b) {
+    for (size_t r = 0; r < rows; r++) {
+        T *__restrict row = g + r * cols;
+        const T ar = a[r];
+        for (size_t c = 0; c < cols; c++) {
+            row[c] += ar * b[c];
+        }
+    }
+}
+
+/**
+ * @brief y = W x + b for a matrix in compressed sparse row format
+ *
+ * @param row_ptr rows + 1 offsets into col_idx and values
+ * @param col_idx Column of each stored value
+ * @param values Stored (non-zero) weights
+ * @param bias rows values
+ * @param rows Number of outputs
+ * @param x Input values
+ * @param y rows output values, not overlapping any input
+ */
+template<typename T>
+inline void CsrGemv(const uint32_t *__restrict row_ptr, const uint32_t *__restrict col_idx,
+                    const T *__restrict values, const T *__restrict bias, size_t rows,
+                    const T *__restrict x, T *__restrict y) {
+    for (size_t r = 0; r < rows; r++) {
+        T acc = 0;
+        for (uint32_t k = row_ptr[r]; k < row_ptr[r + 1]; k++) {
+            acc += values[k] * x[col_idx[k]];
+        }
+        y[r] = acc + bias[r];
+    }
+}
+
+/**
+ * @brief s[i] = sin(2 pi t[i]), c[i] = cos(2 pi t[i])
+ *
+ * Branch-free, so it vectorizes: t is reduced to [-1/2, 1/2] turns by
+ * rounding with a magic constant, sin and cos of the half angle come from
+ * Taylor polynomials on [-pi/2, pi/2], and the double-angle formulas
+ * give the result. The absolute error is below 4e-7 plus the error
+ * already in t's fractional part; |t| must stay below 2^22 (float) or
+ * 2^51 (double) for the rounding to work.
+ *
+ * @param t n values in turns
+ * @param s n sines, not overlapping t
+ * @param c n cosines, not overlapping t or s
+ * @param n Number of values
+ */
+template<typename T>
+inline void SinCos2Pi(const T *__restrict t, T *__restrict s, T *__restrict c, size_t n) {
+    static_assert(std::is_floating_point_v<T>, "SinCos2Pi needs a floating-point type");
+    // Adding and subtracting 1.5 * 2^mantissa rounds to the nearest integer
+    constexpr T kRound = std::is_same_v<T, float> ? T(12582912.0) : T(6755399441055744.0);
+    constexpr T kPi = T(3.14159265358979323846);
+    for (size_t i = 0; i < n; i++) {
+        const T k = (t[i] + kRound) - kRound;
+        const T h = (t[i] - k) * kPi;  // Half angle, in [-pi/2, pi/2]
+        const T h2 = h * h;
+        const T sh = h * (T(1) + h2 * (T(-1.0 / 6) + h2 * (T(1.0 / 120) + h2 * (T(-1.0 / 5040) +
+                     h2 * (T(1.0 / 362880) + h2 * T(-1.0 / 39916800))))));
+        const T ch = T(1) + h2 * (T(-0.5) + h2 * (T(1.0 / 24) + h2 * (T(-1.0 / 720) +
+                     h2 * (T(1.0 / 40320) + h2 * (T(-1.0 / 3628800) + h2 * T(1.0 / 479001600))))));
+        s[i] = T(2) * sh * ch;
+        c[i] = ch * ch - sh * sh;
+    }
+}
+
+}  // namespace kernels
+
+}  // namespace nisps
+
+#endif  // NISPS_KERNELS_HPP
@@ -15,6 +15,7 @@
 #define NISPS_LAYER_HPP
 
 #include <vector>
+#include <memory_resource>
 #include <algorithm>
 #include <cassert> // for assert()
 #include "node.hpp"
@@ -40,12 +41,18 @@ using activation_func_t = T(*)(T);
 template<typename T>
 class Layer {
 public:
+  /**
+   * @brief Nodes, and through them their weights, are allocated from this allocator's resource
+   */
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
   /**
    * @brief Default constructor
+   * @param alloc Allocator for the nodes and layer buffers
    */
-  Layer() {
+  explicit Layer(const allocator_type &alloc = {})
+    : m_nodes(alloc), cachedOutputs(alloc), grads(alloc) {
     m_num_nodes = 0;
-    m_nodes.clear();
   };
 
   /**
@@ -55,12 +62,17 @@ public:
    * @param activation_function Activation function type for all nodes
    * @param use_constant_weight_init Flag to use constant weight initialization
    * @param constant_weight_init Value for constant weight initialization
+   * @param rng Generator for random initialization; the thread's generator if null
+   * @param alloc Allocator for the nodes and layer buffers
    */
   Layer(int num_inputs_per_node,
         int num_nodes,
         const ACTIVATION_FUNCTIONS & activation_function,
         bool use_constant_weight_init = true,
-        T constant_weight_init = 0.5) {
+        T constant_weight_init = 0.5,
+        Random *rng = nullptr,
+        const allocator_type &alloc = {})
+    : Layer(alloc) {
     m_num_inputs_per_node = num_inputs_per_node;
     m_num_nodes = num_nodes;
     m_nodes.resize(num_nodes);
@@ -78,12 +90,55 @@ public:
     for (int i = 0; i < num_nodes; i++) {
       m_nodes[i].WeightInitialization(num_inputs_per_node,
                                       use_constant_weight_init,
-                                      constant_weight_init);
+                                      constant_weight_init,
+                                      rng);
     }
 
     // InitXavier();
   };
 
+  Layer(const Layer &other) = default;
+  Layer(Layer &&other) = default;
+  Layer &operator=(const Layer &other) = default;
+  Layer &operator=(Layer &&other) = default;
+
+  /**
+   * @brief Copies a layer into another memory resource
+   */
+  Layer(const Layer &other, const allocator_type &alloc)
+    : m_nodes(other.m_nodes, alloc),
+      cachedOutputs(other.cachedOutputs, alloc),
+      m_num_inputs_per_node(other.m_num_inputs_per_node),
+      m_num_nodes(other.m_num_nodes),
+      m_activation_function_type(other.m_activation_function_type),
+      m_activation_function(other.m_activation_function),
+      m_deriv_activation_function(other.m_deriv_activation_function),
+      m_cacheOutputs(other.m_cacheOutputs),
+      grads(other.grads, alloc) {
+  }
+
+  /**
+   * @brief Moves a layer; copies if the resources differ
+   */
+  Layer(Layer &&other, const allocator_type &alloc)
+    : m_nodes(std::move(other.m_nodes), alloc),
+      cachedOutputs(std::move(other.cachedOutputs), alloc),
+      m_num_inputs_per_node(other.m_num_inputs_per_node),
+      m_num_nodes(other.m_num_nodes),
+      m_activation_function_type(other.m_activation_function_type),
+      m_activation_function(other.m_activation_function),
+      m_deriv_activation_function(other.m_deriv_activation_function),
+      m_cacheOutputs(other.m_cacheOutputs),
+      grads(std::move(other.grads), alloc) {
+  }
+
+  /**
+   * @brief Allocator of the nodes and layer buffers
+   */
+  allocator_type get_allocator() const {
+    return m_nodes.get_allocator();
+  }
+
   /**
    * @brief Destructor
    */
@@ -122,6 +177,30 @@ public:
     return m_num_nodes;
   };
 
+  /**
+   * @brief Gets the activation function type of the layer
+   * @return Activation function type
+   */
+  ACTIVATION_FUNCTIONS GetActivationFunctionType() const {
+    return m_activation_function_type;
+  }
+
+  /**
+   * @brief Gets the activation function of the layer
+   * @return Pointer to the activation function
+   */
+  activation_func_t<T> GetActivationFunction() const {
+    return m_activation_function;
+  }
+
+  /**
+   * @brief Gets the derivative of the layer's activation function
+   * @return Pointer to the derivative, taking the pre-activation
+   */
+  activation_func_t<T> GetDerivActivationFunction() const {
+    return m_deriv_activation_function;
+  }
+
   /**
    * @brief Gets the list of nodes in the layer
    * @return Constant reference to the list of nodes
@@ -134,7 +213,7 @@ public:
    * @brief Return the internal list of nodes, but modifiable
    * @return Reference to the list of nodes
    */
-  std::vector<Node<T>> & GetNodesChangeable() {
+  std::pmr::vector<Node<T>> & GetNodesChangeable() {
     return m_nodes;
   }
 
@@ -160,7 +239,7 @@ public:
       // sleep_us(70);
     }
     if (m_cacheOutputs) {
-      cachedOutputs = *output;
+      cachedOutputs.assign(output->begin(), output->end());
     }
   }
 
@@ -357,7 +436,7 @@ public:
         (*deltas)[j] += dE_doj * doj_dnetj * m_nodes[i].GetWeights()[j];
       }
     }
-    grads = *deltas;
+    grads.assign(deltas->begin(), deltas->end());
   };
 
   /**
@@ -365,14 +444,14 @@ public:
    * @param newGrads New gradients to set
    */
   void SetGrads(std::vector<T> newGrads) {
-    grads = newGrads;
+    grads.assign(newGrads.begin(), newGrads.end());
   }
 
   /**
    * @brief Gets the stored gradients
    * @return Reference to the stored gradients
    */
-  std::vector<T>& GetGrads() {
+  std::pmr::vector<T>& GetGrads() {
     return grads;
   }
 
@@ -417,7 +496,7 @@ public:
 
       // Sum weights
       for(size_t n = 0; n < m_nodes.size(); n++) {
-          const std::vector<T>& weight_grads = m_nodes[n].GetWeights();
+          const auto& weight_grads = m_nodes[n].GetWeights();
           for (const auto& grad : weight_grads) {
               sum_sq += grad * grad;
           }
@@ -426,7 +505,7 @@ public:
       return std::sqrt(sum_sq);
   }
 
-  void InitXavier() {
+  void InitXavier(Random &rng) {
 
     float limit = (T)1.0;
 
@@ -445,11 +524,9 @@ public:
           limit = std::sqrt(6.0f / (m_num_inputs_per_node + m_num_nodes));
           break;
       }
-    utils::gen_rand<T> randf(limit);
+    const T half = static_cast<T>(limit * 0.5f);
     for(auto & node : m_nodes) {
-        for(auto & weight : node.GetWeights()) {
-            weight = randf();
-        }
+        rng.FillUniform(std::span<T>(node.GetWeights()), -half, half);
     }
   }
 
@@ -515,9 +592,9 @@ public:
     return true;
   };
 
-  std::vector<Node<T>> m_nodes;
+  std::pmr::vector<Node<T>> m_nodes;
 
-  std::vector<T> cachedOutputs;
+  std::pmr::vector<T> cachedOutputs;
 
   size_t m_num_inputs_per_node{ 0 }; /**< Number of inputs per node in this layer */
   size_t m_num_nodes{ 0 };           /**< Number of nodes in this layer */
@@ -528,7 +605,7 @@ protected:
   activation_func_t<T> m_deriv_activation_function;             /**< Pointer to derivative of activation function */
 
   bool m_cacheOutputs{false};                                   /**< Flag controlling output caching */
-  std::vector<T> grads;                                         /**< Stored gradients for optimization */
+  std::pmr::vector<T> grads;                                    /**< Stored gradients for optimization */
 };
 
 } // namespace nisps
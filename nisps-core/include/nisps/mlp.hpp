@@ -25,11 +25,21 @@
 #include "utils.hpp"
 #include "loss.hpp"
 #include "sample.hpp"
+#include "model_format.hpp"
+#include "profile.hpp"
+#include "realtime.hpp"
+#include "telemetry.hpp"
+#include "frozen.hpp"
+#include "fourier_features.hpp"
 
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
 #include <functional>
+#include <span>
+#include <chrono>
 
 namespace nisps {
 
@@ -67,33 +77,193 @@ public:
      * @param loss_function Loss function for training (default: MSE)
      * @param use_constant_weight_init Whether to use constant weight initialization (default: false)
      * @param constant_weight_init Value for constant weight initialization if enabled (default: 0.5)
+     * @param resource Where the layers, weights, gradient accumulators and optimizer state are allocated
      */
     MLP(const std::vector<size_t> & layers_nodes,
         const std::vector<ACTIVATION_FUNCTIONS> & layers_activfuncs,
         loss::LOSS_FUNCTIONS loss_function = loss::LOSS_FUNCTIONS::LOSS_MSE,
         bool use_constant_weight_init = false,
-        T constant_weight_init = 0.5);
+        T constant_weight_init = 0.5,
+        std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
     MLP(const std::string & filename);
     ~MLP();
 
     /**
-     * @brief Save the MLP network to a file
+     * @brief Save the MLP network to a file in the legacy host-endian format
      * @param filename Path to the file where the network will be saved
      * @return true if save was successful, false if there was an error
      */
     bool SaveMLPNetwork(const std::string & filename) const;
 
     /**
-     * @brief Load the MLP network from a file
+     * @brief Load the MLP network from a file in the legacy host-endian format
      * @param filename Path to the file containing the network
      * @return true if load was successful, false if file doesn't exist or there was an error
      */
     bool LoadMLPNetwork(const std::string & filename);
 
-    // Binary serialization methods - not currently implemented in nisps-core
-    // size_t Serialise(size_t w_head, std::vector<uint8_t> &buffer);
-    // size_t FromSerialised(size_t w_head, const std::vector<uint8_t> &buffer);
+    /**
+     * @brief Save the network in the versioned model container (see model_format.hpp)
+     *
+     * The whole container is written with a single fwrite.
+     *
+     * @param filename Path to the file where the model will be saved
+     * @param sections ModelFormat::kSection* flags to include
+     * @return true if save was successful
+     */
+    bool SaveModel(const std::string & filename,
+                   uint32_t sections = ModelFormat::kSectionWeights) const;
+
+    /**
+     * @brief Load a network saved with SaveModel()
+     *
+     * The file is read with a single fread into a reused buffer. If the
+     * stored topology matches the current one, weights are copied into the
+     * existing layers without reallocating.
+     *
+     * @param filename Path to the model file
+     * @return true if the file was valid and loaded; on failure the network is unchanged
+     */
+    bool LoadModel(const std::string & filename);
+
+    /**
+     * @brief Load a network from a model container already in memory (e.g. mmapped)
+     *
+     * Rebuilds the topology if it differs. Optimizer state and the input
+     * embedding are restored when the container holds them, and reset
+     * otherwise.
+     *
+     * @param bytes Container bytes
+     * @return true if the container was valid and loaded; on failure the network is unchanged
+     */
+    bool LoadModel(std::span<const uint8_t> bytes);
+
+    /**
+     * @brief Get the exact number of bytes Serialise() needs
+     * @param sections ModelFormat::kSection* flags to include
+     */
+    size_t SerialisedSize(uint32_t sections = ModelFormat::kSectionWeights) const;
+
+    /**
+     * @brief Serialise the network into a caller-provided buffer without allocating
+     *
+     * Writes a model container, so the result can also be stored as a file
+     * or passed to LoadModel().
+     *
+     * @param buffer Destination; at least SerialisedSize(sections) bytes
+     * @param sections ModelFormat::kSection* flags to include
+     * @return Bytes written, or 0 if the buffer is too small
+     */
+    size_t Serialise(std::span<uint8_t> buffer,
+                     uint32_t sections = ModelFormat::kSectionWeights) const;
+
+    /**
+     * @brief Update the network in place from a serialised container without allocating
+     *
+     * Only the requested sections are applied, e.g. weights only or
+     * optimizer state only. The container must have the same topology as
+     * this network; use LoadModel() to switch topology. Applying the
+     * embedding section allocates if the embedding changes size.
+     *
+     * @param buffer Container bytes
+     * @param sections ModelFormat::kSection* flags to apply; all must be present
+     * @return true if applied; on failure the network is unchanged
+     */
+    bool FromSerialised(std::span<const uint8_t> buffer,
+                        uint32_t sections = ModelFormat::kSectionWeights);
+
+    /**
+     * @brief Get the total number of weights and biases in the network
+     */
+    size_t GetNumParameters() const;
+
+    /**
+     * @brief Copy all weights and biases into a flat buffer
+     *
+     * Per layer: node-major weight rows followed by the node biases, the
+     * same order as the weights section of the model container.
+     *
+     * @param params Destination of exactly GetNumParameters() values
+     * @return false if the size does not match
+     */
+    bool GetParameters(std::span<T> params) const;
+
+    /**
+     * @brief Overwrite all weights and biases from a flat buffer
+     * @param params GetNumParameters() values in GetParameters() order
+     * @return false if the size does not match; the network is then unchanged
+     */
+    bool SetParameters(std::span<const T> params);
+
+    /**
+     * @brief Get the number of weights and biases in one layer
+     */
+    size_t GetNumLayerParameters(size_t layer_i) const;
+
+    /**
+     * @brief Copy one layer's weights and biases into a flat buffer
+     *
+     * The layer's slice of the GetParameters() layout.
+     *
+     * @param layer_i Layer index
+     * @param params Destination of exactly GetNumLayerParameters(layer_i) values
+     * @return false if the index or size does not match
+     */
+    bool GetLayerParameters(size_t layer_i, std::span<T> params) const;
+
+    /**
+     * @brief Overwrite one layer's weights and biases from a flat buffer
+     * @param layer_i Layer index
+     * @param params GetNumLayerParameters(layer_i) values in GetLayerParameters() order
+     * @return false if the index or size does not match; the network is then unchanged
+     */
+    bool SetLayerParameters(size_t layer_i, std::span<const T> params);
+
+    /**
+     * @brief Copy the RMSProp squared-gradient averages into a flat buffer
+     * @param state Destination of exactly GetNumParameters() values, in GetParameters() order
+     * @return false if the size does not match
+     */
+    bool GetOptimizerState(std::span<T> state) const;
+
+    /**
+     * @brief Overwrite the RMSProp squared-gradient averages from a flat buffer
+     * @param state GetNumParameters() values in GetParameters() order
+     * @return false if the size does not match; the network is then unchanged
+     */
+    bool SetOptimizerState(std::span<const T> state);
+
+    /**
+     * @brief Build an immutable inference-only copy holding just the weights and biases
+     *
+     * The copy lives in a single allocation and gives the same outputs as
+     * GetOutput() for inference, with the normalisation applied.
+     *
+     * @param normalisation Optional input and output affine maps to fold in
+     * @param resource Where the frozen model's allocation is made
+     * @return The frozen model; empty normalisation vectors and mismatched sizes are treated as identity
+     */
+    FrozenMLP<T> Freeze(const FreezeNormalisation<T> &normalisation = {},
+                        std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+    /**
+     * @brief Get the resource the network's parameters and optimizer state live in
+     *
+     * Copies of the network use the default resource. Temporaries of a
+     * single call (forward-pass activations, shuffled indices) are not
+     * taken from it, so repeated training does not grow a monotonic arena.
+     */
+    std::pmr::memory_resource * GetMemoryResource() const {
+        return m_layers.get_allocator().resource();
+    }
+
+    /**
+     * @brief Get the loss function the network was built with
+     */
+    loss::LOSS_FUNCTIONS GetLossFunctionType() const {
+        return m_loss_function_type;
+    }
 
     /**
      * @brief Get predicted outputs for given input
@@ -108,6 +278,22 @@ public:
                     std::vector<std::vector<T>> * all_layers_activations = nullptr,
                     bool for_inference = true);
 
+    /**
+     * @brief Get predicted outputs and their derivatives with respect to the inputs
+     *
+     * One forward-mode pass carries the input tangents through the network
+     * alongside the values, costing about (inputs + 1) forward passes.
+     *
+     * @param input Input feature vector
+     * @param output Pointer to store output predictions
+     * @param jacobian Pointer to store d output[k] / d input[i] at [k * inputs + i]
+     * @param for_inference If true and using categorical cross-entropy, applies softmax to output
+     */
+    void GetOutputWithJacobian(const std::vector<T> &input,
+                               std::vector<T> * output,
+                               std::vector<T> * jacobian,
+                               bool for_inference = true);
+
     /**
      * @brief Determines the output class from network outputs
      *
@@ -321,19 +507,77 @@ public:
                                     const std::vector<T>& action_gradient);
 
     void PurturbWeights(const size_t nWeights, const float scale=0.1f) {
-        utils::gen_rand<float> randf(scale);
+        const T half = static_cast<T>(scale * 0.5f);
         for(size_t i=0; i < nWeights; i++) {
-            size_t layer_i = rand() % (m_layers.size()-1);
-            size_t node_i = rand() %  (m_layers[layer_i].GetOutputSize()-1);
-            size_t weight_i = rand() % (m_layers[layer_i].GetInputSize()-1);
+            size_t layer_i = m_rng.Below(m_layers.size()-1);
+            size_t node_i = m_rng.Below(m_layers[layer_i].GetOutputSize()-1);
+            size_t weight_i = m_rng.Below(m_layers[layer_i].GetInputSize()-1);
 
-            T perturbation = randf();
+            T perturbation = m_rng.Uniform<T>(-half, half);
             m_layers[layer_i].GetNodesChangeable()[node_i].GetWeights()[weight_i] += perturbation;
         }
     }
 
-    void SetProgressCallback(std::function<void(size_t,float)> callback) {
-        m_progress_callback = std::move(callback);
+    /**
+     * @brief Reseed the network's generator for reproducible initialisation and exploration
+     * @param seed Any 64-bit value
+     */
+    void SetSeed(uint64_t seed) {
+        m_rng.Seed(seed);
+    }
+
+    /**
+     * @brief Get the network's generator, e.g. to derive streams with Random::Jump()
+     */
+    Random & GetRandom() {
+        return m_rng;
+    }
+
+    /**
+     * @brief Attach the input embedding this network was trained on
+     *
+     * The network does not apply it: run inputs through
+     * GetInputEmbedding() first. It is stored with the model under
+     * ModelFormat::kSectionEmbedding, and LoadModel() restores it.
+     *
+     * @return false, attaching nothing, unless the network's inputs are the
+     *         embedding's outputs plus one bias input
+     */
+    bool SetInputEmbedding(const FourierFeatures<T> &embedding) {
+        if (embedding.GetNumOutputs() + 1 != m_num_inputs) {
+            return false;
+        }
+        m_embedding = embedding;
+        return true;
+    }
+
+    void ClearInputEmbedding() {
+        m_embedding.reset();
+    }
+
+    /**
+     * @brief Get the attached input embedding, or nullptr if there is none
+     */
+    FourierFeatures<T> * GetInputEmbedding() {
+        return m_embedding ? &*m_embedding : nullptr;
+    }
+
+    const FourierFeatures<T> * GetInputEmbedding() const {
+        return m_embedding ? &*m_embedding : nullptr;
+    }
+
+    /**
+     * @brief Publish one TrainingTelemetry record per iteration of Train() and TrainBatch()
+     *
+     * The trainer is the ring's only producer and never blocks on it. A
+     * copied network writes to the same ring, so detach it before training
+     * a copy on another thread.
+     *
+     * @param ring Ring to write to (not owned), or nullptr to stop
+     */
+    void SetTelemetryRing(TelemetryRing *ring) {
+        m_telemetry = ring;
+        m_telemetry_dropped = 0;
     }
 
     /**
@@ -359,7 +603,7 @@ public:
      * Each Layer contains nodes and their weights, biases, and activation functions.
      * @warning Modifying layers directly may break network functionality unless you know what you're doing
      */
-    std::vector<Layer<T>> m_layers;
+    std::pmr::vector<Layer<T>> m_layers;
     int get_num_inputs() const {
         return m_num_inputs;
     }
@@ -432,6 +676,9 @@ protected:
         const unsigned int every_n_iter,
         const unsigned int i,
         const T current_iteration_cost_function);
+    bool CheckSerialised(std::span<const uint8_t> buffer,
+                         ModelFormat::Header &h,
+                         bool &same_topology) const;
     void ReportFinish(const unsigned int i,
         const float current_iteration_cost_function);
     size_t m_num_inputs{ 0 };
@@ -440,10 +687,16 @@ protected:
     std::vector<size_t> m_layers_nodes;
     MLP_LOSS_FN loss::loss_func_t<T> loss_fn_;
     loss::LOSS_FUNCTIONS m_loss_function_type; /**< Store loss function type for runtime checks */
-    std::function<void(size_t,float)> m_progress_callback{};
-
-    std::random_device rd;
-    std::mt19937 g;
+    void PublishTelemetry(TrainingTelemetry record,
+                          std::chrono::steady_clock::time_point start);
+    TelemetryRing *m_telemetry = nullptr;
+    uint32_t m_telemetry_dropped = 0;
+    std::optional<FourierFeatures<T>> m_embedding; /**< Stored with the model, not applied by it */
+    std::vector<uint8_t> m_io_buffer; /**< Reused file buffer for LoadModel() */
+    std::vector<T> m_forward_in;      /**< GetOutput() layer input, reused across calls */
+    std::vector<T> m_forward_out;     /**< GetOutput() layer output, reused across calls */
+
+    Random m_rng{ RandomSeed() }; /**< Per-network generator for initialisation, exploration and shuffling */
 
 };
 
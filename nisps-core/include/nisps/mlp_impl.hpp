@@ -23,6 +23,8 @@
 #include <algorithm>
 #include <cassert>
 #include <random>
+#include <bit>
+#include <cstring>
 
 // #define SAFE_MODE
 
@@ -35,7 +37,9 @@ MLP<T>::MLP(const std::vector<size_t> & layers_nodes,
          const std::vector<ACTIVATION_FUNCTIONS> & layers_activfuncs,
          loss::LOSS_FUNCTIONS loss_function,
          bool use_constant_weight_init,
-         T constant_weight_init) : g(rd()) {
+         T constant_weight_init,
+         std::pmr::memory_resource * resource)
+    : m_layers(resource) {
 #ifdef SAFE_MODE
   assert(layers_nodes.size() >= 2);
   assert(layers_activfuncs.size() + 1 == layers_nodes.size());
@@ -51,7 +55,7 @@ MLP<T>::MLP(const std::vector<size_t> & layers_nodes,
 
 template<typename T>
 MLP<T>::MLP(const std::string & filename) {
-  if (!LoadMLPNetwork(filename)) {
+  if (!LoadModel(filename) && !LoadMLPNetwork(filename)) {
     // If loading fails, we need to have a valid but empty network
     // Initialize with minimal valid configuration
     m_num_inputs = 0;
@@ -97,12 +101,16 @@ void MLP<T>::CreateMLP(const std::vector<size_t> & layers_nodes,
     (void)loss_ok;
 
     for (size_t i = 0; i < m_layers_nodes.size() - 1; i++) {
-        m_layers.emplace_back(Layer<T>(m_layers_nodes[i],
-                                    m_layers_nodes[i + 1],
-                                    layers_activfuncs[i],
-                                    use_constant_weight_init,
-                                    constant_weight_init));
+        m_layers.emplace_back(m_layers_nodes[i],
+                              m_layers_nodes[i + 1],
+                              layers_activfuncs[i],
+                              use_constant_weight_init,
+                              constant_weight_init,
+                              &m_rng);
     }
+    const size_t widest = *std::max_element(m_layers_nodes.begin(), m_layers_nodes.end());
+    m_forward_in.reserve(widest);
+    m_forward_out.reserve(widest);
 }
 
 
@@ -119,6 +127,78 @@ void MLP<T>::ReportProgress(const bool output_log,
 }
 
 
+template<typename T>
+FrozenMLP<T> MLP<T>::Freeze(const FreezeNormalisation<T> &norm,
+                            std::pmr::memory_resource *resource) const {
+    const size_t n_layers = m_layers.size();
+    std::vector<activation_func_t<T>> activations(n_layers);
+    for (size_t l = 0; l < n_layers; l++) {
+        activations[l] = m_layers[l].GetActivationFunction();
+    }
+    const size_t n_out = m_layers_nodes.back();
+    const bool softmax = m_loss_function_type == loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY && n_out > 1;
+    const bool has_in_offset = norm.input_offset.size() == m_num_inputs;
+    const bool has_in_scale = norm.input_scale.size() == m_num_inputs;
+    const bool has_out_scale = norm.output_scale.size() == n_out;
+    const bool has_out_offset = norm.output_offset.size() == n_out;
+    const bool fold_output = !softmax && m_layers.back().GetActivationFunctionType() == LINEAR;
+    const bool output_affine = (has_out_scale || has_out_offset) && !fold_output;
+
+    FrozenMLP<T> frozen(m_layers_nodes, activations, softmax, output_affine, resource);
+    for (size_t l = 0; l < n_layers; l++) {
+        const auto &nodes = m_layers[l].m_nodes;
+        const size_t cols = m_layers_nodes[l];
+        T *w = frozen.Weights(l);
+        T *b = frozen.Biases(l);
+        for (size_t r = 0; r < nodes.size(); r++, w += cols) {
+            std::copy(nodes[r].m_weights.begin(), nodes[r].m_weights.end(), w);
+            b[r] = nodes[r].m_bias;
+            // w . ((x - offset) * scale) + b == (w * scale) . x + (b - (w * scale) . offset)
+            if (l == 0) {
+                for (size_t c = 0; c < cols; c++) {
+                    if (has_in_scale) {
+                        w[c] *= norm.input_scale[c];
+                    }
+                    if (has_in_offset) {
+                        b[r] -= w[c] * norm.input_offset[c];
+                    }
+                }
+            }
+            if (l + 1 == n_layers && fold_output) {
+                const T scale = has_out_scale ? norm.output_scale[r] : static_cast<T>(1);
+                for (size_t c = 0; c < cols; c++) {
+                    w[c] *= scale;
+                }
+                b[r] = b[r] * scale + (has_out_offset ? norm.output_offset[r] : static_cast<T>(0));
+            }
+        }
+    }
+    if (output_affine) {
+        if (has_out_scale) {
+            std::copy(norm.output_scale.begin(), norm.output_scale.end(), frozen.OutputScale());
+        }
+        if (has_out_offset) {
+            std::copy(norm.output_offset.begin(), norm.output_offset.end(), frozen.OutputOffset());
+        }
+    }
+    return frozen;
+}
+
+
+template<typename T>
+void MLP<T>::PublishTelemetry(TrainingTelemetry record,
+                              std::chrono::steady_clock::time_point start) {
+    record.elapsed_s = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    record.dropped = m_telemetry_dropped;
+    // A full ring means the consumer is behind; drop rather than wait
+    if (m_telemetry->TryPush(record)) {
+        m_telemetry_dropped = 0;
+    } else {
+        m_telemetry_dropped++;
+    }
+}
+
+
 template<typename T>
 void MLP<T>::ReportFinish(const unsigned int i, const float current_iteration_cost_function)
 {
@@ -222,32 +302,374 @@ bool MLP<T>::LoadMLPNetwork(const std::string & filename) {
 }
 
 
+template<typename T>
+size_t MLP<T>::GetNumParameters() const {
+    size_t n = 0;
+    for (const auto & layer : m_layers) {
+        n += layer.m_num_nodes * (layer.m_num_inputs_per_node + 1);
+    }
+    return n;
+}
+
+template<typename T>
+size_t MLP<T>::GetNumLayerParameters(size_t layer_i) const {
+    assert(layer_i < m_layers.size());
+    return m_layers[layer_i].m_num_nodes * (m_layers[layer_i].m_num_inputs_per_node + 1);
+}
 
-// Serialization methods commented out - not needed for nisps-core basic functionality
-// Uncomment and implement if binary serialization is required
-/*
-template <typename T>
-size_t MLP<T>::Serialise(size_t w_head, std::vector<uint8_t> &buffer)
-{
-    for (unsigned int n = 0; n < m_layers.size(); n++) {
-        auto layer_weights = GetLayerWeights(n);
-        w_head = Serialise::FromVector2D(w_head, layer_weights, buffer);
+template<typename T>
+bool MLP<T>::GetLayerParameters(size_t layer_i, std::span<T> params) const {
+    if (layer_i >= m_layers.size() || params.size() != GetNumLayerParameters(layer_i)) {
+        return false;
+    }
+    const auto & layer = m_layers[layer_i];
+    const size_t n_in = layer.m_num_inputs_per_node;
+    T *dst = params.data();
+    for (const auto & node : layer.m_nodes) {
+        std::memcpy(dst, node.m_weights.data(), n_in * sizeof(T));
+        dst += n_in;
+    }
+    for (const auto & node : layer.m_nodes) {
+        *dst++ = node.m_bias;
     }
-    return w_head;
+    return true;
 }
 
+template<typename T>
+bool MLP<T>::SetLayerParameters(size_t layer_i, std::span<const T> params) {
+    if (layer_i >= m_layers.size() || params.size() != GetNumLayerParameters(layer_i)) {
+        return false;
+    }
+    auto & layer = m_layers[layer_i];
+    const size_t n_in = layer.m_num_inputs_per_node;
+    const T *src = params.data();
+    for (auto & node : layer.m_nodes) {
+        std::memcpy(node.m_weights.data(), src, n_in * sizeof(T));
+        src += n_in;
+    }
+    for (auto & node : layer.m_nodes) {
+        node.m_bias = *src++;
+    }
+    return true;
+}
 
-template <typename T>
-size_t MLP<T>::FromSerialised(size_t r_head, const std::vector<uint8_t> &buffer)
-{
-    for (unsigned int n = 0; n < m_layers.size(); n++) {
-        std::vector< std::vector<T> > layer_weights;
-        r_head = Serialise::ToVector2D(r_head, buffer, layer_weights);
-        SetLayerWeights(n, layer_weights);
+template<typename T>
+bool MLP<T>::GetParameters(std::span<T> params) const {
+    if (params.size() != GetNumParameters()) {
+        return false;
     }
-    return r_head;
-};
-*/
+    size_t offset = 0;
+    for (size_t l = 0; l < m_layers.size(); l++) {
+        const size_t n = GetNumLayerParameters(l);
+        GetLayerParameters(l, params.subspan(offset, n));
+        offset += n;
+    }
+    return true;
+}
+
+template<typename T>
+bool MLP<T>::SetParameters(std::span<const T> params) {
+    if (params.size() != GetNumParameters()) {
+        return false;
+    }
+    size_t offset = 0;
+    for (size_t l = 0; l < m_layers.size(); l++) {
+        const size_t n = GetNumLayerParameters(l);
+        SetLayerParameters(l, params.subspan(offset, n));
+        offset += n;
+    }
+    return true;
+}
+
+template<typename T>
+bool MLP<T>::GetOptimizerState(std::span<T> state) const {
+    if (state.size() != GetNumParameters()) {
+        return false;
+    }
+    T *dst = state.data();
+    for (const auto & layer : m_layers) {
+        const size_t n_in = layer.m_num_inputs_per_node;
+        for (const auto & node : layer.m_nodes) {
+            assert(node.squared_gradient_avg.size() == n_in);
+            std::memcpy(dst, node.squared_gradient_avg.data(), n_in * sizeof(T));
+            dst += n_in;
+        }
+        for (const auto & node : layer.m_nodes) {
+            *dst++ = node.bias_squared_gradient_avg;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool MLP<T>::SetOptimizerState(std::span<const T> state) {
+    if (state.size() != GetNumParameters()) {
+        return false;
+    }
+    const T *src = state.data();
+    for (auto & layer : m_layers) {
+        const size_t n_in = layer.m_num_inputs_per_node;
+        for (auto & node : layer.m_nodes) {
+            assert(node.squared_gradient_avg.size() == n_in);
+            std::memcpy(node.squared_gradient_avg.data(), src, n_in * sizeof(T));
+            src += n_in;
+        }
+        for (auto & node : layer.m_nodes) {
+            node.bias_squared_gradient_avg = *src++;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+size_t MLP<T>::SerialisedSize(uint32_t sections) const {
+    size_t n_sections = std::popcount(sections & ModelFormat::kSectionAll);
+    size_t embedding_size = (m_embedding && (sections & ModelFormat::kSectionEmbedding)) ?
+        m_embedding->SerialisedSize() : 0;
+    return ModelFormat::ContainerSize(m_layers.size(),
+                                      n_sections * GetNumParameters() * sizeof(T) + embedding_size);
+}
+
+template<typename T>
+size_t MLP<T>::Serialise(std::span<uint8_t> buffer, uint32_t sections) const {
+    sections &= ModelFormat::kSectionKnown;
+    if (!m_embedding) {
+        sections &= ~ModelFormat::kSectionEmbedding;
+    }
+    const size_t size = SerialisedSize(sections);
+    if (!(sections & ModelFormat::kSectionAll) || buffer.size() < size) {
+        return 0;
+    }
+
+    ModelFormat::Header h;
+    h.scalar_size = sizeof(T);
+    h.num_layers = static_cast<uint32_t>(m_layers.size());
+    h.loss_function = static_cast<uint32_t>(m_loss_function_type);
+    h.sections = sections;
+    h.blob_offset = static_cast<uint32_t>(ModelFormat::BlobOffset(m_layers.size()));
+    h.blob_size = static_cast<uint32_t>(size - h.blob_offset - ModelFormat::kCrcSize);
+
+    uint8_t *dst = buffer.data();
+    ModelFormat::EncodeHeader(dst, h);
+    for (size_t l = 0; l < m_layers.size(); l++) {
+        ModelFormat::EncodeLayer(dst, l,
+                                 static_cast<uint32_t>(m_layers[l].m_num_inputs_per_node),
+                                 static_cast<uint32_t>(m_layers[l].m_num_nodes),
+                                 static_cast<uint32_t>(m_layers[l].GetActivationFunctionType()));
+    }
+
+    // Sections are stored in flag order, each with the same per-layer shape:
+    // node-major weight rows followed by the node biases.
+    uint8_t *blob = dst + h.blob_offset;
+    if (sections & ModelFormat::kSectionWeights) {
+        for (const auto & layer : m_layers) {
+            const size_t n_in = layer.m_num_inputs_per_node;
+            for (const auto & node : layer.m_nodes) {
+                binary_io::StoreArray(blob, node.m_weights.data(), n_in);
+                blob += n_in * sizeof(T);
+            }
+            for (const auto & node : layer.m_nodes) {
+                binary_io::Store<T>(blob, node.m_bias);
+                blob += sizeof(T);
+            }
+        }
+    }
+    if (sections & ModelFormat::kSectionOptimizer) {
+        for (const auto & layer : m_layers) {
+            const size_t n_in = layer.m_num_inputs_per_node;
+            for (const auto & node : layer.m_nodes) {
+                assert(node.squared_gradient_avg.size() == n_in);
+                binary_io::StoreArray(blob, node.squared_gradient_avg.data(), n_in);
+                blob += n_in * sizeof(T);
+            }
+            for (const auto & node : layer.m_nodes) {
+                binary_io::Store<T>(blob, node.bias_squared_gradient_avg);
+                blob += sizeof(T);
+            }
+        }
+    }
+    if (sections & ModelFormat::kSectionEmbedding) {
+        m_embedding->Serialise(std::span<uint8_t>(blob, m_embedding->SerialisedSize()));
+    }
+    ModelFormat::Seal(dst, h);
+    return size;
+}
+
+template<typename T>
+bool MLP<T>::CheckSerialised(std::span<const uint8_t> buffer,
+                             ModelFormat::Header &h,
+                             bool &same_topology) const {
+    if (!ModelFormat::Open(buffer, h) ||
+        h.scalar_size != sizeof(T) ||
+        !(h.sections & ModelFormat::kSectionAll) || (h.sections & ~ModelFormat::kSectionKnown) ||
+        h.loss_function > loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY) {
+        return false;
+    }
+    const uint8_t *src = buffer.data();
+
+    same_topology = (h.num_layers == m_layers.size());
+    size_t n_params = 0;
+    uint32_t prev_nodes = 0;
+    for (size_t l = 0; l < h.num_layers; l++) {
+        uint32_t n_in, n_nodes, activation;
+        ModelFormat::DecodeLayer(src, l, n_in, n_nodes, activation);
+        if (n_in == 0 || n_nodes == 0 || (l > 0 && n_in != prev_nodes) ||
+            activation > ACTIVATION_FUNCTIONS::HARDTANH) {
+            return false;
+        }
+        prev_nodes = n_nodes;
+        n_params += static_cast<size_t>(n_nodes) * (n_in + 1);
+        same_topology = same_topology &&
+            m_layers[l].m_num_inputs_per_node == n_in &&
+            m_layers[l].m_num_nodes == n_nodes &&
+            m_layers[l].GetActivationFunctionType() == static_cast<ACTIVATION_FUNCTIONS>(activation);
+    }
+    size_t params_size = std::popcount(h.sections & ModelFormat::kSectionAll) * n_params * sizeof(T);
+    if (!(h.sections & ModelFormat::kSectionEmbedding)) {
+        return params_size == h.blob_size;
+    }
+    // The embedding must fill the rest of the blob exactly
+    if (params_size >= h.blob_size) {
+        return false;
+    }
+    const size_t embedding_size = h.blob_size - params_size;
+    const auto embedding = buffer.subspan(h.blob_offset + params_size, embedding_size);
+    uint32_t n_in, n_nodes, activation;
+    ModelFormat::DecodeLayer(src, 0, n_in, n_nodes, activation);
+    // As SetInputEmbedding() requires: the embedding plus one bias input feed the network
+    return FourierFeatures<T>::RecordSize(embedding) == embedding_size &&
+           FourierFeatures<T>::RecordNumOutputs(embedding) + 1 == n_in;
+}
+
+template<typename T>
+bool MLP<T>::FromSerialised(std::span<const uint8_t> buffer, uint32_t sections) {
+    ModelFormat::Header h;
+    bool same_topology = false;
+    sections &= ModelFormat::kSectionKnown;
+    if (sections == 0 ||
+        !CheckSerialised(buffer, h, same_topology) ||
+        !same_topology ||
+        (h.sections & sections) != sections) {
+        return false;
+    }
+
+    const size_t section_size = GetNumParameters() * sizeof(T);
+    const uint8_t *blob = buffer.data() + h.blob_offset;
+    if (sections & ModelFormat::kSectionEmbedding) {
+        // Validated by CheckSerialised(), so this cannot fail
+        const size_t params_size = std::popcount(h.sections & ModelFormat::kSectionAll) * section_size;
+        if (!m_embedding) {
+            m_embedding.emplace();
+        }
+        m_embedding->FromSerialised(buffer.subspan(h.blob_offset + params_size,
+                                                   h.blob_size - params_size));
+    }
+    if (h.sections & ModelFormat::kSectionWeights) {
+        if (sections & ModelFormat::kSectionWeights) {
+            const uint8_t *src = blob;
+            for (auto & layer : m_layers) {
+                const size_t n_in = layer.m_num_inputs_per_node;
+                for (auto & node : layer.m_nodes) {
+                    binary_io::LoadArray(node.m_weights.data(), src, n_in);
+                    src += n_in * sizeof(T);
+                }
+                for (auto & node : layer.m_nodes) {
+                    node.m_bias = binary_io::Load<T>(src);
+                    src += sizeof(T);
+                }
+            }
+        }
+        blob += section_size;
+    }
+    if (sections & ModelFormat::kSectionOptimizer) {
+        const uint8_t *src = blob;
+        for (auto & layer : m_layers) {
+            const size_t n_in = layer.m_num_inputs_per_node;
+            for (auto & node : layer.m_nodes) {
+                assert(node.squared_gradient_avg.size() == n_in);
+                binary_io::LoadArray(node.squared_gradient_avg.data(), src, n_in);
+                src += n_in * sizeof(T);
+            }
+            for (auto & node : layer.m_nodes) {
+                node.bias_squared_gradient_avg = binary_io::Load<T>(src);
+                src += sizeof(T);
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool MLP<T>::SaveModel(const std::string & filename, uint32_t sections) const {
+    std::vector<uint8_t> buffer(SerialisedSize(sections));
+    if (Serialise(buffer, sections) == 0) {
+        return false;
+    }
+    FILE * file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(buffer.data(), buffer.size(), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+template<typename T>
+bool MLP<T>::LoadModel(const std::string & filename) {
+    FILE * file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? ftell(file) : -1;
+    ok = ok && size > 0 && fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        m_io_buffer.resize(static_cast<size_t>(size));
+        ok = fread(m_io_buffer.data(), m_io_buffer.size(), 1, file) == 1;
+    }
+    fclose(file);
+    return ok && LoadModel(std::span<const uint8_t>(m_io_buffer));
+}
+
+template<typename T>
+bool MLP<T>::LoadModel(std::span<const uint8_t> bytes) {
+    ModelFormat::Header h;
+    bool same_topology = false;
+    if (!CheckSerialised(bytes, h, same_topology) ||
+        !(h.sections & ModelFormat::kSectionWeights)) {
+        return false;
+    }
+
+    const auto loss_function = static_cast<loss::LOSS_FUNCTIONS>(h.loss_function);
+    if (!same_topology) {
+        std::vector<size_t> layers_nodes;
+        std::vector<ACTIVATION_FUNCTIONS> layers_activfuncs;
+        for (size_t l = 0; l < h.num_layers; l++) {
+            uint32_t n_in, n_nodes, activation;
+            ModelFormat::DecodeLayer(bytes.data(), l, n_in, n_nodes, activation);
+            if (l == 0) {
+                layers_nodes.push_back(n_in);
+            }
+            layers_nodes.push_back(n_nodes);
+            layers_activfuncs.push_back(static_cast<ACTIVATION_FUNCTIONS>(activation));
+        }
+        m_layers.clear();
+        CreateMLP(layers_nodes, layers_activfuncs, loss_function, true, 0);
+    } else if (loss_function != m_loss_function_type) {
+        loss::LossFunctionsManager<T>::Singleton().GetLossFunction(loss_function, &loss_fn_);
+        m_loss_function_type = loss_function;
+    }
+
+    // Optimizer state from the previous model is meaningless for this one
+    if (!(h.sections & ModelFormat::kSectionOptimizer)) {
+        ResetOptimizerState();
+    }
+    // So is an embedding the new model was not trained with
+    if (!(h.sections & ModelFormat::kSectionEmbedding)) {
+        m_embedding.reset();
+    }
+    return FromSerialised(bytes, h.sections);
+}
 
 
 template<typename T>
@@ -255,6 +677,8 @@ void MLP<T>::GetOutput(const std::vector<T> &input,
                     std::vector<T> * output,
                     std::vector<std::vector<T>> * all_layers_activations,
                     bool for_inference) {
+    NISPS_PROFILE_SCOPE("MLP::GetOutput");
+    NISPS_RT_SECTION_IF("MLP::GetOutput", all_layers_activations == nullptr);
     // Add safety check
     if (input.size() != m_num_inputs) {
         NISPS_DEBUG_PRINTF("ERROR: input.size()=%zu != m_num_inputs=%zu\n",
@@ -262,30 +686,18 @@ void MLP<T>::GetOutput(const std::vector<T> &input,
         return;
     }
 
-    int temp_size;
-    if (m_num_hidden_layers == 0)
-        temp_size = m_num_outputs;
-    else
-        temp_size = m_layers_nodes[1];
-
-    // Pre-allocate with capacity to avoid reallocations
-    std::vector<T> temp_in;
-    temp_in.reserve(m_num_inputs);
-    temp_in = input;
-
-    std::vector<T> temp_out;
-    temp_out.reserve(temp_size);
+    // Inference reuses the network's buffers, so it does not allocate once they have grown
+    std::vector<T> &temp_in = m_forward_in;
+    std::vector<T> &temp_out = m_forward_out;
+    temp_in.assign(input.begin(), input.end());
 
     for (size_t i = 0; i < m_layers.size(); ++i) {
         if (i > 0) {
             //Store this layer activation
             if (all_layers_activations != nullptr)
-                all_layers_activations->emplace_back(std::move(temp_in));
+                all_layers_activations->push_back(temp_in);
 
-            temp_in.clear();
-            temp_in = temp_out;
-            temp_out.clear();
-            temp_out.resize(m_layers[i].GetOutputSize());
+            temp_in.swap(temp_out);
         }
         m_layers[i].GetOutputAfterActivationFunction(temp_in, &temp_out);
     }
@@ -301,7 +713,79 @@ void MLP<T>::GetOutput(const std::vector<T> &input,
 
     //Add last layer activation
     if (all_layers_activations != nullptr)
-        all_layers_activations->emplace_back(std::move(temp_in));
+        all_layers_activations->push_back(temp_in);
+}
+
+
+template<typename T>
+void MLP<T>::GetOutputWithJacobian(const std::vector<T> &input,
+                                   std::vector<T> * output,
+                                   std::vector<T> * jacobian,
+                                   bool for_inference) {
+    if (input.size() != m_num_inputs) {
+        NISPS_DEBUG_PRINTF("ERROR: input.size()=%zu != m_num_inputs=%zu\n",
+                          input.size(), m_num_inputs);
+        return;
+    }
+    const size_t n_in = m_num_inputs;
+
+    // Values and tangents (row j holds d a_j / d input), starting from identity
+    std::vector<T> a = input;
+    std::vector<T> tangent(n_in * n_in, static_cast<T>(0));
+    for (size_t i = 0; i < n_in; i++) {
+        tangent[i * n_in + i] = static_cast<T>(1);
+    }
+    std::vector<T> next_a, next_tangent;
+
+    for (auto & layer : m_layers) {
+        const size_t n_nodes = layer.m_nodes.size();
+        const size_t n_prev = a.size();
+        auto activation = layer.GetActivationFunction();
+        auto deriv = layer.GetDerivActivationFunction();
+        next_a.resize(n_nodes);
+        next_tangent.assign(n_nodes * n_in, static_cast<T>(0));
+        for (size_t j = 0; j < n_nodes; j++) {
+            const auto & node = layer.m_nodes[j];
+            T z = node.m_bias;
+            T *row = next_tangent.data() + j * n_in;
+            for (size_t p = 0; p < n_prev; p++) {
+                const T w = node.m_weights[p];
+                z += w * a[p];
+                const T *prev_row = tangent.data() + p * n_in;
+                for (size_t i = 0; i < n_in; i++) {
+                    row[i] += w * prev_row[i];
+                }
+            }
+            next_a[j] = activation(z);
+            const T d = deriv(z);
+            for (size_t i = 0; i < n_in; i++) {
+                row[i] *= d;
+            }
+        }
+        a.swap(next_a);
+        tangent.swap(next_tangent);
+    }
+
+    if (for_inference &&
+        m_loss_function_type == loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY &&
+        a.size() > 1) {
+        // d softmax_k = s_k * (d a_k - sum_m s_m d a_m)
+        utils::Softmax(&a);
+        std::vector<T> mean(n_in, static_cast<T>(0));
+        for (size_t m = 0; m < a.size(); m++) {
+            for (size_t i = 0; i < n_in; i++) {
+                mean[i] += a[m] * tangent[m * n_in + i];
+            }
+        }
+        for (size_t k = 0; k < a.size(); k++) {
+            for (size_t i = 0; i < n_in; i++) {
+                tangent[k * n_in + i] = a[k] * (tangent[k * n_in + i] - mean[i]);
+            }
+        }
+    }
+
+    *output = a;
+    *jacobian = tangent;
 }
 
 
@@ -337,22 +821,25 @@ T MLP<T>::TrainBatch(const training_pair_t& training_sample_set,
                      float min_error_cost,
                      bool output_log) {
 
-    auto training_features = training_sample_set.first;
-    auto training_labels = training_sample_set.second;
+    const auto &training_features = training_sample_set.first;
+    const auto &training_labels = training_sample_set.second;
 
     size_t n_samples = training_features.size();
     size_t n_batches = (n_samples + batch_size - 1) / batch_size;
 
+    const auto start = std::chrono::steady_clock::now();
     T epoch_loss = 0;
     for (int iter = 0; iter < max_iterations; iter++) {
 
         epoch_loss = 0;
+        T max_grad_norm = 0;
+        uint32_t clip_events = 0;
 
         // Shuffle indices
         std::vector<size_t> indices(n_samples);
         std::iota(indices.begin(), indices.end(), 0);
 
-        std::shuffle(indices.begin(), indices.end(), g);
+        std::shuffle(indices.begin(), indices.end(), m_rng);
 
         size_t sample_idx = 0;
 
@@ -387,18 +874,25 @@ T MLP<T>::TrainBatch(const training_pair_t& training_sample_set,
 
                 // Forward pass
                 // NISPS_DEBUG_PRINTF("Processing sample %zu (idx=%zu), input_size=%zu\n", i, idx, training_features[idx].size());
-                GetOutput(training_features[idx],
-                         &predicted_output,
-                         &all_layers_activations,
-                         false);
+                {
+                    NISPS_PROFILE_SCOPE("TrainBatch/forward");
+                    GetOutput(training_features[idx],
+                             &predicted_output,
+                             &all_layers_activations,
+                             false);
+                }
 
                 // Compute loss and derivatives
-                deriv_error_output.clear();
-                deriv_error_output.resize(predicted_output.size());
-                T loss = loss_fn_(training_labels[idx],
-                                 predicted_output,
-                                 deriv_error_output,
-                                 1.0f);
+                T loss;
+                {
+                    NISPS_PROFILE_SCOPE("TrainBatch/loss");
+                    deriv_error_output.clear();
+                    deriv_error_output.resize(predicted_output.size());
+                    loss = loss_fn_(training_labels[idx],
+                                    predicted_output,
+                                    deriv_error_output,
+                                    1.0f);
+                }
 
                 #ifdef MLP_ALLOW_DEBUG
                 if (std::isinf(loss) || std::isnan(loss)) {
@@ -413,37 +907,46 @@ T MLP<T>::TrainBatch(const training_pair_t& training_sample_set,
                 batch_loss += loss;
 
                 // Accumulate gradients through backpropagation
+                NISPS_PROFILE_SCOPE("TrainBatch/backward");
                 BackpropagateWithAccumulation(all_layers_activations,
                                              deriv_error_output,
                                              true);
             }
 
             // clipping gradients
-            T grad_sumsq = 0.0f;
-            for (auto& layer : m_layers) {
-                grad_sumsq += layer.GetGradSumSquared(batch_size_reciprocal);
-            }
-            T grad_norm = std::sqrt(grad_sumsq );
-
-            #ifdef MLP_ALLOW_DEBUG
-            NISPS_DEBUG_PRINTF("[MLP DEBUG] Batch %zu/%zu: batch_loss=%f, grad_norm=%f\n",
-                         batch, n_batches, static_cast<double>(batch_loss / current_batch_size),
-                         static_cast<double>(grad_norm));
-            if (std::isinf(grad_norm) || std::isnan(grad_norm)) {
-                NISPS_DEBUG_PRINTLN("[MLP DEBUG] *** INF/NAN grad_norm! ***");
-            }
-            #endif
-
-            if (grad_norm > 5.0f) {
-                T clip_coef = 5.0f / grad_norm;
+            {
+                NISPS_PROFILE_SCOPE("TrainBatch/clip");
+                T grad_sumsq = 0.0f;
                 for (auto& layer : m_layers) {
-                    layer.ScaleAccumulatedGradients(clip_coef);
+                    grad_sumsq += layer.GetGradSumSquared(batch_size_reciprocal);
+                }
+                T grad_norm = std::sqrt(grad_sumsq );
+                max_grad_norm = std::max(max_grad_norm, grad_norm);
+
+                #ifdef MLP_ALLOW_DEBUG
+                NISPS_DEBUG_PRINTF("[MLP DEBUG] Batch %zu/%zu: batch_loss=%f, grad_norm=%f\n",
+                             batch, n_batches, static_cast<double>(batch_loss / current_batch_size),
+                             static_cast<double>(grad_norm));
+                if (std::isinf(grad_norm) || std::isnan(grad_norm)) {
+                    NISPS_DEBUG_PRINTLN("[MLP DEBUG] *** INF/NAN grad_norm! ***");
+                }
+                #endif
+
+                if (grad_norm > 5.0f) {
+                    T clip_coef = 5.0f / grad_norm;
+                    clip_events++;
+                    for (auto& layer : m_layers) {
+                        layer.ScaleAccumulatedGradients(clip_coef);
+                    }
+                    // NISPS_DEBUG_PRINTF("Clipped gradients with coef: %f\n", static_cast<double>(clip_coef));
                 }
-                // NISPS_DEBUG_PRINTF("Clipped gradients with coef: %f\n", static_cast<double>(clip_coef));
             }
 
             // Apply accumulated gradients
-            ApplyAllAccumulatedGradients(learning_rate, batch_size_reciprocal);
+            {
+                NISPS_PROFILE_SCOPE("TrainBatch/apply");
+                ApplyAllAccumulatedGradients(learning_rate, batch_size_reciprocal);
+            }
 
             epoch_loss += batch_loss / current_batch_size;
         }
@@ -471,11 +974,19 @@ T MLP<T>::TrainBatch(const training_pair_t& training_sample_set,
             ReportProgress(output_log, 100, iter, epoch_loss);
         }
 
-        if (m_progress_callback) {
-            m_progress_callback(iter, epoch_loss);
+        const bool done = epoch_loss < min_error_cost;
+        if (m_telemetry) {
+            TrainingTelemetry record;
+            record.iteration = static_cast<uint32_t>(iter);
+            record.loss = static_cast<float>(epoch_loss);
+            record.grad_norm = static_cast<float>(max_grad_norm);
+            record.clip_events = clip_events;
+            record.learning_rate = learning_rate;
+            record.last = done || iter + 1 == max_iterations;
+            PublishTelemetry(record, start);
         }
 
-        if (epoch_loss < min_error_cost) {
+        if (done) {
             break;
         }
     }
@@ -522,6 +1033,7 @@ T MLP<T>::Train(const training_pair_t& training_sample_set_with_bias,
 
     T sampleSizeReciprocal = 1.f / training_sample_set_with_bias.first.size();
 
+    const auto start = std::chrono::steady_clock::now();
     for (i = 0; i < max_iterations; i++) {
         current_iteration_cost_function = 0.f;
 
@@ -551,13 +1063,18 @@ T MLP<T>::Train(const training_pair_t& training_sample_set_with_bias,
 
         ReportProgress(true, 100, i, current_iteration_cost_function);
 
-        if (m_progress_callback && !(i & 0x1F)) { // Call progress callback every 32 iterations
-            m_progress_callback(i, current_iteration_cost_function);
-        }
-
         // Early stopping
         // TODO AM early stopping should be optional and metric-dependent
-        if (current_iteration_cost_function < min_error_cost) {
+        const bool done = current_iteration_cost_function < min_error_cost;
+        if (m_telemetry) {
+            TrainingTelemetry record;
+            record.iteration = static_cast<uint32_t>(i);
+            record.loss = static_cast<float>(current_iteration_cost_function);
+            record.learning_rate = learning_rate;
+            record.last = done || i + 1 == max_iterations;
+            PublishTelemetry(record, start);
+        }
+        if (done) {
             break;
         }
 
@@ -565,11 +1082,6 @@ T MLP<T>::Train(const training_pair_t& training_sample_set_with_bias,
 
     ReportFinish(i, current_iteration_cost_function);
 
-    if (m_progress_callback) {
-        // Final callback to report completion
-        m_progress_callback(i, current_iteration_cost_function);
-    }
-
     return current_iteration_cost_function;
 };
 
@@ -735,10 +1247,10 @@ std::vector<std::vector<T>> MLP<T>::GetLayerWeights( size_t layer_i )
     // check parameters
     assert(layer_i < m_layers.size() /* Incorrect layer number in GetLayerWeights call */);
     {
-        Layer<T> current_layer = m_layers[layer_i];
-        for( Node<T> & node : current_layer.GetNodesChangeable() )
+        const Layer<T> & current_layer = m_layers[layer_i];
+        for( const Node<T> & node : current_layer.m_nodes )
         {
-            ret_val.push_back( node.GetWeights() );
+            ret_val.emplace_back( node.GetWeights().begin(), node.GetWeights().end() );
         }
         return ret_val;
     }
@@ -791,64 +1303,37 @@ void MLP<T>::SetWeights(MLP<T>::mlp_weights &weights)
 template <typename T>
 void MLP<T>::DrawWeights(float scale)
 {
-    // T before = m_layers[0].m_nodes[0].m_weights[0];
-    utils::gen_rand<T> gen;
-    // utils::gen_randn<T> gen(0.f, scale); //mean, stddev
-
-    for (unsigned int n = 0; n < m_layers.size(); n++) {
-        for (unsigned int k = 0; k < m_layers[n].m_nodes.size(); k++) {
-            for (unsigned int j = 0; j < m_layers[n].m_nodes[k].m_weights.size(); j++) {
-                float mod = gen() * scale;
-                m_layers[n].m_nodes[k].m_weights[j] = mod;
-            }
+    for (auto & layer : m_layers) {
+        for (auto & node : layer.m_nodes) {
+            m_rng.FillUniform(std::span<T>(node.m_weights),
+                              static_cast<T>(-scale), static_cast<T>(scale));
         }
     }
-
-    // assert(m_layers[0].m_nodes[0].m_weights[0] != before);
 }
 
 template <typename T>
 void MLP<T>::MoveWeights(T speed)
 {
-    T before = m_layers[0].m_nodes[0].m_weights[0];
-    utils::gen_randn<T> gen(speed);
-
-    for (unsigned int n = 0; n < m_layers.size(); n++) {
-        // size_t num_inputs = m_layers_nodes[n];
-        for (unsigned int k = 0; k < m_layers[n].m_nodes.size(); k++) {
-            for (unsigned int j = 0; j < m_layers[n].m_nodes[k].m_weights.size(); j++) {
-                T w = m_layers[n].m_nodes[k].m_weights[j];
-                m_layers[n].m_nodes[k].m_weights[j] = gen(m_layers[n].m_nodes[k].m_weights[j]);
-                T w2 = m_layers[n].m_nodes[k].m_weights[j];
-                if (speed != 0) {
-                    assert(w != w2);
-                }
-            }
+    for (auto & layer : m_layers) {
+        for (auto & node : layer.m_nodes) {
+            node.WeightRandomisation(speed, m_rng);
         }
     }
-
-    assert(m_layers[0].m_nodes[0].m_weights[0] != before);
 }
 
 template <typename T>
 void MLP<T>::InitXavier() {
     for(auto & layer : m_layers) {
-        layer.InitXavier();
+        layer.InitXavier(m_rng);
     }
 }
 
 template <typename T>
 void MLP<T>::RandomiseWeightsAndBiasesLin(T weightMin, T weightMax, T biasMin, T biasMax) {
-    std::uniform_real_distribution<> disWeight(weightMin, weightMax);
-    std::uniform_real_distribution<> disBias(biasMin, biasMin);
-
-    // utils::gen_randn<T> gen(0.f, scale); //mean, stddev
-    for (unsigned int n = 0; n < m_layers.size(); n++) {
-        for (unsigned int k = 0; k < m_layers[n].m_nodes.size(); k++) {
-            for (unsigned int j = 0; j < m_layers[n].m_nodes[k].m_weights.size(); j++) {
-                m_layers[n].m_nodes[k].m_weights[j] = disWeight(g);
-            }
-            m_layers[n].m_nodes[k].m_bias = disBias(g);
+    for (auto & layer : m_layers) {
+        for (auto & node : layer.m_nodes) {
+            m_rng.FillUniform(std::span<T>(node.m_weights), weightMin, weightMax);
+            node.m_bias = m_rng.Uniform<T>(biasMin, biasMax);
         }
     }
 }
@@ -0,0 +1,186 @@
+/**
+ * @file model_format.hpp
+ * @brief Versioned, checksummed binary container for MLP models
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Container layout (all fields little-endian):
+ *
+ *   offset  size  field
+ *   0       4     magic "NSPM"
+ *   4       2     format version
+ *   6       2     scalar size in bytes (4 = float, 8 = double)
+ *   8       4     number of layers
+ *   12      4     loss function (loss::LOSS_FUNCTIONS)
+ *   16      4     section flags (ModelFormat::kSection*)
+ *   20      4     parameter blob offset, aligned to kBlobAlignment
+ *   24      4     parameter blob size in bytes
+ *   28      4     reserved, zero
+ *   32      12*L  layer table: inputs, nodes, activation (ACTIVATION_FUNCTIONS)
+ *   ...           zero padding up to the blob offset
+ *   blob          one section per set flag, in flag order
+ *   blob+size 4   CRC-32 of every preceding byte
+ *
+ * The parameter sections have the same shape: per layer, one row per node
+ * (node-major) followed by one value per node. The weights section stores
+ * weights and biases; the optimizer section stores the matching RMSProp
+ * squared-gradient averages. The optional embedding section comes last and
+ * holds the input embedding exactly as FourierFeatures::Serialise() writes it.
+ *
+ * The parameter blob is a single contiguous, aligned array of scalars, so a
+ * loader can map or read the whole file at once and copy weights straight
+ * out of it.
+ */
+
+#ifndef NISPS_MODEL_FORMAT_HPP
+#define NISPS_MODEL_FORMAT_HPP
+
+#include "binary_io.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+namespace nisps {
+
+/**
+ * @brief Constants and header codec for the MLP model container.
+ */
+struct ModelFormat {
+    static constexpr char kMagic[4] = {'N', 'S', 'P', 'M'};
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 32;
+    static constexpr size_t kLayerEntrySize = 12;
+    static constexpr size_t kBlobAlignment = 64;
+    static constexpr size_t kCrcSize = 4;
+
+    /** @brief Blob contains weights and biases. */
+    static constexpr uint32_t kSectionWeights = 1u << 0;
+    /** @brief Blob contains optimizer state (RMSProp squared-gradient averages). */
+    static constexpr uint32_t kSectionOptimizer = 1u << 1;
+    /** @brief All parameter sections. */
+    static constexpr uint32_t kSectionAll = kSectionWeights | kSectionOptimizer;
+    /** @brief Blob ends with the input embedding (a FourierFeatures record). */
+    static constexpr uint32_t kSectionEmbedding = 1u << 2;
+    /** @brief Every section a reader understands. */
+    static constexpr uint32_t kSectionKnown = kSectionAll | kSectionEmbedding;
+
+    /**
+     * @brief Decoded container header.
+     */
+    struct Header {
+        uint16_t scalar_size = 0;
+        uint32_t num_layers = 0;
+        uint32_t loss_function = 0;
+        uint32_t sections = 0;
+        uint32_t blob_offset = 0;
+        uint32_t blob_size = 0;
+    };
+
+    /**
+     * @brief Returns the offset of the parameter blob for a number of layers.
+     */
+    static constexpr size_t BlobOffset(size_t num_layers) {
+        return binary_io::AlignUp(kHeaderSize + num_layers * kLayerEntrySize, kBlobAlignment);
+    }
+
+    /**
+     * @brief Returns the total container size for a layer count and blob size.
+     */
+    static constexpr size_t ContainerSize(size_t num_layers, size_t blob_size) {
+        return BlobOffset(num_layers) + blob_size + kCrcSize;
+    }
+
+    /**
+     * @brief Encodes the fixed header.
+     * @param dst Destination, at least kHeaderSize bytes
+     * @param h Header fields
+     */
+    static void EncodeHeader(uint8_t *dst, const Header &h) {
+        std::memset(dst, 0, kHeaderSize);
+        std::memcpy(dst, kMagic, sizeof(kMagic));
+        binary_io::Store<uint16_t>(dst + 4, kVersion);
+        binary_io::Store<uint16_t>(dst + 6, h.scalar_size);
+        binary_io::Store<uint32_t>(dst + 8, h.num_layers);
+        binary_io::Store<uint32_t>(dst + 12, h.loss_function);
+        binary_io::Store<uint32_t>(dst + 16, h.sections);
+        binary_io::Store<uint32_t>(dst + 20, h.blob_offset);
+        binary_io::Store<uint32_t>(dst + 24, h.blob_size);
+    }
+
+    /**
+     * @brief Encodes one layer table entry.
+     */
+    static void EncodeLayer(uint8_t *dst, size_t layer_i,
+                            uint32_t num_inputs, uint32_t num_nodes, uint32_t activation) {
+        uint8_t *entry = dst + kHeaderSize + layer_i * kLayerEntrySize;
+        binary_io::Store<uint32_t>(entry, num_inputs);
+        binary_io::Store<uint32_t>(entry + 4, num_nodes);
+        binary_io::Store<uint32_t>(entry + 8, activation);
+    }
+
+    /**
+     * @brief Decodes one layer table entry.
+     */
+    static void DecodeLayer(const uint8_t *src, size_t layer_i,
+                            uint32_t &num_inputs, uint32_t &num_nodes, uint32_t &activation) {
+        const uint8_t *entry = src + kHeaderSize + layer_i * kLayerEntrySize;
+        num_inputs = binary_io::Load<uint32_t>(entry);
+        num_nodes = binary_io::Load<uint32_t>(entry + 4);
+        activation = binary_io::Load<uint32_t>(entry + 8);
+    }
+
+    /**
+     * @brief Zeroes the padding, then appends the CRC after the blob.
+     * @param dst Start of the container
+     * @param h Header previously written with EncodeHeader()
+     */
+    static void Seal(uint8_t *dst, const Header &h) {
+        size_t table_end = kHeaderSize + h.num_layers * kLayerEntrySize;
+        std::memset(dst + table_end, 0, h.blob_offset - table_end);
+        size_t crc_offset = h.blob_offset + h.blob_size;
+        binary_io::Store<uint32_t>(dst + crc_offset, binary_io::Crc32(dst, crc_offset));
+    }
+
+    /**
+     * @brief Validates a container and decodes its header.
+     *
+     * Checks the magic, version, that every section fits in the buffer, and
+     * the CRC.
+     *
+     * @param bytes Container bytes
+     * @param h Receives the header
+     * @return true if the container is intact
+     */
+    static bool Open(std::span<const uint8_t> bytes, Header &h) {
+        if (bytes.size() < kHeaderSize + kCrcSize) {
+            return false;
+        }
+        const uint8_t *src = bytes.data();
+        if (std::memcmp(src, kMagic, sizeof(kMagic)) != 0 ||
+            binary_io::Load<uint16_t>(src + 4) != kVersion) {
+            return false;
+        }
+        h.scalar_size = binary_io::Load<uint16_t>(src + 6);
+        h.num_layers = binary_io::Load<uint32_t>(src + 8);
+        h.loss_function = binary_io::Load<uint32_t>(src + 12);
+        h.sections = binary_io::Load<uint32_t>(src + 16);
+        h.blob_offset = binary_io::Load<uint32_t>(src + 20);
+        h.blob_size = binary_io::Load<uint32_t>(src + 24);
+        if (h.num_layers == 0 ||
+            h.blob_offset != BlobOffset(h.num_layers) ||
+            static_cast<size_t>(h.blob_offset) + h.blob_size + kCrcSize > bytes.size()) {
+            return false;
+        }
+        size_t crc_offset = h.blob_offset + h.blob_size;
+        return binary_io::Load<uint32_t>(src + crc_offset) == binary_io::Crc32(src, crc_offset);
+    }
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_MODEL_FORMAT_HPP
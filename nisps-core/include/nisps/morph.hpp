@@ -0,0 +1,224 @@
+/**
+ * @file morph.hpp
+ * @brief Real-time interpolation between several trained models
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_MORPH_HPP
+#define NISPS_MORPH_HPP
+
+#include "mlp.hpp"
+#include "kernels.hpp"
+
+#include <vector>
+#include <span>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace nisps {
+
+/**
+ * @class WeightMorpher
+ * @brief Blends K stored models of the same topology into a target network.
+ *
+ * Each model is held as one flat parameter buffer (see MLP::GetParameters()).
+ * Morph() computes the weighted sum of all models with non-zero weight in a
+ * single blocked pass and writes it into the target, so it can run every
+ * control tick. Work is skipped where it cannot change the result:
+ *
+ * - a call with the same weights as the previous one does nothing;
+ * - layers that are identical in every stored model (e.g. a shared frozen
+ *   front end) are written once, not blended.
+ *
+ * All storage is allocated at construction; Morph() does not allocate.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class WeightMorpher {
+ public:
+    /**
+     * @brief Prepares storage for a number of models shaped like the target.
+     * @param target Network that receives the blended parameters
+     * @param num_models Number of model slots (K)
+     */
+    WeightMorpher(MLP<T> &target, size_t num_models)
+        : target_(target),
+          num_models_(num_models),
+          num_params_(target.GetNumParameters()),
+          models_(num_models * num_params_),
+          output_(num_params_),
+          loaded_(num_models, 0),
+          active_(num_models),
+          srcs_(num_models),
+          weights_(num_models),
+          last_weights_(num_models) {
+        const size_t num_layers = target.m_layers.size();
+        layer_offsets_.resize(num_layers + 1, 0);
+        for (size_t l = 0; l < num_layers; l++) {
+            layer_offsets_[l + 1] = layer_offsets_[l] + target.GetNumLayerParameters(l);
+        }
+        layer_varies_.resize(num_layers, 0);
+        layer_stale_.resize(num_layers, 1);
+    }
+
+    /**
+     * @brief Stores a model in a slot.
+     * @param slot Slot index
+     * @param model Network with the same topology as the target
+     * @return false if the slot or topology does not match
+     */
+    bool SetModel(size_t slot, const MLP<T> &model) {
+        if (slot >= num_models_ ||
+            !model.GetParameters(std::span<T>(Slot(slot), num_params_))) {
+            return false;
+        }
+        return Loaded(slot);
+    }
+
+    /**
+     * @brief Stores a model from a flat parameter buffer.
+     * @param slot Slot index
+     * @param params Parameters in MLP::GetParameters() order
+     * @return false if the slot or size does not match
+     */
+    bool SetModel(size_t slot, std::span<const T> params) {
+        if (slot >= num_models_ || params.size() != num_params_) {
+            return false;
+        }
+        std::memcpy(Slot(slot), params.data(), num_params_ * sizeof(T));
+        return Loaded(slot);
+    }
+
+    /**
+     * @brief Writes the blend of the stored models into the target.
+     *
+     * Weights are normalised to sum to one, so barycentric coordinates,
+     * crossfader positions or raw distances can be passed directly.
+     *
+     * @param weights One weight per slot; slots with weight 0 may be empty
+     * @return false if the size does not match, the weights sum to 0, or a
+     *         weighted slot is empty
+     */
+    bool Morph(std::span<const T> weights) {
+        if (weights.size() != num_models_) {
+            return false;
+        }
+        if (have_last_ && std::memcmp(weights.data(), last_weights_.data(),
+                                      num_models_ * sizeof(T)) == 0) {
+            return true;
+        }
+        T sum = 0;
+        for (size_t k = 0; k < num_models_; k++) {
+            sum += weights[k];
+        }
+        if (sum == 0) {
+            return false;
+        }
+        size_t n_active = 0;
+        for (size_t k = 0; k < num_models_; k++) {
+            if (weights[k] != 0) {
+                if (!loaded_[k]) {
+                    return false;
+                }
+                active_[n_active] = k;
+                weights_[n_active] = weights[k] / sum;
+                n_active++;
+            }
+        }
+
+        for (size_t l = 0; l + 1 < layer_offsets_.size(); l++) {
+            const size_t offset = layer_offsets_[l];
+            const size_t n = layer_offsets_[l + 1] - offset;
+            if (!layer_varies_[l]) {
+                if (layer_stale_[l]) {
+                    target_.SetLayerParameters(l, std::span<const T>(Slot(first_loaded_) + offset, n));
+                    layer_stale_[l] = 0;
+                }
+                continue;
+            }
+            for (size_t k = 0; k < n_active; k++) {
+                srcs_[k] = Slot(active_[k]) + offset;
+            }
+            kernels::WeightedSum(srcs_.data(), weights_.data(), n_active,
+                                 output_.data() + offset, n);
+            target_.SetLayerParameters(l, std::span<const T>(output_.data() + offset, n));
+        }
+
+        std::memcpy(last_weights_.data(), weights.data(), num_models_ * sizeof(T));
+        have_last_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Forces the next Morph() to rewrite every layer.
+     *
+     * Call after the target has been changed by anything else, e.g. training.
+     */
+    void Invalidate() {
+        std::fill(layer_stale_.begin(), layer_stale_.end(), 1);
+        have_last_ = false;
+    }
+
+    size_t GetNumModels() const { return num_models_; }
+
+    /**
+     * @brief Whether a layer differs between the stored models and is blended.
+     */
+    bool IsLayerBlended(size_t layer_i) const {
+        return layer_i < layer_varies_.size() && layer_varies_[layer_i];
+    }
+
+ private:
+    T *Slot(size_t slot) {
+        return models_.data() + slot * num_params_;
+    }
+
+    /**
+     * @brief Marks a slot filled and finds the layers that differ between models.
+     */
+    bool Loaded(size_t slot) {
+        loaded_[slot] = 1;
+        first_loaded_ = 0;
+        while (!loaded_[first_loaded_]) {
+            first_loaded_++;
+        }
+        const T *reference = Slot(first_loaded_);
+        for (size_t l = 0; l < layer_varies_.size(); l++) {
+            const size_t offset = layer_offsets_[l];
+            const size_t bytes = (layer_offsets_[l + 1] - offset) * sizeof(T);
+            layer_varies_[l] = 0;
+            for (size_t k = first_loaded_ + 1; k < num_models_ && !layer_varies_[l]; k++) {
+                layer_varies_[l] = loaded_[k] &&
+                    std::memcmp(reference + offset, Slot(k) + offset, bytes) != 0;
+            }
+        }
+        Invalidate();
+        return true;
+    }
+
+    MLP<T> &target_;
+    const size_t num_models_;
+    const size_t num_params_;
+    std::vector<T> models_;                /**< K flat parameter buffers, back to back */
+    std::vector<T> output_;                /**< Blended parameters */
+    std::vector<uint8_t> loaded_;
+    std::vector<size_t> active_;           /**< Morph() scratch: slots with non-zero weight */
+    std::vector<const T *> srcs_;          /**< Morph() scratch: active slices of one layer */
+    std::vector<T> weights_;               /**< Morph() scratch: normalised active weights */
+    std::vector<T> last_weights_;
+    bool have_last_ = false;
+    size_t first_loaded_ = 0;
+    std::vector<size_t> layer_offsets_;    /**< Start of each layer in a flat buffer */
+    std::vector<uint8_t> layer_varies_;
+    std::vector<uint8_t> layer_stale_;     /**< Unblended layer not yet written to the target */
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_MORPH_HPP
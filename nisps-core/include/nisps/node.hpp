@@ -17,6 +17,7 @@
 #include "utils.hpp"
 
 #include <vector>
+#include <memory_resource>
 #include <cassert> // for assert()
 #include <numeric>
 #include <algorithm>
@@ -43,14 +44,19 @@ using activation_func_t = T(*)(T);
 template <typename T>
 class Node {
 public:
+    /**
+     * @brief Weights and optimizer state are allocated from this allocator's resource
+     */
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
     /**
      * @brief Default constructor
+     * @param alloc Allocator for the weight and optimizer vectors
      */
-    Node() {
+    explicit Node(const allocator_type &alloc = {})
+        : m_weights(alloc), m_gradient_accumulator(alloc), squared_gradient_avg(alloc) {
         m_num_inputs = 0;
         m_bias = 0;
-        m_weights.clear();
-        squared_gradient_avg.clear();
     };
 
     /**
@@ -58,10 +64,13 @@ public:
      * @param num_inputs Number of input connections to the node
      * @param use_constant_weight_init Flag to use constant weight initialization
      * @param constant_weight_init Value for constant weight initialization
+     * @param alloc Allocator for the weight and optimizer vectors
      */
     Node(int num_inputs,
          bool use_constant_weight_init = true,
-         T constant_weight_init = 0.5) {
+         T constant_weight_init = 0.5,
+         const allocator_type &alloc = {})
+        : Node(alloc) {
         m_num_inputs = num_inputs;
         m_bias = 0.0;
         m_weights.clear();
@@ -71,41 +80,78 @@ public:
                              constant_weight_init);
     };
 
+    Node(const Node &other) = default;
+    Node(Node &&other) = default;
+
+    /**
+     * @brief Copies a node into another memory resource
+     */
+    Node(const Node &other, const allocator_type &alloc)
+        : m_num_inputs(other.m_num_inputs),
+          m_bias(other.m_bias),
+          m_weights(other.m_weights, alloc),
+          m_gradient_accumulator(other.m_gradient_accumulator, alloc),
+          squared_gradient_avg(other.squared_gradient_avg, alloc),
+          m_bias_gradient_accumulator(other.m_bias_gradient_accumulator),
+          bias_squared_gradient_avg(other.bias_squared_gradient_avg),
+          inner_prod(other.inner_prod) {
+    }
+
+    /**
+     * @brief Moves a node; copies if the resources differ
+     */
+    Node(Node &&other, const allocator_type &alloc)
+        : m_num_inputs(other.m_num_inputs),
+          m_bias(other.m_bias),
+          m_weights(std::move(other.m_weights), alloc),
+          m_gradient_accumulator(std::move(other.m_gradient_accumulator), alloc),
+          squared_gradient_avg(std::move(other.squared_gradient_avg), alloc),
+          m_bias_gradient_accumulator(other.m_bias_gradient_accumulator),
+          bias_squared_gradient_avg(other.bias_squared_gradient_avg),
+          inner_prod(other.inner_prod) {
+    }
+
     ~Node() {
     };
 
+    /**
+     * @brief Allocator of the weight and optimizer vectors
+     */
+    allocator_type get_allocator() const {
+        return m_weights.get_allocator();
+    }
+
     /**
      * @brief Initializes the node's weights
      * @param num_inputs Number of input connections
      * @param use_constant_weight_init Flag to use constant weight initialization
      * @param constant_weight_init Value for constant weight initialization
+     * @param rng Generator for random initialization; the thread's generator if null
      */
     void WeightInitialization(int num_inputs,
                               bool use_constant_weight_init = true,
-                              T constant_weight_init = 0.5) {
+                              T constant_weight_init = 0.5,
+                              Random *rng = nullptr) {
         m_num_inputs = num_inputs;
         //initialize weight vector
         if (use_constant_weight_init) {
             m_weights.resize(m_num_inputs, constant_weight_init);
         } else {
             m_weights.resize(m_num_inputs);
-            std::generate_n(m_weights.begin(),
-                            m_num_inputs,
-                            utils::gen_rand<T>());
+            (rng ? *rng : ThreadRandom()).FillUniform(std::span<T>(m_weights),
+                                                      static_cast<T>(-1), static_cast<T>(1));
         }
         squared_gradient_avg.resize(m_num_inputs);
         std::fill(squared_gradient_avg.begin(), squared_gradient_avg.end(), 0.f);
     }
 
     /**
-     * @brief Randomizes weights with Gaussian noise
-     * @param variance The variance of the Gaussian distribution
+     * @brief Adds Gaussian noise to the weights
+     * @param stddev Standard deviation of the noise
+     * @param rng Generator to draw from
      */
-    void WeightRandomisation(const float variance) {
-        std::transform(m_weights.begin(),
-                       m_weights.end(),
-                       m_weights.begin(),
-                       utils::gen_randn<T>(variance));
+    void WeightRandomisation(const float stddev, Random &rng) {
+        rng.AddNormal(std::span<T>(m_weights), static_cast<T>(stddev));
     }
 
     /**
@@ -286,7 +332,7 @@ public:
      * @brief Gets reference to the weight vector
      * @return Reference to weights vector
      */
-    std::vector<T> & GetWeights() {
+    std::pmr::vector<T> & GetWeights() {
         return m_weights;
     }
 
@@ -294,7 +340,7 @@ public:
      * @brief Gets const reference to the weight vector
      * @return Const reference to weights vector
      */
-    const std::vector<T> & GetWeights() const {
+    const std::pmr::vector<T> & GetWeights() const {
         return m_weights;
     }
 
@@ -407,7 +453,7 @@ public:
 
     size_t m_num_inputs{ 0 }; /**< Number of inputs to this node */
     T m_bias{ 0.0 };         /**< Bias value for this node */
-    std::vector<T> m_weights; /**< Vector of input weights */
+    std::pmr::vector<T> m_weights; /**< Vector of input weights */
 
     /**
      * @brief Saves node state to file
@@ -459,8 +505,8 @@ public:
     /**
      * @brief Accumulated gradients for batch training
      */
-    std::vector<T> m_gradient_accumulator;
-    std::vector<T> squared_gradient_avg;
+    std::pmr::vector<T> m_gradient_accumulator;
+    std::pmr::vector<T> squared_gradient_avg;
     T m_bias_gradient_accumulator{0};
     T bias_squared_gradient_avg=0;
 
@@ -469,7 +515,7 @@ public:
     }
 private:
     Node<T>& operator=(Node<T> const &) = delete; /**< Deleted assignment operator */
-    T inner_prod;            /**< Cached inner product value */
+    T inner_prod{0};         /**< Cached inner product value */
 };
 
 } // namespace nisps
@@ -0,0 +1,281 @@
+/**
+ * @file profile.hpp
+ * @brief Compile-time gated timing hooks for the hot paths
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * NISPS_PROFILE_SCOPE("name") times the rest of the enclosing scope. Unless
+ * NISPS_ENABLE_PROFILING is defined it expands to nothing, so the hooks
+ * cost nothing in normal builds.
+ *
+ * When enabled, each thread records into its own slot of log2-bucketed
+ * histograms with relaxed atomic adds: no locks and no allocation on the
+ * recording path. Snapshot() and Dump() merge the slots on demand, from
+ * any thread, while recording continues.
+ *
+ * The clock is pluggable: define NISPS_PROFILE_NOW() (returning an unsigned
+ * tick count) and NISPS_PROFILE_TICKS_PER_SECOND before including any
+ * nisps header. By default Cortex-M targets read the DWT cycle counter
+ * (call profile::EnableCycleCounter() once at startup) and hosts use
+ * std::chrono::steady_clock in nanoseconds.
+ */
+
+#ifndef NISPS_PROFILE_HPP
+#define NISPS_PROFILE_HPP
+
+#ifdef NISPS_ENABLE_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifndef NISPS_PROFILE_NOW
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define NISPS_PROFILE_NOW() (*reinterpret_cast<volatile uint32_t *>(0xE0001004))  // DWT_CYCCNT
+#ifndef NISPS_PROFILE_TICKS_PER_SECOND
+#define NISPS_PROFILE_TICKS_PER_SECOND 150000000.0  // RP2350 default system clock
+#endif
+#else
+#include <chrono>
+#define NISPS_PROFILE_NOW() \
+    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>( \
+        std::chrono::steady_clock::now().time_since_epoch()).count())
+#define NISPS_PROFILE_TICKS_PER_SECOND 1e9
+#endif
+#endif
+
+#ifndef NISPS_PROFILE_TICKS_PER_SECOND
+#define NISPS_PROFILE_TICKS_PER_SECOND 1.0
+#endif
+
+#ifndef NISPS_PROFILE_MAX_SITES
+#define NISPS_PROFILE_MAX_SITES 32
+#endif
+
+#ifndef NISPS_PROFILE_MAX_THREADS
+#define NISPS_PROFILE_MAX_THREADS 4
+#endif
+
+namespace nisps {
+
+namespace profile {
+
+// Device clocks are often a volatile register lvalue; strip that to get the value type
+using ticks_t = std::make_unsigned_t<std::remove_cvref_t<decltype(NISPS_PROFILE_NOW())>>;
+
+/** 64-bit where that is lock-free, else 32-bit (totals then wrap, e.g. on Cortex-M) */
+using counter_t = std::conditional_t<std::atomic<uint64_t>::is_always_lock_free, uint64_t, uint32_t>;
+
+constexpr size_t kMaxSites = NISPS_PROFILE_MAX_SITES;
+constexpr size_t kMaxThreads = NISPS_PROFILE_MAX_THREADS;
+constexpr size_t kBuckets = 32;  /**< Bucket b holds durations with bit width b; the last also holds longer ones */
+
+struct Histogram {
+    std::atomic<uint32_t> buckets[kBuckets];
+    std::atomic<counter_t> count;
+    std::atomic<counter_t> total;
+    std::atomic<counter_t> max;
+};
+
+/** One per thread; threads beyond kMaxThreads share the last slot */
+struct Slot {
+    Histogram sites[kMaxSites];
+};
+
+inline Slot g_slots[kMaxThreads];
+inline std::atomic<size_t> g_num_slots{0};
+inline std::atomic<const char *> g_names[kMaxSites];
+inline std::atomic<size_t> g_num_sites{0};
+
+inline Slot &ThreadSlot() {
+    thread_local Slot *slot = &g_slots[std::min(g_num_slots.fetch_add(1), kMaxThreads - 1)];
+    return *slot;
+}
+
+/**
+ * @brief A named instrumentation point, registered once on first use.
+ */
+class Site {
+ public:
+    explicit Site(const char *name) : id_(g_num_sites.fetch_add(1)) {
+        if (id_ < kMaxSites) {
+            g_names[id_].store(name, std::memory_order_release);
+        }
+    }
+
+    void Record(ticks_t ticks) const {
+        if (id_ >= kMaxSites) {
+            return;
+        }
+        Histogram &h = ThreadSlot().sites[id_];
+        const size_t b = std::min<size_t>(std::bit_width(ticks), kBuckets - 1);
+        h.buckets[b].fetch_add(1, std::memory_order_relaxed);
+        h.total.fetch_add(static_cast<counter_t>(ticks), std::memory_order_relaxed);
+        counter_t m = h.max.load(std::memory_order_relaxed);
+        while (ticks > m && !h.max.compare_exchange_weak(m, static_cast<counter_t>(ticks),
+                                                         std::memory_order_relaxed)) {
+        }
+        h.count.fetch_add(1, std::memory_order_release);
+    }
+
+ private:
+    const size_t id_;
+};
+
+/**
+ * @brief Records the time from construction to destruction at a site.
+ */
+class Scope {
+ public:
+    explicit Scope(const Site &site) : site_(site), start_(NISPS_PROFILE_NOW()) {}
+    ~Scope() { site_.Record(static_cast<ticks_t>(NISPS_PROFILE_NOW() - start_)); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+ private:
+    const Site &site_;
+    const ticks_t start_;
+};
+
+/**
+ * @brief Merged statistics of every site with the same name.
+ *
+ * Percentiles are upper bounds of log2 buckets, so within a factor of two.
+ */
+struct SiteStats {
+    const char *name = nullptr;
+    uint64_t count = 0;
+    double mean_us = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    uint64_t buckets[kBuckets] = {};
+};
+
+/**
+ * @brief Merges all threads' histograms. Allocates; call outside the hot paths.
+ */
+inline std::vector<SiteStats> Snapshot() {
+    constexpr double kUsPerTick = 1e6 / NISPS_PROFILE_TICKS_PER_SECOND;
+    std::vector<SiteStats> stats;
+    std::vector<double> totals;
+    const size_t n_sites = std::min(g_num_sites.load(std::memory_order_acquire), kMaxSites);
+    for (size_t id = 0; id < n_sites; id++) {
+        const char *name = g_names[id].load(std::memory_order_acquire);
+        if (!name) {
+            continue;
+        }
+        // Template functions register one site per instantiation; merge them by name
+        size_t s = 0;
+        while (s < stats.size() && std::strcmp(stats[s].name, name) != 0) {
+            s++;
+        }
+        if (s == stats.size()) {
+            stats.emplace_back();
+            stats.back().name = name;
+            totals.push_back(0);
+        }
+        SiteStats &st = stats[s];
+        for (auto &slot : g_slots) {
+            const Histogram &h = slot.sites[id];
+            st.count += h.count.load(std::memory_order_acquire);
+            totals[s] += static_cast<double>(h.total.load(std::memory_order_relaxed));
+            st.max_us = std::max(st.max_us, h.max.load(std::memory_order_relaxed) * kUsPerTick);
+            for (size_t b = 0; b < kBuckets; b++) {
+                st.buckets[b] += h.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    for (size_t s = 0; s < stats.size(); s++) {
+        SiteStats &st = stats[s];
+        if (st.count == 0) {
+            continue;
+        }
+        st.mean_us = totals[s] * kUsPerTick / static_cast<double>(st.count);
+        auto percentile = [&](double p) {
+            uint64_t seen = 0, n = 0;
+            for (auto c : st.buckets) {
+                n += c;
+            }
+            for (size_t b = 0; b < kBuckets; b++) {
+                seen += st.buckets[b];
+                if (seen > 0 && static_cast<double>(seen) >= p * static_cast<double>(n)) {
+                    return b + 1 == kBuckets
+                        ? st.max_us
+                        : std::min(st.max_us, static_cast<double>((uint64_t(1) << b) - 1) * kUsPerTick);
+                }
+            }
+            return st.max_us;
+        };
+        st.p50_us = percentile(0.5);
+        st.p99_us = percentile(0.99);
+    }
+    return stats;
+}
+
+/**
+ * @brief Prints one line per site through a callback, e.g. a serial logger.
+ */
+inline void Dump(void (*print)(const char *)) {
+    char line[160];
+    for (const auto &s : Snapshot()) {
+        std::snprintf(line, sizeof(line), "%-24s n=%llu mean=%.2fus p50<=%.2fus p99<=%.2fus max=%.2fus",
+                      s.name, static_cast<unsigned long long>(s.count), s.mean_us, s.p50_us, s.p99_us,
+                      s.max_us);
+        print(line);
+    }
+}
+
+/**
+ * @brief Clears all histograms. Samples recorded concurrently may be partly kept.
+ */
+inline void Reset() {
+    for (auto &slot : g_slots) {
+        for (auto &h : slot.sites) {
+            for (auto &b : h.buckets) {
+                b.store(0, std::memory_order_relaxed);
+            }
+            h.total.store(0, std::memory_order_relaxed);
+            h.max.store(0, std::memory_order_relaxed);
+            h.count.store(0, std::memory_order_release);
+        }
+    }
+}
+
+/**
+ * @brief Starts the Cortex-M DWT cycle counter the default device clock reads.
+ */
+inline void EnableCycleCounter() {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+    *reinterpret_cast<volatile uint32_t *>(0xE000EDFC) |= (1u << 24);  // DEMCR.TRCENA
+    *reinterpret_cast<volatile uint32_t *>(0xE0001004) = 0;            // DWT_CYCCNT
+    *reinterpret_cast<volatile uint32_t *>(0xE0001000) |= 1u;          // DWT_CTRL.CYCCNTENA
+#endif
+}
+
+}  // namespace profile
+
+}  // namespace nisps
+
+#define NISPS_PROFILE_CONCAT_(a, b) a##b
+#define NISPS_PROFILE_CONCAT(a, b) NISPS_PROFILE_CONCAT_(a, b)
+#define NISPS_PROFILE_SCOPE(name) \
+    static const ::nisps::profile::Site NISPS_PROFILE_CONCAT(nisps_profile_site_, __LINE__)(name); \
+    const ::nisps::profile::Scope NISPS_PROFILE_CONCAT(nisps_profile_scope_, __LINE__)( \
+        NISPS_PROFILE_CONCAT(nisps_profile_site_, __LINE__))
+
+#else
+
+#define NISPS_PROFILE_SCOPE(name)
+
+#endif  // NISPS_ENABLE_PROFILING
+
+#endif  // NISPS_PROFILE_HPP
@@ -0,0 +1,375 @@
+/**
+ * @file pruning.hpp
+ * @brief Magnitude pruning and sparse inference for trained networks
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Pruning zeroes the smallest-magnitude weights, either against one
+ * threshold for the whole network or against a separate sparsity target
+ * per layer. Biases are never pruned. SparseInference then evaluates the
+ * pruned network, storing each layer both densely and in compressed sparse
+ * row (CSR) form and timing both kernels to pick the faster one per layer:
+ * at small sizes or moderate sparsity the dense loop often still wins.
+ */
+
+#ifndef NISPS_PRUNING_HPP
+#define NISPS_PRUNING_HPP
+
+#include "mlp.hpp"
+#include "kernels.hpp"
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+
+namespace nisps {
+
+/**
+ * @class MagnitudePruner
+ * @brief Removes small weights from an MLP and keeps them removed while fine-tuning.
+ *
+ * The pruner keeps a mask per layer in the node-major weight order (see
+ * MLP::GetLayerParameters()); a pruned weight stays zero after
+ * FineTune() and ApplyMask().
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class MagnitudePruner {
+ public:
+    /**
+     * @param mlp Network to prune; starts with nothing pruned
+     */
+    explicit MagnitudePruner(MLP<T> &mlp) : mlp_(mlp) {
+        masks_.resize(mlp.m_layers.size());
+        ClearMask();
+    }
+
+    /**
+     * @brief Prunes the smallest weights of the whole network against a single threshold.
+     *
+     * Layers with many small weights lose more of them than others.
+     *
+     * @param sparsity Fraction of all weights to prune, in [0, 1]
+     * @return false if sparsity is out of range
+     */
+    bool PruneGlobal(T sparsity) {
+        if (!(sparsity >= 0 && sparsity <= 1)) {
+            return false;
+        }
+        std::vector<const T *> weights;
+        std::vector<uint8_t *> keep;
+        for (size_t l = 0; l < mlp_.m_layers.size(); l++) {
+            Collect(l, weights, keep);
+        }
+        Prune(weights, keep, sparsity);
+        ApplyMask();
+        return true;
+    }
+
+    /**
+     * @brief Prunes each layer to its own sparsity target.
+     * @param sparsity One fraction in [0, 1] per layer
+     * @return false if the size or any value is out of range
+     */
+    bool PruneLayers(std::span<const T> sparsity) {
+        if (sparsity.size() != masks_.size()) {
+            return false;
+        }
+        for (T s : sparsity) {
+            if (!(s >= 0 && s <= 1)) {
+                return false;
+            }
+        }
+        std::vector<const T *> weights;
+        std::vector<uint8_t *> keep;
+        for (size_t l = 0; l < masks_.size(); l++) {
+            weights.clear();
+            keep.clear();
+            Collect(l, weights, keep);
+            Prune(weights, keep, sparsity[l]);
+        }
+        ApplyMask();
+        return true;
+    }
+
+    /**
+     * @brief Zeroes every pruned weight, e.g. after the weights were edited.
+     */
+    void ApplyMask() {
+        for (size_t l = 0; l < masks_.size(); l++) {
+            const uint8_t *keep = masks_[l].data();
+            for (auto &node : mlp_.m_layers[l].m_nodes) {
+                for (T &w : node.m_weights) {
+                    if (!*keep++) {
+                        w = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Trains the pruned network for a few epochs, reapplying the mask after each.
+     * @param data Training data with bias
+     * @param learning_rate Learning rate for MLP::Train()
+     * @param epochs Number of epochs
+     * @return Loss of the last epoch
+     */
+    T FineTune(const typename MLP<T>::training_pair_t &data, float learning_rate, int epochs) {
+        T loss = 0;
+        for (int e = 0; e < epochs; e++) {
+            loss = mlp_.Train(data, learning_rate, 1, 0, false);
+            ApplyMask();
+        }
+        return loss;
+    }
+
+    /**
+     * @brief Marks every weight as kept again; zeroed weights stay zero until trained.
+     */
+    void ClearMask() {
+        for (size_t l = 0; l < masks_.size(); l++) {
+            masks_[l].assign(NumWeights(l), 1);
+        }
+    }
+
+    /**
+     * @brief Mask of one layer: 1 for kept weights, 0 for pruned ones, node-major.
+     */
+    const std::vector<uint8_t> &GetMask(size_t layer) const { return masks_[layer]; }
+
+    /**
+     * @brief Fraction of one layer's weights that are pruned.
+     */
+    T GetSparsity(size_t layer) const {
+        const auto &mask = masks_[layer];
+        if (mask.empty()) {
+            return 0;
+        }
+        const size_t kept = std::accumulate(mask.begin(), mask.end(), size_t(0));
+        return static_cast<T>(mask.size() - kept) / static_cast<T>(mask.size());
+    }
+
+    /**
+     * @brief Fraction of all weights that are pruned.
+     */
+    T GetSparsity() const {
+        size_t total = 0, kept = 0;
+        for (const auto &mask : masks_) {
+            total += mask.size();
+            kept += std::accumulate(mask.begin(), mask.end(), size_t(0));
+        }
+        return total ? static_cast<T>(total - kept) / static_cast<T>(total) : 0;
+    }
+
+ private:
+    size_t NumWeights(size_t l) const {
+        const auto &layer = mlp_.m_layers[l];
+        return static_cast<size_t>(layer.GetOutputSize()) * static_cast<size_t>(layer.GetInputSize());
+    }
+
+    void Collect(size_t l, std::vector<const T *> &weights, std::vector<uint8_t *> &keep) {
+        uint8_t *mask = masks_[l].data();
+        for (const auto &node : mlp_.m_layers[l].m_nodes) {
+            for (const T &w : node.m_weights) {
+                weights.push_back(&w);
+                keep.push_back(mask++);
+            }
+        }
+    }
+
+    /**
+     * @brief Prunes the given fraction of the weights, smallest magnitude first.
+     *
+     * Weights pruned earlier count towards the target, so repeated calls with
+     * a rising sparsity prune iteratively.
+     */
+    void Prune(const std::vector<const T *> &weights, const std::vector<uint8_t *> &keep, T sparsity) {
+        const size_t n = weights.size();
+        const size_t n_prune = std::min(n, static_cast<size_t>(std::lround(sparsity * static_cast<T>(n))));
+        if (n_prune == 0) {
+            return;
+        }
+        order_.resize(n);
+        std::iota(order_.begin(), order_.end(), size_t(0));
+        auto magnitude = [&](size_t i) { return *keep[i] ? std::abs(*weights[i]) : static_cast<T>(-1); };
+        std::nth_element(order_.begin(), order_.begin() + (n_prune - 1), order_.end(),
+                         [&](size_t a, size_t b) { return magnitude(a) < magnitude(b); });
+        for (size_t i = 0; i < n_prune; i++) {
+            *keep[order_[i]] = 0;
+        }
+    }
+
+    MLP<T> &mlp_;
+    std::vector<std::vector<uint8_t>> masks_;
+    std::vector<size_t> order_;
+};
+
+/**
+ * @class SparseInference
+ * @brief Evaluates a pruned MLP with the faster of a dense and a CSR kernel per layer.
+ *
+ * Zero weights are treated as pruned. Call Rebuild() after the network's
+ * weights change; it re-packs both formats and re-runs the benchmark.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class SparseInference {
+ public:
+    /**
+     * @param mlp Network to evaluate
+     * @param benchmark_repeats Timed calls of each kernel per layer when choosing; 0
+     *        skips the benchmark and keeps every layer dense
+     */
+    explicit SparseInference(const MLP<T> &mlp, size_t benchmark_repeats = 64)
+        : mlp_(mlp),
+          repeats_(benchmark_repeats) {
+        Rebuild();
+    }
+
+    /**
+     * @brief Re-packs the network's current weights and chooses a kernel per layer.
+     */
+    void Rebuild() {
+        const size_t n_layers = mlp_.m_layers.size();
+        layers_.resize(n_layers);
+        for (size_t l = 0; l < n_layers; l++) {
+            const auto &src = mlp_.m_layers[l];
+            Packed &p = layers_[l];
+            p.rows = src.GetOutputSize();
+            p.cols = src.GetInputSize();
+            p.activation = src.GetActivationFunction();
+            p.dense.resize(p.rows * p.cols);
+            p.bias.resize(p.rows);
+            p.row_ptr.assign(1, 0);
+            p.col_idx.clear();
+            p.values.clear();
+            for (size_t r = 0; r < p.rows; r++) {
+                const auto &node = src.m_nodes[r];
+                std::copy(node.m_weights.begin(), node.m_weights.end(), p.dense.begin() + r * p.cols);
+                p.bias[r] = node.m_bias;
+                for (size_t c = 0; c < p.cols; c++) {
+                    if (node.m_weights[c] != 0) {
+                        p.col_idx.push_back(static_cast<uint32_t>(c));
+                        p.values.push_back(node.m_weights[c]);
+                    }
+                }
+                p.row_ptr.push_back(static_cast<uint32_t>(p.values.size()));
+            }
+            p.z.resize(p.rows);
+            p.sparse = false;
+        }
+        output_.resize(n_layers ? layers_.back().rows : 0);
+        SelectKernels();
+    }
+
+    /**
+     * @brief Times both kernels on every layer and keeps the faster one.
+     *
+     * A layer only switches to CSR when it measured faster than the dense
+     * kernel; ties stay dense.
+     */
+    void SelectKernels() {
+        using clock = std::chrono::steady_clock;
+        for (auto &p : layers_) {
+            p.sparse = false;
+            if (repeats_ == 0 || p.values.size() == p.dense.size()) {
+                continue;
+            }
+            bench_input_.assign(p.cols, static_cast<T>(0.5));
+            auto time = [&](bool sparse) {
+                Run(p, bench_input_.data(), sparse);  // Warm up
+                const auto start = clock::now();
+                for (size_t i = 0; i < repeats_; i++) {
+                    Run(p, bench_input_.data(), sparse);
+                }
+                return clock::now() - start;
+            };
+            const auto dense = time(false);
+            const auto sparse = time(true);
+            p.sparse = sparse < dense;
+        }
+    }
+
+    /**
+     * @brief Forces the kernel of one layer.
+     */
+    void SetLayerSparse(size_t layer, bool sparse) { layers_[layer].sparse = sparse; }
+
+    bool IsLayerSparse(size_t layer) const { return layers_[layer].sparse; }
+
+    /**
+     * @brief Fraction of one layer's weights that are non-zero.
+     */
+    T GetLayerDensity(size_t layer) const {
+        const Packed &p = layers_[layer];
+        return p.dense.empty() ? 0 : static_cast<T>(p.values.size()) / static_cast<T>(p.dense.size());
+    }
+
+    /**
+     * @brief Evaluates the network.
+     * @param input Network input (including any bias input the network expects)
+     * @return Network outputs, valid until the next call
+     */
+    const std::vector<T> &Process(std::span<const T> input) {
+        if (layers_.empty() || input.size() != layers_[0].cols) {
+            return output_;
+        }
+        const T *x = input.data();
+        for (auto &p : layers_) {
+            Run(p, x, p.sparse);
+            for (auto &v : p.z) {
+                v = p.activation(v);
+            }
+            x = p.z.data();
+        }
+        std::copy(layers_.back().z.begin(), layers_.back().z.end(), output_.begin());
+        if (mlp_.GetLossFunctionType() == loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY &&
+            output_.size() > 1) {
+            utils::Softmax(&output_);
+        }
+        return output_;
+    }
+
+ private:
+    struct Packed {
+        size_t rows = 0;
+        size_t cols = 0;
+        activation_func_t<T> activation = nullptr;
+        std::vector<T> dense;             /**< rows x cols, row-major */
+        std::vector<T> bias;
+        std::vector<uint32_t> row_ptr;    /**< CSR row offsets */
+        std::vector<uint32_t> col_idx;    /**< CSR column of each value */
+        std::vector<T> values;            /**< CSR non-zero weights */
+        std::vector<T> z;                 /**< Layer output */
+        bool sparse = false;
+    };
+
+    static void Run(Packed &p, const T *x, bool sparse) {
+        if (sparse) {
+            kernels::CsrGemv(p.row_ptr.data(), p.col_idx.data(), p.values.data(), p.bias.data(),
+                             p.rows, x, p.z.data());
+        } else {
+            kernels::Gemv(p.dense.data(), p.bias.data(), p.rows, p.cols, x, p.z.data());
+        }
+    }
+
+    const MLP<T> &mlp_;
+    const size_t repeats_;
+    std::vector<Packed> layers_;
+    std::vector<T> bench_input_;
+    std::vector<T> output_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_PRUNING_HPP
@@ -0,0 +1,259 @@
+/**
+ * @file random.hpp
+ * @brief Fast, seedable per-instance pseudo-random number generator
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * The generator is xoshiro128+ (Blackman and Vigna), which needs only
+ * 32-bit operations and is fast on microcontrollers as well as desktops.
+ * Seeds are expanded with splitmix64. Jump() advances the state by 2^64
+ * draws, giving non-overlapping streams for threads or population members.
+ */
+
+#ifndef NISPS_RANDOM_HPP
+#define NISPS_RANDOM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <random>
+
+namespace nisps {
+
+/**
+ * @class Random
+ * @brief xoshiro128+ generator with bulk uniform and Gaussian fills.
+ *
+ * Satisfies UniformRandomBitGenerator, so it also works with std::shuffle
+ * and the standard distributions. Not thread-safe: give each thread its
+ * own instance (see Jump()).
+ */
+class Random {
+ public:
+    using result_type = uint32_t;
+
+    static constexpr uint64_t kDefaultSeed = 0x853c49e6748fea9bULL;
+
+    explicit Random(uint64_t seed = kDefaultSeed) {
+        Seed(seed);
+    }
+
+    /**
+     * @brief Resets the state from a 64-bit seed.
+     */
+    void Seed(uint64_t seed) {
+        for (size_t i = 0; i < 4; i += 2) {
+            const uint64_t z = SplitMix64(seed);
+            s_[i] = static_cast<uint32_t>(z);
+            s_[i + 1] = static_cast<uint32_t>(z >> 32);
+        }
+        // The all-zero state is the one state xoshiro cannot leave
+        if ((s_[0] | s_[1] | s_[2] | s_[3]) == 0) {
+            s_[0] = 1;
+        }
+        has_spare_ = false;
+    }
+
+    /**
+     * @brief Advances the state by 2^64 draws.
+     *
+     * Seed one instance, then copy and Jump() it once per extra stream.
+     */
+    void Jump() {
+        static constexpr uint32_t kJump[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+        uint32_t t[4] = { 0, 0, 0, 0 };
+        for (uint32_t word : kJump) {
+            for (int b = 0; b < 32; b++) {
+                if (word & (1u << b)) {
+                    t[0] ^= s_[0];
+                    t[1] ^= s_[1];
+                    t[2] ^= s_[2];
+                    t[3] ^= s_[3];
+                }
+                Next();
+            }
+        }
+        s_[0] = t[0];
+        s_[1] = t[1];
+        s_[2] = t[2];
+        s_[3] = t[3];
+        has_spare_ = false;
+    }
+
+    /**
+     * @brief Returns a copy of this generator advanced to stream n.
+     */
+    Random Stream(size_t n) const {
+        Random r(*this);
+        for (size_t i = 0; i < n; i++) {
+            r.Jump();
+        }
+        return r;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
+    result_type operator()() { return Next(); }
+
+    /**
+     * @brief Next 32 random bits.
+     */
+    uint32_t Next() {
+        const uint32_t result = s_[0] + s_[3];
+        const uint32_t t = s_[1] << 9;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = (s_[3] << 11) | (s_[3] >> 21);
+        return result;
+    }
+
+    /**
+     * @brief Uniform integer in [0, n); n must be non-zero.
+     */
+    uint32_t Below(uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(Next()) * n) >> 32);
+    }
+
+    /**
+     * @brief Uniform value in [0, 1).
+     */
+    template<typename T>
+    T Uniform() {
+        // The low bits of xoshiro128+ are weak; use the top 24
+        return static_cast<T>(Next() >> 8) * static_cast<T>(1.0 / 16777216.0);
+    }
+
+    /**
+     * @brief Uniform value in [lo, hi).
+     */
+    template<typename T>
+    T Uniform(T lo, T hi) {
+        return lo + (hi - lo) * Uniform<T>();
+    }
+
+    /**
+     * @brief Standard normal value.
+     */
+    template<typename T>
+    T Normal() {
+        if (has_spare_) {
+            has_spare_ = false;
+            return static_cast<T>(spare_);
+        }
+        float z0, z1;
+        BoxMuller(Next(), Next(), z0, z1);
+        spare_ = z1;
+        has_spare_ = true;
+        return static_cast<T>(z0);
+    }
+
+    /**
+     * @brief Fills a buffer with uniform values in [lo, hi).
+     */
+    template<typename T>
+    void FillUniform(std::span<T> out, T lo, T hi) {
+        const T scale = (hi - lo) * static_cast<T>(1.0 / 16777216.0);
+        for (auto &v : out) {
+            v = lo + static_cast<T>(Next() >> 8) * scale;
+        }
+    }
+
+    /**
+     * @brief Fills a buffer with normal values.
+     *
+     * Raw bits are drawn for a block first, then the Box-Muller transform
+     * runs over the whole block in a loop without dependencies between
+     * iterations, so it can be vectorized.
+     */
+    template<typename T>
+    void FillNormal(std::span<T> out, T mean = 0, T stddev = 1) {
+        Normals(out.size(), [&](size_t i, float z) {
+            out[i] = mean + stddev * static_cast<T>(z);
+        });
+    }
+
+    /**
+     * @brief Adds normal noise to every value in a buffer.
+     */
+    template<typename T>
+    void AddNormal(std::span<T> inout, T stddev) {
+        Normals(inout.size(), [&](size_t i, float z) {
+            inout[i] += stddev * static_cast<T>(z);
+        });
+    }
+
+ private:
+    static uint64_t SplitMix64(uint64_t &x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    static void BoxMuller(uint32_t a, uint32_t b, float &z0, float &z1) {
+        // u1 in (0, 1] so the log is finite
+        const float u1 = static_cast<float>((a >> 8) + 1) * (1.0f / 16777216.0f);
+        const float u2 = static_cast<float>(b >> 8) * (1.0f / 16777216.0f);
+        const float r = std::sqrt(-2.0f * std::log(u1));
+        const float theta = 2.0f * std::numbers::pi_v<float> * u2;
+        z0 = r * std::cos(theta);
+        z1 = r * std::sin(theta);
+    }
+
+    template<typename Fn>
+    void Normals(size_t n, Fn &&emit) {
+        static constexpr size_t kBlock = 64;
+        uint32_t bits[kBlock];
+        float z0[kBlock / 2], z1[kBlock / 2];
+        size_t i = 0;
+        while (i < n) {
+            const size_t pairs = std::min(kBlock / 2, (n - i + 1) / 2);
+            for (size_t j = 0; j < 2 * pairs; j++) {
+                bits[j] = Next();
+            }
+            for (size_t j = 0; j < pairs; j++) {
+                BoxMuller(bits[2 * j], bits[2 * j + 1], z0[j], z1[j]);
+            }
+            for (size_t j = 0; j < pairs && i < n; j++) {
+                emit(i++, z0[j]);
+                if (i < n) {
+                    emit(i++, z1[j]);
+                }
+            }
+        }
+    }
+
+    uint32_t s_[4];
+    float spare_ = 0;
+    bool has_spare_ = false;
+};
+
+/**
+ * @brief Seed drawn from the system entropy source.
+ */
+inline uint64_t RandomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+/**
+ * @brief Per-thread generator for code without its own instance.
+ */
+inline Random &ThreadRandom() {
+    thread_local Random rng(RandomSeed());
+    return rng;
+}
+
+}  // namespace nisps
+
+#endif  // NISPS_RANDOM_HPP
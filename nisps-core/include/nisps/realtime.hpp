@@ -0,0 +1,88 @@
+/**
+ * @file realtime.hpp
+ * @brief Markers for code that must not allocate or lock
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * NISPS_RT_SECTION("name") marks the rest of the enclosing scope as
+ * real-time: called from an audio or control callback, so it must not
+ * allocate, free or take a lock. Unless NISPS_ENABLE_RT_CHECKS is defined
+ * it expands to nothing.
+ *
+ * When enabled, the markers only keep a per-thread nesting depth and the
+ * name of the outermost section. A checker that interposes the allocator
+ * and the mutex calls (see test/rt_safety_test.cpp) reads them through
+ * rt::InSection() and rt::CurrentSection() to tell a violation from an
+ * allowed call.
+ */
+
+#ifndef NISPS_REALTIME_HPP
+#define NISPS_REALTIME_HPP
+
+#ifdef NISPS_ENABLE_RT_CHECKS
+
+namespace nisps {
+
+namespace rt {
+
+inline thread_local unsigned g_depth = 0;
+inline thread_local const char *g_section = nullptr;
+
+/**
+ * @brief Marks a real-time scope; nested sections report the outermost name.
+ */
+class Section {
+ public:
+    /**
+     * @param name Reported with violations
+     * @param active False makes the section a no-op, e.g. for a training-only call path
+     */
+    explicit Section(const char *name, bool active = true) : active_(active) {
+        if (active_ && g_depth++ == 0) {
+            g_section = name;
+        }
+    }
+    ~Section() {
+        if (active_ && --g_depth == 0) {
+            g_section = nullptr;
+        }
+    }
+    Section(const Section &) = delete;
+    Section &operator=(const Section &) = delete;
+
+ private:
+    const bool active_;
+};
+
+/**
+ * @brief Whether the calling thread is inside a real-time section.
+ */
+inline bool InSection() { return g_depth > 0; }
+
+/**
+ * @brief Name of the calling thread's outermost section, or null.
+ */
+inline const char *CurrentSection() { return g_section; }
+
+}  // namespace rt
+
+}  // namespace nisps
+
+#define NISPS_RT_CONCAT_(a, b) a##b
+#define NISPS_RT_CONCAT(a, b) NISPS_RT_CONCAT_(a, b)
+#define NISPS_RT_SECTION(name) \
+    const ::nisps::rt::Section NISPS_RT_CONCAT(nisps_rt_section_, __LINE__)(name)
+#define NISPS_RT_SECTION_IF(name, active) \
+    const ::nisps::rt::Section NISPS_RT_CONCAT(nisps_rt_section_, __LINE__)(name, active)
+
+#else
+
+#define NISPS_RT_SECTION(name)
+#define NISPS_RT_SECTION_IF(name, active)
+
+#endif  // NISPS_ENABLE_RT_CHECKS
+
+#endif  // NISPS_REALTIME_HPP
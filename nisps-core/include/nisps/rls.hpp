@@ -0,0 +1,161 @@
+/**
+ * @file rls.hpp
+ * @brief Recursive-least-squares adaptation of an MLP's output layer
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_RLS_HPP
+#define NISPS_RLS_HPP
+
+#include "mlp.hpp"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace nisps {
+
+/**
+ * @class LastLayerRLS
+ * @brief Fits the output layer to single examples as they arrive.
+ *
+ * The hidden layers are treated as a fixed feature extractor. The output
+ * layer's weights and bias are then a linear least-squares problem in its
+ * pre-activation, which recursive least squares solves exactly and
+ * incrementally: each Update() costs O(h^2 + h * outputs), where h is the
+ * number of output-layer inputs plus one for the bias. There is no
+ * iteration and no learning rate.
+ *
+ * Targets are mapped through the inverse of the output activation (logit
+ * for SIGMOID, atanh for TANH) so the fit happens where the layer is linear.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class LastLayerRLS {
+ public:
+    /**
+     * @brief Prepares the inverse-covariance matrix for a network's output layer.
+     * @param mlp Network to adapt; its output layer must be SIGMOID, TANH or LINEAR
+     * @param forgetting Forgetting factor in (0, 1]; below 1 favours recent examples
+     * @param initial_variance Scale of the initial inverse covariance; larger trusts the
+     *        first examples more relative to the current weights
+     */
+    explicit LastLayerRLS(MLP<T> &mlp, T forgetting = 1, T initial_variance = 1000)
+        : mlp_(mlp),
+          forgetting_(forgetting),
+          initial_variance_(initial_variance),
+          h_(static_cast<size_t>(mlp.m_layers.back().GetInputSize()) + 1),
+          p_(h_ * h_),
+          x_(h_),
+          px_(h_) {
+        Reset();
+    }
+
+    /**
+     * @brief Forgets all examples seen so far.
+     *
+     * Call after the hidden layers changed, e.g. after a full retrain.
+     */
+    void Reset() {
+        std::fill(p_.begin(), p_.end(), static_cast<T>(0));
+        for (size_t i = 0; i < h_; i++) {
+            p_[i * h_ + i] = initial_variance_;
+        }
+    }
+
+    /**
+     * @brief Moves the output layer towards one example.
+     * @param input Network input (including any bias input the network expects)
+     * @param target Desired network output
+     * @return false if sizes do not match or the output activation is unsupported
+     */
+    bool Update(const std::vector<T> &input, const std::vector<T> &target) {
+        Layer<T> &layer = mlp_.m_layers.back();
+        const ACTIVATION_FUNCTIONS activation = layer.GetActivationFunctionType();
+        if (target.size() != static_cast<size_t>(layer.GetOutputSize()) ||
+            (activation != SIGMOID && activation != TANH && activation != LINEAR)) {
+            return false;
+        }
+
+        activations_.clear();
+        mlp_.GetOutput(input, &output_, &activations_, false);
+        if (activations_.empty()) {
+            return false;
+        }
+        const std::vector<T> &a = activations_.back();
+        std::copy(a.begin(), a.end(), x_.begin());
+        x_[h_ - 1] = 1;  // Bias
+
+        // k = P x / (lambda + x' P x)
+        T denom = forgetting_;
+        for (size_t i = 0; i < h_; i++) {
+            const T *row = p_.data() + i * h_;
+            T sum = 0;
+            for (size_t j = 0; j < h_; j++) {
+                sum += row[j] * x_[j];
+            }
+            px_[i] = sum;
+            denom += x_[i] * sum;
+        }
+        const T inv_denom = static_cast<T>(1) / denom;
+
+        auto &nodes = layer.GetNodesChangeable();
+        for (size_t o = 0; o < nodes.size(); o++) {
+            auto &w = nodes[o].GetWeights();
+            T z = nodes[o].GetBias();
+            for (size_t j = 0; j + 1 < h_; j++) {
+                z += w[j] * x_[j];
+            }
+            const T e = (InverseActivation(activation, target[o]) - z) * inv_denom;
+            for (size_t j = 0; j + 1 < h_; j++) {
+                w[j] += px_[j] * e;
+            }
+            nodes[o].SetBias(nodes[o].GetBias() + px_[h_ - 1] * e);
+        }
+
+        // P = (P - k (P x)') / lambda, kept symmetric
+        const T inv_lambda = static_cast<T>(1) / forgetting_;
+        for (size_t i = 0; i < h_; i++) {
+            T *row = p_.data() + i * h_;
+            const T ki = px_[i] * inv_denom;
+            for (size_t j = 0; j < h_; j++) {
+                row[j] = (row[j] - ki * px_[j]) * inv_lambda;
+            }
+        }
+        return true;
+    }
+
+ private:
+    static T InverseActivation(ACTIVATION_FUNCTIONS activation, T y) {
+        constexpr T kEpsilon = static_cast<T>(1e-3);
+        switch (activation) {
+            case SIGMOID:
+                y = std::clamp(y, kEpsilon, static_cast<T>(1) - kEpsilon);
+                return std::log(y / (static_cast<T>(1) - y));
+            case TANH:
+                y = std::clamp(y, static_cast<T>(-1) + kEpsilon, static_cast<T>(1) - kEpsilon);
+                return std::atanh(y);
+            default:
+                return y;
+        }
+    }
+
+    MLP<T> &mlp_;
+    const T forgetting_;
+    const T initial_variance_;
+    const size_t h_;                 /**< Output-layer inputs plus bias */
+    std::vector<T> p_;               /**< Inverse covariance, h x h row-major */
+    std::vector<T> x_;
+    std::vector<T> px_;
+    std::vector<T> output_;
+    std::vector<std::vector<T>> activations_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_RLS_HPP
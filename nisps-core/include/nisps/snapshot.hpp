@@ -0,0 +1,152 @@
+/**
+ * @file snapshot.hpp
+ * @brief Bounded undo/redo history of network parameters in flat buffers
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_SNAPSHOT_HPP
+#define NISPS_SNAPSHOT_HPP
+
+#include "mlp.hpp"
+
+#include <vector>
+#include <span>
+#include <cstddef>
+
+namespace nisps {
+
+/**
+ * @class ParameterSnapshots
+ * @brief Multi-level undo and redo of MLP parameters.
+ *
+ * All snapshot storage is allocated once at construction as a single flat
+ * array, so Capture(), Undo() and Redo() are a straight copy of the
+ * parameters with no allocation. When the history is full the oldest
+ * snapshot is overwritten.
+ *
+ * Slots are used as a ring: the undo history, then one slot for the
+ * current state, then the redo history.
+ *
+ * @tparam T Scalar type of the network
+ */
+template<typename T>
+class ParameterSnapshots {
+ public:
+    /**
+     * @brief Allocates the history for a network.
+     * @param mlp Network whose parameter count sizes each snapshot
+     * @param depth Maximum number of undo steps
+     * @param with_optimizer Also capture RMSProp state, so training resumes exactly
+     */
+    ParameterSnapshots(const MLP<T> &mlp, size_t depth, bool with_optimizer = false)
+        : num_params_(mlp.GetNumParameters()),
+          slot_size_(num_params_ * (with_optimizer ? 2 : 1)),
+          num_slots_(depth + 1),
+          depth_(depth),
+          with_optimizer_(with_optimizer),
+          storage_(slot_size_ * num_slots_) {}
+
+    /**
+     * @brief Saves the network state as a new undo step and discards the redo history.
+     *
+     * Call before a destructive edit such as randomising or perturbing weights.
+     *
+     * @return false if the network does not match the snapshot size or depth is 0
+     */
+    bool Capture(const MLP<T> &mlp) {
+        if (depth_ == 0 || !Store(mlp, undo_count_)) {
+            return false;
+        }
+        redo_count_ = 0;
+        if (undo_count_ == depth_) {
+            base_ = (base_ + 1) % num_slots_;
+        } else {
+            undo_count_++;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Restores the most recent undo step; the replaced state becomes redoable.
+     * @return false if there is nothing to undo
+     */
+    bool Undo(MLP<T> &mlp) {
+        if (undo_count_ == 0 || !Store(mlp, undo_count_)) {
+            return false;
+        }
+        undo_count_--;
+        redo_count_++;
+        Restore(mlp, undo_count_);
+        return true;
+    }
+
+    /**
+     * @brief Reapplies the most recently undone state.
+     * @return false if there is nothing to redo
+     */
+    bool Redo(MLP<T> &mlp) {
+        if (redo_count_ == 0 || !Store(mlp, undo_count_)) {
+            return false;
+        }
+        undo_count_++;
+        redo_count_--;
+        Restore(mlp, undo_count_);
+        return true;
+    }
+
+    /**
+     * @brief Forgets all history.
+     */
+    void Clear() {
+        base_ = 0;
+        undo_count_ = 0;
+        redo_count_ = 0;
+    }
+
+    size_t GetUndoDepth() const { return undo_count_; }
+    size_t GetRedoDepth() const { return redo_count_; }
+
+ private:
+    std::span<T> Slot(size_t position) {
+        return std::span<T>(storage_.data() + ((base_ + position) % num_slots_) * slot_size_,
+                            slot_size_);
+    }
+
+    bool Store(const MLP<T> &mlp, size_t position) {
+        std::span<T> slot = Slot(position);
+        if (!mlp.GetParameters(slot.first(num_params_))) {
+            return false;
+        }
+        if (with_optimizer_) {
+            mlp.GetOptimizerState(slot.last(num_params_));
+        }
+        return true;
+    }
+
+    void Restore(MLP<T> &mlp, size_t position) {
+        std::span<T> slot = Slot(position);
+        mlp.SetParameters(slot.first(num_params_));
+        if (with_optimizer_) {
+            mlp.SetOptimizerState(slot.last(num_params_));
+        }
+    }
+
+    const size_t num_params_;
+    const size_t slot_size_;
+    const size_t num_slots_;
+    const size_t depth_;
+    const bool with_optimizer_;
+    std::vector<T> storage_;
+
+    size_t base_ = 0;        /**< Ring position of the oldest undo step */
+    size_t undo_count_ = 0;
+    size_t redo_count_ = 0;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_SNAPSHOT_HPP
@@ -0,0 +1,123 @@
+/**
+ * @file spsc_ring.hpp
+ * @brief Wait-free single-producer single-consumer ring buffer
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_SPSC_RING_HPP
+#define NISPS_SPSC_RING_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace nisps {
+
+/**
+ * @class SpscRing
+ * @brief Fixed-capacity ring buffer for one producer thread and one consumer thread.
+ *
+ * Storage is allocated once at construction; push and pop never allocate,
+ * lock or block, so the producer can run on a real-time thread.
+ *
+ * @tparam T Trivially copyable element type
+ */
+template<typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing requires a trivially copyable type");
+
+ public:
+    /**
+     * @brief Constructs a ring holding at least min_capacity elements.
+     * @param min_capacity Requested capacity, rounded up to a power of two
+     */
+    explicit SpscRing(size_t min_capacity)
+        : capacity_(std::bit_ceil(min_capacity < 2 ? size_t(2) : min_capacity)),
+          mask_(capacity_ - 1),
+          buffer_(std::make_unique<T[]>(capacity_)) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Producer: appends one element.
+     * @return false if the ring is full
+     */
+    bool TryPush(const T &value) {
+        return TryPush(&value, 1);
+    }
+
+    /**
+     * @brief Producer: appends n elements, all or nothing.
+     * @return false if there is not room for all of them
+     */
+    bool TryPush(const T *values, size_t n) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        if (capacity_ - (head - tail) < n) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            buffer_[(head + i) & mask_] = values[i];
+        }
+        head_.store(head + n, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer: removes one element.
+     * @return false if the ring is empty
+     */
+    bool TryPop(T &value) {
+        return TryPop(&value, 1) == 1;
+    }
+
+    /**
+     * @brief Consumer: removes up to max_n elements.
+     * @return Number of elements removed
+     */
+    size_t TryPop(T *values, size_t max_n) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        size_t n = head - tail;
+        if (n > max_n) {
+            n = max_n;
+        }
+        for (size_t i = 0; i < n; i++) {
+            values[i] = buffer_[(tail + i) & mask_];
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Number of elements currently queued (approximate while threads run).
+     */
+    size_t Size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Maximum number of queued elements.
+     */
+    size_t Capacity() const { return capacity_; }
+
+ private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_SPSC_RING_HPP
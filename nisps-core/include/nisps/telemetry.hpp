@@ -0,0 +1,44 @@
+/**
+ * @file telemetry.hpp
+ * @brief Fixed-size training progress records passed through a wait-free ring
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef NISPS_TELEMETRY_HPP
+#define NISPS_TELEMETRY_HPP
+
+#include "spsc_ring.hpp"
+
+#include <cstdint>
+
+namespace nisps {
+
+/**
+ * @brief Progress of one training iteration (epoch).
+ */
+struct TrainingTelemetry {
+    uint32_t iteration = 0;
+    float loss = 0;
+    float grad_norm = 0;        /**< Largest pre-clip batch gradient norm; 0 for Train(), which does not compute it */
+    uint32_t clip_events = 0;   /**< Batches whose gradient was clipped */
+    float elapsed_s = 0;        /**< Since the start of the training call */
+    float learning_rate = 0;
+    uint32_t dropped = 0;       /**< Records lost to a full ring since the previous delivered one */
+    bool last = false;          /**< Last record of the training call */
+};
+
+/**
+ * @brief Ring a network writes telemetry into; drain it from another thread or core.
+ *
+ * The trainer never waits: when the ring is full the record is dropped
+ * and counted in the next one that fits.
+ */
+using TelemetryRing = SpscRing<TrainingTelemetry>;
+
+}  // namespace nisps
+
+#endif  // NISPS_TELEMETRY_HPP
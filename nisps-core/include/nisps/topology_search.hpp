@@ -0,0 +1,316 @@
+/**
+ * @file topology_search.hpp
+ * @brief Parallel search over network topologies and training settings
+ * @copyright Copyright (c) 2024. Licensed under Mozilla Public License Version 2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Each candidate (hidden sizes, hidden activation, learning rate and
+ * training method) is trained with k-fold cross-validation on worker
+ * threads. Its inference cost is then measured on the calling thread, one
+ * candidate at a time, so the timings are not disturbed by training. The
+ * Pareto front of validation loss against inference cost shows which
+ * models are worth considering; SelectSmallest() picks the cheapest one
+ * that meets a loss target.
+ */
+
+#ifndef NISPS_TOPOLOGY_SEARCH_HPP
+#define NISPS_TOPOLOGY_SEARCH_HPP
+
+#include "mlp.hpp"
+#include "dataset.hpp"
+#include "random.hpp"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+
+namespace nisps {
+
+/**
+ * @brief One configuration to try.
+ */
+struct SearchCandidate {
+    std::vector<size_t> hidden;                     /**< Hidden layer sizes; may be empty */
+    ACTIVATION_FUNCTIONS hidden_activation = RELU;
+    float learning_rate = 0.01f;
+    size_t batch_size = 0;                          /**< 0: per-example SGD with Train(); else TrainBatch() with RMSProp */
+};
+
+/**
+ * @brief Outcome of one candidate.
+ */
+template<typename T>
+struct SearchResult {
+    SearchCandidate candidate;
+    size_t parameters = 0;
+    T validation_loss = 0;         /**< Mean squared error on the held-out folds */
+    double inference_ns = 0;       /**< Measured time of one GetOutput() call */
+    bool pareto = false;           /**< No other candidate is both cheaper and at least as accurate */
+};
+
+/**
+ * @class TopologySearch
+ * @brief Trains many candidate networks concurrently and ranks them by loss and cost.
+ *
+ * The dataset is copied (with the bias input appended) and split into
+ * folds once, so every candidate sees the same folds.
+ *
+ * @tparam T Scalar type of the networks
+ */
+template<typename T>
+class TopologySearch {
+ public:
+    struct Config {
+        size_t folds = 4;                           /**< k; capped at the number of examples */
+        int epochs = 300;
+        ACTIVATION_FUNCTIONS output_activation = SIGMOID;
+        loss::LOSS_FUNCTIONS loss = loss::LOSS_FUNCTIONS::LOSS_MSE;
+        size_t num_threads = 0;                     /**< Training threads; 0 uses the hardware concurrency */
+        size_t timing_repeats = 200;                /**< GetOutput() calls timed per candidate */
+        uint64_t seed = Random::kDefaultSeed;
+    };
+
+    /**
+     * @param dataset Examples to train and validate on
+     * @param config Search settings
+     */
+    TopologySearch(Dataset &dataset, const Config &config) : config_(config) {
+        const auto features = dataset.GetFeatures(true);
+        const auto &labels = dataset.GetLabels();
+        const size_t n = std::min(features.size(), labels.size());
+        inputs_.resize(n);
+        targets_.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            inputs_[i].assign(features[i].begin(), features[i].end());
+            targets_[i].assign(labels[i].begin(), labels[i].end());
+        }
+        fold_of_.resize(n);
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        Random rng(config_.seed);
+        for (size_t i = n; i > 1; i--) {
+            std::swap(order[i - 1], order[rng.Below(static_cast<uint32_t>(i))]);
+        }
+        num_folds_ = std::max<size_t>(1, std::min(config_.folds, n));
+        for (size_t i = 0; i < n; i++) {
+            fold_of_[order[i]] = i % num_folds_;
+        }
+    }
+
+    /**
+     * @brief Every combination of the given options.
+     */
+    static std::vector<SearchCandidate> Grid(const std::vector<std::vector<size_t>> &hidden,
+                                             const std::vector<ACTIVATION_FUNCTIONS> &activations,
+                                             const std::vector<float> &learning_rates,
+                                             const std::vector<size_t> &batch_sizes) {
+        std::vector<SearchCandidate> grid;
+        for (const auto &h : hidden) {
+            for (auto a : activations) {
+                for (float lr : learning_rates) {
+                    for (size_t b : batch_sizes) {
+                        grid.push_back({h, a, lr, b});
+                    }
+                }
+            }
+        }
+        return grid;
+    }
+
+    /**
+     * @brief Trains and times every candidate, then marks the Pareto front.
+     * @param candidates Configurations to try
+     * @return One result per candidate, in the same order
+     */
+    const std::vector<SearchResult<T>> &Run(const std::vector<SearchCandidate> &candidates) {
+        results_.assign(candidates.size(), {});
+        models_.clear();
+        models_.resize(candidates.size());
+        if (inputs_.empty()) {
+            return results_;
+        }
+        std::vector<T> fold_loss(candidates.size() * num_folds_, 0);
+
+        std::atomic<size_t> next{0};
+        const size_t jobs = candidates.size() * num_folds_;
+        auto work = [&]() {
+            typename MLP<T>::training_pair_t train;
+            std::vector<T> y;
+            for (size_t job = next.fetch_add(1); job < jobs; job = next.fetch_add(1)) {
+                const size_t c = job / num_folds_, fold = job % num_folds_;
+                train.first.clear();
+                train.second.clear();
+                for (size_t i = 0; i < inputs_.size(); i++) {
+                    if (num_folds_ == 1 || fold_of_[i] != fold) {
+                        train.first.push_back(inputs_[i]);
+                        train.second.push_back(targets_[i]);
+                    }
+                }
+                auto mlp = Build(candidates[c], config_.seed + job);
+                Fit(*mlp, candidates[c], train);
+                // With a single fold there is nothing held out, so validate on the training set
+                T sum = 0;
+                size_t count = 0;
+                for (size_t i = 0; i < inputs_.size(); i++) {
+                    if (num_folds_ == 1 || fold_of_[i] == fold) {
+                        mlp->GetOutput(inputs_[i], &y);
+                        for (size_t k = 0; k < y.size(); k++) {
+                            const T e = y[k] - targets_[i][k];
+                            sum += e * e;
+                            count++;
+                        }
+                    }
+                }
+                fold_loss[job] = count ? sum / static_cast<T>(count) : 0;
+                if (fold + 1 == num_folds_) {
+                    models_[c] = std::move(mlp);
+                }
+            }
+        };
+        size_t threads = config_.num_threads ? config_.num_threads
+                                             : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, jobs);
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; t++) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (auto &t : pool) {
+            t.join();
+        }
+
+        for (size_t c = 0; c < candidates.size(); c++) {
+            SearchResult<T> &r = results_[c];
+            r.candidate = candidates[c];
+            r.parameters = models_[c]->GetNumParameters();
+            r.validation_loss = std::accumulate(fold_loss.begin() + c * num_folds_,
+                                                fold_loss.begin() + (c + 1) * num_folds_, static_cast<T>(0)) /
+                                static_cast<T>(num_folds_);
+            r.inference_ns = TimeInference(*models_[c]);
+        }
+        MarkPareto();
+        return results_;
+    }
+
+    /**
+     * @brief Results of the last Run().
+     */
+    const std::vector<SearchResult<T>> &GetResults() const { return results_; }
+
+    /**
+     * @brief Indices of the Pareto-optimal results, cheapest first.
+     */
+    std::vector<size_t> GetParetoFront() const {
+        std::vector<size_t> front;
+        for (size_t i = 0; i < results_.size(); i++) {
+            if (results_[i].pareto) {
+                front.push_back(i);
+            }
+        }
+        std::sort(front.begin(), front.end(),
+                  [&](size_t a, size_t b) { return results_[a].inference_ns < results_[b].inference_ns; });
+        return front;
+    }
+
+    /**
+     * @brief The cheapest result whose validation loss meets a target.
+     *
+     * Cost is the parameter count, which tracks the measured time but is
+     * not subject to timer noise; ties go to the lower loss.
+     *
+     * @param target_loss Largest acceptable validation loss
+     * @return Index into GetResults(), or -1 if no candidate meets the target
+     */
+    ptrdiff_t SelectSmallest(T target_loss) const {
+        ptrdiff_t best = -1;
+        for (size_t i = 0; i < results_.size(); i++) {
+            const auto &r = results_[i];
+            if (!(r.validation_loss <= target_loss)) {
+                continue;
+            }
+            if (best < 0 || r.parameters < results_[best].parameters ||
+                (r.parameters == results_[best].parameters &&
+                 r.validation_loss < results_[best].validation_loss)) {
+                best = static_cast<ptrdiff_t>(i);
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Trains a candidate on the whole dataset, ready to deploy.
+     */
+    std::unique_ptr<MLP<T>> TrainFinal(const SearchCandidate &candidate) {
+        auto mlp = Build(candidate, config_.seed);
+        Fit(*mlp, candidate, typename MLP<T>::training_pair_t(inputs_, targets_));
+        return mlp;
+    }
+
+ private:
+    std::unique_ptr<MLP<T>> Build(const SearchCandidate &c, uint64_t seed) const {
+        std::vector<size_t> nodes{inputs_.front().size()};
+        nodes.insert(nodes.end(), c.hidden.begin(), c.hidden.end());
+        nodes.push_back(targets_.front().size());
+        std::vector<ACTIVATION_FUNCTIONS> activations(c.hidden.size(), c.hidden_activation);
+        activations.push_back(config_.output_activation);
+        auto mlp = std::make_unique<MLP<T>>(nodes, activations, config_.loss);
+        mlp->SetSeed(seed);
+        mlp->InitXavier();
+        return mlp;
+    }
+
+    void Fit(MLP<T> &mlp, const SearchCandidate &c, const typename MLP<T>::training_pair_t &data) const {
+        if (c.batch_size) {
+            mlp.TrainBatch(data, c.learning_rate, config_.epochs, c.batch_size, 0, false);
+        } else {
+            mlp.Train(data, c.learning_rate, config_.epochs, 0, false);
+        }
+    }
+
+    double TimeInference(MLP<T> &mlp) {
+        using clock = std::chrono::steady_clock;
+        std::vector<T> y;
+        const size_t n = std::max<size_t>(config_.timing_repeats, 1);
+        mlp.GetOutput(inputs_[0], &y);  // Warm up
+        const auto start = clock::now();
+        for (size_t i = 0; i < n; i++) {
+            mlp.GetOutput(inputs_[i % inputs_.size()], &y);
+        }
+        const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        return elapsed.count() / static_cast<double>(n);
+    }
+
+    void MarkPareto() {
+        for (auto &r : results_) {
+            r.pareto = true;
+            for (const auto &o : results_) {
+                const bool no_worse = o.inference_ns <= r.inference_ns && o.validation_loss <= r.validation_loss;
+                const bool better = o.inference_ns < r.inference_ns || o.validation_loss < r.validation_loss;
+                if (no_worse && better) {
+                    r.pareto = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    const Config config_;
+    std::vector<std::vector<T>> inputs_;
+    std::vector<std::vector<T>> targets_;
+    std::vector<size_t> fold_of_;
+    size_t num_folds_ = 1;
+    std::vector<SearchResult<T>> results_;
+    std::vector<std::unique_ptr<MLP<T>>> models_;
+};
+
+}  // namespace nisps
+
+#endif  // NISPS_TOPOLOGY_SEARCH_HPP
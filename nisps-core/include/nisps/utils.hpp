@@ -20,6 +20,8 @@
 #include <utility>
 #include <algorithm>
 
+#include "random.hpp"
+
 namespace nisps {
 
 /**
@@ -316,21 +318,21 @@ private:
  */
 template<typename T>
 struct gen_rand {
-  T factor; /**< Scaling factor for random number generation. */
+  T factor; /**< Width of the range. */
   T offset; /**< Offset for random number generation. */
 
   /**
    * @brief Constructor for gen_rand.
    * @param r The range of the random numbers.
    */
-  gen_rand(T r = 2.0) : factor(r / static_cast<T>(RAND_MAX)), offset(r * 0.5) {}
+  gen_rand(T r = 2.0) : factor(r), offset(r * 0.5) {}
 
   /**
-   * @brief Generates a random number.
-   * @return A random number in the range [-offset, offset].
+   * @brief Generates a random number from the calling thread's generator.
+   * @return A random number in the range [-offset, offset).
    */
   T operator()() {
-    return static_cast<T>(rand()) * factor - offset;
+    return ThreadRandom().Uniform<T>() * factor - offset;
   }
 };
 
@@ -390,7 +392,6 @@ template<typename T>
 MLP_ACTIVATION_FN
 inline void Softmax(std::vector<T> *output) {
   size_t num_elements = output->size();
-  std::vector<T> exp_output(num_elements);
   T exp_total = 0;
   for (size_t i = 0; i < num_elements; i++) {
     float output_i = (*output)[i];
@@ -399,11 +400,11 @@ inline void Softmax(std::vector<T> *output) {
     } else if (output_i < -15.f) {
       output_i = -15.f;
     }
-    exp_output[i] = std::exp((*output)[i]);
-    exp_total += exp_output[i];
+    (*output)[i] = std::exp((*output)[i]);
+    exp_total += (*output)[i];
   }
   for (size_t i = 0; i < num_elements; i++) {
-    (*output)[i] = exp_output[i] / exp_total;
+    (*output)[i] /= exp_total;
   }
 }
 
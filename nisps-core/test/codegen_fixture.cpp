@@ -0,0 +1,33 @@
+// Writes the models nisps_codegen_test exports and checks against.
+// Usage: nisps_codegen_fixture regression.nmdl classifier.nmdl
+
+#include <nisps/nisps.hpp>
+#include <iostream>
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: nisps_codegen_fixture regression.nmdl classifier.nmdl\n";
+        return 2;
+    }
+    nisps::MLP<float> regression({4, 12, 10, 8, 3},
+                                 {nisps::TANH, nisps::RELU, nisps::HARDSWISH, nisps::SIGMOID});
+    regression.SetSeed(11);
+    regression.InitXavier();
+    nisps::MLP<float> classifier({3, 8, 8, 4}, {nisps::HARDSIGMOID, nisps::HARDTANH, nisps::LINEAR},
+                                 nisps::loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY);
+    classifier.SetSeed(12);
+    classifier.InitXavier();
+    // Non-zero biases, so they are exercised too
+    for (auto *mlp : {&regression, &classifier}) {
+        for (auto &layer : mlp->m_layers) {
+            for (auto &node : layer.m_nodes) {
+                node.m_bias = mlp->GetRandom().Uniform(-0.5f, 0.5f);
+            }
+        }
+    }
+    if (!regression.SaveModel(argv[1]) || !classifier.SaveModel(argv[2])) {
+        std::cerr << "Could not write the models\n";
+        return 1;
+    }
+    return 0;
+}
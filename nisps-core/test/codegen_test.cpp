@@ -0,0 +1,53 @@
+// Compiles headers generated by nisps-export and checks them against the
+// networks they were exported from.
+
+#include <nisps/nisps.hpp>
+#include "regression_model.hpp"
+#include "regression_model_fast.hpp"
+#include "classifier_model.hpp"
+#include <iostream>
+#include <cmath>
+
+namespace {
+
+template<typename Generated>
+bool Check(const char *what, const char *model, float tolerance) {
+    nisps::MLP<float> mlp{std::string(model)};
+    static_assert(Generated::kNumInputs > 0 && Generated::kNumOutputs > 0);
+    if (mlp.get_num_inputs() != static_cast<int>(Generated::kNumInputs) ||
+        mlp.get_num_outputs() != static_cast<int>(Generated::kNumOutputs) ||
+        mlp.GetNumParameters() != Generated::kNumParameters) {
+        std::cerr << "FAIL: " << what << ": topology differs\n";
+        return false;
+    }
+    nisps::Random rng(7);
+    std::vector<float> x(Generated::kNumInputs), expected;
+    float y[Generated::kNumOutputs];
+    float worst = 0;
+    for (int i = 0; i < 500; i++) {
+        rng.FillUniform(std::span<float>(x), -2.0f, 2.0f);
+        mlp.GetOutput(x, &expected);
+        Generated::Process(x.data(), y);
+        for (size_t k = 0; k < Generated::kNumOutputs; k++) {
+            worst = std::max(worst, std::abs(y[k] - expected[k]));
+        }
+    }
+    std::cout << "  " << what << ": max error " << worst << "\n";
+    if (!(worst <= tolerance)) {
+        std::cerr << "FAIL: " << what << " differs from the network\n";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "\n=== NISPS Generated Models ===\n\n";
+    bool ok = true;
+    ok &= Check<generated::Regression>("Exact activations", NISPS_REGRESSION_MODEL, 1e-5f);
+    ok &= Check<generated::RegressionFast>("Fast activations", NISPS_REGRESSION_MODEL, 0.03f);
+    ok &= Check<generated::Classifier>("Softmax classifier", NISPS_CLASSIFIER_MODEL, 1e-5f);
+    std::cout << "\n=== Results: " << (ok ? "PASS" : "FAIL") << " ===\n\n";
+    return ok ? 0 : 1;
+}
@@ -1,7 +1,28 @@
 #include <nisps/nisps.hpp>
+#include <nisps/dataset_file.hpp>
+#include <nisps/morph.hpp>
+#include <nisps/es_trainer.hpp>
+#include <nisps/incremental.hpp>
+#include <nisps/extrapolator.hpp>
+#include <nisps/pruning.hpp>
+#include <nisps/distill.hpp>
+#include <nisps/topology_search.hpp>
+#include <nisps/fourier_features.hpp>
+#include <nisps/gru.hpp>
+#include <nisps/gesture.hpp>
 #include <iostream>
 #include <cmath>
 #include <cassert>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <memory_resource>
+#include <numbers>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/resource.h>
+#endif
 
 void log_callback(const char* msg) {
     std::cout << "  [nisps] " << msg << "\n";
@@ -114,6 +135,7 @@ bool test_training_convergence() {
     // Train a network to learn: input -> same output
     // This is simpler than XOR and should converge reliably
     nisps::IML<float> iml(1, 1, {8, 8}, 3000, 1.0f, 0.00001f);
+    iml.set_seed(1);
     iml.set_logger(log_callback);
     iml.set_mode(nisps::IML<float>::Mode::Training);
 
@@ -217,6 +239,1470 @@ bool test_multi_output_training() {
     return true;
 }
 
+bool test_dataset_file_roundtrip() {
+    std::cout << "--- Test: Binary dataset file and mini-batch loader ---\n";
+
+    const char* path = "nisps_test_dataset.bin";
+    std::remove(path);
+
+    // Record 5 rows, then reopen and append 6 more
+    {
+        nisps::DatasetFileWriter writer;
+        if (!writer.Open(path, 2, 1)) {
+            std::cerr << "FAIL: Could not create dataset file\n";
+            return false;
+        }
+        for (int i = 0; i < 5; i++) {
+            float f[] = {static_cast<float>(i), static_cast<float>(i) * 0.5f};
+            float l[] = {static_cast<float>(i) * 2.0f};
+            writer.Append(f, l);
+        }
+    }
+    {
+        nisps::DatasetFileWriter writer;
+        if (!writer.Open(path, 2, 1) || writer.GetNumRows() != 5) {
+            std::cerr << "FAIL: Could not reopen dataset file for appending\n";
+            return false;
+        }
+        if (writer.Open(path, 3, 1)) {
+            std::cerr << "FAIL: Reopened dataset file with mismatched dimensions\n";
+            return false;
+        }
+        writer.Open(path, 2, 1);
+        for (int i = 5; i < 11; i++) {
+            float f[] = {static_cast<float>(i), static_cast<float>(i) * 0.5f};
+            float l[] = {static_cast<float>(i) * 2.0f};
+            writer.Append(f, l);
+        }
+    }
+
+    nisps::DatasetFile file;
+    if (!file.Open(path) || file.GetNumRows() != 11 ||
+        file.GetFeatureSize() != 2 || file.GetOutputSize() != 1) {
+        std::cerr << "FAIL: Dataset file header or row count wrong\n";
+        return false;
+    }
+    if (file.Feature(7)[1] != 3.5f || file.Label(7)[0] != 14.0f) {
+        std::cerr << "FAIL: Row contents not preserved\n";
+        return false;
+    }
+
+    // Two epochs: every row must be visited exactly once per epoch
+    nisps::MiniBatchLoader loader(file, 3, 4, 2, 1234);
+    nisps::MiniBatchLoader::Batch batch;
+    for (int epoch = 0; epoch < 2; epoch++) {
+        std::vector<int> seen(11, 0);
+        size_t n_batches = 0;
+        while (loader.Next(batch)) {
+            n_batches++;
+            for (size_t r = 0; r < batch.num_rows; r++) {
+                int row = static_cast<int>(batch.Feature(r)[0]);
+                if (batch.Label(r)[0] != row * 2.0f) {
+                    std::cerr << "FAIL: Batch row features and labels out of step\n";
+                    return false;
+                }
+                seen[row]++;
+            }
+        }
+        if (n_batches != loader.GetBatchesPerEpoch() ||
+            std::count(seen.begin(), seen.end(), 1) != 11) {
+            std::cerr << "FAIL: Epoch " << epoch << " did not visit every row once\n";
+            return false;
+        }
+    }
+
+    // Loaded rows feed the in-memory Dataset as well
+    nisps::Dataset dataset;
+    if (!nisps::LoadDatasetFile(path, dataset) || dataset.GetLabels().size() != 11) {
+        std::cerr << "FAIL: LoadDatasetFile did not load all rows\n";
+        return false;
+    }
+
+    file.Close();
+    std::remove(path);
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_model_file_roundtrip() {
+    std::cout << "--- Test: Versioned model file ---\n";
+
+    const char* path = "nisps_test_model.nspm";
+    nisps::MLP<float> mlp({3, 6, 5, 2},
+                          {nisps::RELU, nisps::TANH, nisps::SIGMOID});
+    if (!mlp.SaveModel(path)) {
+        std::cerr << "FAIL: SaveModel failed\n";
+        return false;
+    }
+
+    // Load into a network of a different topology, then into a matching one
+    nisps::MLP<float> other({2, 4, 1}, {nisps::RELU, nisps::LINEAR},
+                            nisps::loss::LOSS_CATEGORICAL_CROSSENTROPY);
+    if (!other.LoadModel(path) || other.GetNumParameters() != mlp.GetNumParameters() ||
+        other.GetLossFunctionType() != nisps::loss::LOSS_MSE) {
+        std::cerr << "FAIL: LoadModel did not rebuild the saved topology\n";
+        return false;
+    }
+    if (!other.LoadModel(path)) {
+        std::cerr << "FAIL: LoadModel into matching topology failed\n";
+        return false;
+    }
+
+    std::vector<float> in = {0.2f, 0.7f, 1.0f};
+    std::vector<float> a, b;
+    mlp.GetOutput(in, &a);
+    other.GetOutput(in, &b);
+    if (a.size() != 2 || a != b) {
+        std::cerr << "FAIL: Loaded model outputs differ from the saved model\n";
+        return false;
+    }
+
+    // A flipped byte must be rejected by the checksum
+    FILE* f = fopen(path, "r+b");
+    fseek(f, 100, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, 100, SEEK_SET);
+    fputc(c ^ 0x40, f);
+    fclose(f);
+    if (other.LoadModel(path)) {
+        std::cerr << "FAIL: Corrupted model file was accepted\n";
+        return false;
+    }
+
+    std::remove(path);
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_in_memory_serialisation() {
+    std::cout << "--- Test: In-memory serialisation and partial updates ---\n";
+
+    nisps::MLP<float> trained({3, 5, 2}, {nisps::RELU, nisps::SIGMOID});
+    nisps::MLP<float>::training_pair_t data(
+        {{0.1f, 0.2f, 1.0f}, {0.8f, 0.9f, 1.0f}},
+        {{0.2f, 0.8f}, {0.9f, 0.1f}});
+    trained.TrainBatch(data, 0.05f, 20, 2, 0.0f, false);
+
+    const uint32_t all = nisps::ModelFormat::kSectionAll;
+    std::vector<uint8_t> buffer(trained.SerialisedSize(all));
+    if (trained.Serialise(std::span<uint8_t>(buffer.data(), buffer.size() - 1), all) != 0) {
+        std::cerr << "FAIL: Serialise accepted an undersized buffer\n";
+        return false;
+    }
+    if (trained.Serialise(buffer, all) != buffer.size()) {
+        std::cerr << "FAIL: Serialise did not fill the advertised size\n";
+        return false;
+    }
+
+    // Optimizer state only: weights must stay as they were
+    nisps::MLP<float> target({3, 5, 2}, {nisps::RELU, nisps::SIGMOID});
+    std::vector<float> in = {0.3f, 0.6f, 1.0f};
+    std::vector<float> before, after, expected;
+    target.GetOutput(in, &before);
+    if (!target.FromSerialised(buffer, nisps::ModelFormat::kSectionOptimizer)) {
+        std::cerr << "FAIL: Optimizer-only update rejected\n";
+        return false;
+    }
+    target.GetOutput(in, &after);
+    if (before != after ||
+        target.m_layers[0].m_nodes[0].squared_gradient_avg !=
+            trained.m_layers[0].m_nodes[0].squared_gradient_avg) {
+        std::cerr << "FAIL: Optimizer-only update touched weights or missed state\n";
+        return false;
+    }
+
+    // Weights only
+    target.FromSerialised(buffer, nisps::ModelFormat::kSectionWeights);
+    target.GetOutput(in, &after);
+    trained.GetOutput(in, &expected);
+    if (after != expected) {
+        std::cerr << "FAIL: Weights-only update did not reproduce the model\n";
+        return false;
+    }
+
+    // Partial updates never reshape the network
+    nisps::MLP<float> wrong_shape({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    if (wrong_shape.FromSerialised(buffer)) {
+        std::cerr << "FAIL: Partial update applied to a different topology\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_session_journal() {
+    std::cout << "--- Test: Session journal and crash recovery ---\n";
+
+    const char* path = "test_session.nsjl";
+    std::remove(path);
+
+    std::vector<float> probe = {0.3f, 0.7f};
+    std::vector<float> expected;
+    size_t expected_examples = 0;
+    {
+        nisps::SessionJournal journal(4096, 5);
+        if (!journal.Open(path)) {
+            std::cerr << "FAIL: Could not create journal\n";
+            return false;
+        }
+        nisps::IML<float> iml(2, 1, {6}, 200);
+        iml.set_journal(&journal);
+        iml.set_mode(nisps::IML<float>::Mode::Training);
+        for (int i = 0; i < 6; ++i) {
+            float in[2] = {i / 5.0f, 1.0f - i / 5.0f};
+            float out[1] = {i / 5.0f};
+            iml.add_example(in, 2, out, 1);
+        }
+        iml.set_mode(nisps::IML<float>::Mode::Inference);  // trains and checkpoints
+
+        // Recorded after the checkpoint, replayed on top of it
+        float in[2] = {0.5f, 0.5f};
+        float out[1] = {0.25f};
+        iml.add_example(in, 2, out, 1);
+        expected_examples = 7;
+
+        iml.set_inputs(probe.data(), probe.size());
+        iml.process();
+        expected.assign(iml.get_outputs(), iml.get_outputs() + 1);
+        journal.Close();
+        if (journal.GetDroppedRecords() != 0) {
+            std::cerr << "FAIL: Records dropped\n";
+            return false;
+        }
+    }
+
+    // Simulate a torn write at the end of the file
+    FILE* f = fopen(path, "ab");
+    const uint8_t torn[5] = {1, 0, 0, 0, 200};
+    fwrite(torn, sizeof(torn), 1, f);
+    fclose(f);
+
+    // Reopening truncates the torn record; recovery then checkpoints into it
+    nisps::SessionJournal journal;
+    if (!journal.Open(path)) {
+        std::cerr << "FAIL: Could not reopen journal with a torn tail\n";
+        return false;
+    }
+    nisps::IML<float> recovered(2, 1, {6}, 200);
+    recovered.set_journal(&journal);
+    if (!recovered.recover(path)) {
+        std::cerr << "FAIL: Recovery failed\n";
+        return false;
+    }
+    recovered.set_inputs(probe.data(), probe.size());
+    recovered.process();
+    if (recovered.get_mode() != nisps::IML<float>::Mode::Inference ||
+        std::abs(recovered.get_outputs()[0] - expected[0]) > 1e-6f) {
+        std::cerr << "FAIL: Recovered model differs from the original\n";
+        return false;
+    }
+
+    recovered.set_mode(nisps::IML<float>::Mode::Training);
+    recovered.clear_dataset();
+    journal.Close();
+
+    size_t examples = 0;
+    bool cleared = false;
+    nisps::SessionJournal::Replay(path, [&](const nisps::SessionJournal::Record& r) {
+        if (r.type == nisps::SessionJournal::kCheckpoint) {
+            nisps::Dataset dataset;
+            uint32_t mode;
+            std::span<const uint8_t> model;
+            nisps::SessionJournal::DecodeCheckpoint(r.payload, mode, model, dataset);
+            examples = dataset.GetFeatures().size();
+        }
+        cleared = cleared || r.type == nisps::SessionJournal::kClearDataset;
+        return true;
+    });
+    std::remove(path);
+    if (examples != expected_examples || !cleared) {
+        std::cerr << "FAIL: Recovery checkpoint or appended records missing\n";
+        return false;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A checkpoint that does not fit under the file size limit fails to
+    // write; the journal must say so rather than carry on
+    rlimit old_limit;
+    getrlimit(RLIMIT_FSIZE, &old_limit);
+    rlimit limit = old_limit;
+    limit.rlim_cur = 4096;
+    auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+    bool reported = false;
+    {
+        nisps::SessionJournal full;
+        nisps::Dataset dataset;
+        const std::vector<uint8_t> model(16384);
+        reported = full.Open(path) && full.Checkpoint(0, model, dataset) && !full.Flush() &&
+                   full.HasWriteError() && !full.Checkpoint(0, model, dataset) && !full.LogModeChange(1);
+    }
+    setrlimit(RLIMIT_FSIZE, &old_limit);
+    std::signal(SIGXFSZ, old_handler);
+    std::remove(path);
+    if (!reported) {
+        std::cerr << "FAIL: Failed journal write was not reported\n";
+        return false;
+    }
+#endif
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_parameter_snapshots() {
+    std::cout << "--- Test: Flat parameter snapshots with undo/redo ---\n";
+
+    nisps::MLP<float> mlp({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    std::vector<float> params(mlp.GetNumParameters());
+    if (params.size() != 4 * 4 + 2 * 5 || !mlp.GetParameters(params) ||
+        mlp.GetParameters(std::span<float>(params.data(), params.size() - 1))) {
+        std::cerr << "FAIL: GetParameters size handling\n";
+        return false;
+    }
+    // Bias of the first node follows the four weight rows of layer 0
+    if (params[0] != mlp.m_layers[0].m_nodes[0].m_weights[0] ||
+        params[12] != mlp.m_layers[0].m_nodes[0].m_bias) {
+        std::cerr << "FAIL: Unexpected flat parameter layout\n";
+        return false;
+    }
+
+    // Three edits, history of two: the oldest state falls off
+    nisps::ParameterSnapshots<float> history(mlp, 2, true);
+    std::vector<std::vector<float>> states;
+    for (int i = 0; i < 3; ++i) {
+        states.push_back(params);
+        history.Capture(mlp);
+        for (float& p : params) p += 1.0f;
+        mlp.SetParameters(params);
+    }
+    std::vector<float> current(params.size());
+    bool ok = history.Undo(mlp) && mlp.GetParameters(current) && current == states[2];
+    ok = ok && history.Undo(mlp) && mlp.GetParameters(current) && current == states[1];
+    ok = ok && !history.Undo(mlp);
+    ok = ok && history.Redo(mlp) && history.Redo(mlp) &&
+         mlp.GetParameters(current) && current == params && !history.Redo(mlp);
+    if (!ok) {
+        std::cerr << "FAIL: Undo/redo sequence\n";
+        return false;
+    }
+
+    // IML restores the pre-randomisation weights through the same history
+    nisps::IML<float> iml(2, 1, {4});
+    iml.set_mode(nisps::IML<float>::Mode::Training);
+    iml.set_inputs(std::vector<float>{0.2f, 0.4f}.data(), 2);
+    iml.process();
+    const float original = iml.get_outputs()[0];
+    iml.randomise_weights();
+    if (!iml.undo() || std::abs(iml.get_outputs()[0] - original) > 1e-6f || !iml.redo()) {
+        std::cerr << "FAIL: IML undo/redo\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_weight_morphing() {
+    std::cout << "--- Test: Weight-space morphing across models ---\n";
+
+    nisps::MLP<float> a({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    nisps::MLP<float> b({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    nisps::MLP<float> target({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+
+    // Share the first layer so only the second one needs blending
+    std::vector<float> layer0(a.GetNumLayerParameters(0));
+    a.GetLayerParameters(0, layer0);
+    b.SetLayerParameters(0, layer0);
+
+    nisps::WeightMorpher<float> morpher(target, 3);
+    morpher.SetModel(0, a);
+    morpher.SetModel(1, b);
+    if (morpher.IsLayerBlended(0) || !morpher.IsLayerBlended(1)) {
+        std::cerr << "FAIL: Shared layer not detected\n";
+        return false;
+    }
+    if (morpher.Morph(std::vector<float>{0.0f, 0.0f, 1.0f})) {
+        std::cerr << "FAIL: Morph used an empty slot\n";
+        return false;
+    }
+
+    std::vector<float> pa(a.GetNumParameters()), pb(pa.size()), pt(pa.size());
+    a.GetParameters(pa);
+    b.GetParameters(pb);
+    morpher.Morph(std::vector<float>{2.0f, 2.0f, 0.0f});  // Normalised to 0.5 / 0.5
+    target.GetParameters(pt);
+    for (size_t i = 0; i < pt.size(); ++i) {
+        if (std::abs(pt[i] - 0.5f * (pa[i] + pb[i])) > 1e-6f) {
+            std::cerr << "FAIL: Blend mismatch at parameter " << i << "\n";
+            return false;
+        }
+    }
+    morpher.Morph(std::vector<float>{0.0f, 1.0f, 0.0f});
+    target.GetParameters(pt);
+    if (pt != pb) {
+        std::cerr << "FAIL: Corner weight did not reproduce the model\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_random_generator() {
+    std::cout << "--- Test: Seedable generator and Gaussian fills ---\n";
+
+    nisps::Random rng(42);
+    std::vector<float> noise(10001);
+    rng.FillNormal(std::span<float>(noise), 1.0f, 2.0f);
+    double mean = 0, var = 0;
+    for (float v : noise) mean += v;
+    mean /= noise.size();
+    for (float v : noise) var += (v - mean) * (v - mean);
+    var /= noise.size();
+    if (std::abs(mean - 1.0) > 0.1 || std::abs(std::sqrt(var) - 2.0) > 0.1) {
+        std::cerr << "FAIL: Normal fill statistics off (mean " << mean
+                  << ", stddev " << std::sqrt(var) << ")\n";
+        return false;
+    }
+
+    nisps::Random a(7), b = a.Stream(1);
+    if (a.Next() == b.Next()) {
+        std::cerr << "FAIL: Jumped stream matches the original\n";
+        return false;
+    }
+
+    // Same seed, same network and same exploration
+    nisps::MLP<float> m1({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    nisps::MLP<float> m2({3, 4, 2}, {nisps::RELU, nisps::SIGMOID});
+    std::vector<float> p1(m1.GetNumParameters()), p2(p1.size());
+    m1.SetParameters(p1);
+    m2.SetParameters(p2);
+    m1.SetSeed(99);
+    m2.SetSeed(99);
+    m1.MoveWeights(0.1f);
+    m2.MoveWeights(0.1f);
+    m1.GetParameters(p1);
+    m2.GetParameters(p2);
+    if (p1 != p2 || p1[0] == 0.0f) {
+        std::cerr << "FAIL: Seeded exploration is not reproducible\n";
+        return false;
+    }
+
+    // Reseeding an IML puts its network back as constructed: the IML keeps
+    // the network private, so read it back through a journal checkpoint
+    auto model_of = [](nisps::IML<float>& iml, nisps::MLP<float>& out) {
+        const char* path = "test_seed.nsjl";
+        std::remove(path);
+        bool ok;
+        {
+            nisps::SessionJournal journal;
+            ok = journal.Open(path);
+            iml.set_journal(&journal);
+            ok = ok && iml.checkpoint() && journal.Flush();
+            iml.set_journal(nullptr);
+        }
+        ok = ok && nisps::SessionJournal::Replay(path, [&](const nisps::SessionJournal::Record& r) {
+            nisps::Dataset dataset;
+            uint32_t mode;
+            std::span<const uint8_t> model;
+            return nisps::SessionJournal::DecodeCheckpoint(r.payload, mode, model, dataset) &&
+                   out.LoadModel(model);
+        });
+        std::remove(path);
+        return ok;
+    };
+    auto as_constructed = [](nisps::MLP<float>& mlp) {
+        for (const auto& layer : mlp.m_layers) {
+            for (const auto& node : layer.m_nodes) {
+                if (node.GetBias() != 0.0f || node.bias_squared_gradient_avg != 0.0f) {
+                    return false;
+                }
+                for (size_t w = 0; w < node.m_weights.size(); w++) {
+                    if (std::abs(node.m_weights[w]) > 1.0f || node.squared_gradient_avg[w] != 0.0f) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    };
+
+    const float x[2] = {0.2f, 0.5f}, y[1] = {0.9f};
+    nisps::IML<float> fresh(2, 1, {4}, 50), reseeded(2, 1, {4}, 50), seeded(2, 1, {4}, 50);
+    for (auto* iml : {&reseeded, &seeded}) {
+        iml->add_example(x, 2, y, 1);
+    }
+    reseeded.set_mode(nisps::IML<float>::Mode::Training);
+    reseeded.set_mode(nisps::IML<float>::Mode::Inference);
+    reseeded.set_mode(nisps::IML<float>::Mode::Training);
+    reseeded.randomise_weights();
+    reseeded.set_seed(3);
+    seeded.set_seed(3);
+
+    nisps::MLP<float> fresh_net({1, 1}, {nisps::LINEAR}), reseeded_net({1, 1}, {nisps::LINEAR});
+    if (!model_of(fresh, fresh_net) || !model_of(reseeded, reseeded_net) ||
+        fresh_net.GetNumParameters() != reseeded_net.GetNumParameters() ||
+        !as_constructed(fresh_net) || !as_constructed(reseeded_net)) {
+        std::cerr << "FAIL: IML::set_seed() network differs from a freshly constructed one\n";
+        return false;
+    }
+    // The constructor's draws: uniform in [-1, 1], layer by layer, node by node
+    nisps::Random draws(3);
+    for (const auto& layer : reseeded_net.m_layers) {
+        for (const auto& node : layer.m_nodes) {
+            std::vector<float> w(node.m_weights.size());
+            draws.FillUniform(std::span<float>(w), -1.0f, 1.0f);
+            if (!std::equal(w.begin(), w.end(), node.m_weights.begin())) {
+                std::cerr << "FAIL: IML::set_seed() did not draw weights as the constructor does\n";
+                return false;
+            }
+        }
+    }
+
+    // Training afterwards starts from the seeded weights, not the pre-randomise ones
+    reseeded.set_mode(nisps::IML<float>::Mode::Inference);
+    seeded.set_mode(nisps::IML<float>::Mode::Training);
+    seeded.set_mode(nisps::IML<float>::Mode::Inference);
+    for (float v : {0.1f, 0.6f}) {
+        reseeded.set_input(0, v);
+        seeded.set_input(0, v);
+        reseeded.process();
+        seeded.process();
+        if (reseeded.get_outputs()[0] != seeded.get_outputs()[0]) {
+            std::cerr << "FAIL: Training after IML::set_seed() restored older weights\n";
+            return false;
+        }
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_evolution_strategies() {
+    std::cout << "--- Test: Evolution-strategies trainer ---\n";
+
+    nisps::MLP<float> mlp({2, 6, 1}, {nisps::TANH, nisps::SIGMOID});
+    mlp.SetSeed(5);
+    mlp.InitXavier();
+
+    // Reward: negative squared error against a target mapping, as a
+    // simulated performer's feedback would score it
+    const std::vector<std::vector<float>> inputs = {
+        {0.0f, 1.0f}, {0.5f, 1.0f}, {1.0f, 1.0f}};
+    const std::vector<float> targets = {0.8f, 0.5f, 0.2f};
+    auto reward = [&](nisps::MLP<float>& net) {
+        std::vector<float> out;
+        float err = 0.0f;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            net.GetOutput(inputs[i], &out);
+            err += (out[0] - targets[i]) * (out[0] - targets[i]);
+        }
+        return -err;
+    };
+
+    nisps::EvolutionStrategies<float>::Config config;
+    config.population_pairs = 12;
+    config.sigma = 0.1f;
+    config.learning_rate = 0.1f;
+    config.num_threads = 3;
+    nisps::EvolutionStrategies<float> es(mlp, config);
+
+    const float before = reward(mlp);
+    es.Train(reward, 150);
+    const float after = reward(mlp);
+    std::cout << "  reward " << before << " -> " << after << "\n";
+    if (!(after > 0.5f * before)) {  // At least halve the error
+        std::cerr << "FAIL: ES did not improve the reward\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_online_adaptation() {
+    std::cout << "--- Test: Recursive-least-squares online adaptation ---\n";
+
+    nisps::IML<float> iml(2, 1, {8});
+    iml.set_online_adaptation(true);
+    iml.set_mode(nisps::IML<float>::Mode::Training);
+
+    const float in_a[2] = {0.2f, 0.8f}, out_a[1] = {0.9f};
+    const float in_b[2] = {0.9f, 0.1f}, out_b[1] = {0.1f};
+    iml.add_example(in_a, 2, out_a, 1);
+    iml.add_example(in_b, 2, out_b, 1);
+
+    // No train() call: both corrections are heard immediately
+    iml.set_inputs(in_a, 2);
+    iml.process();
+    const float ya = iml.get_outputs()[0];
+    iml.set_inputs(in_b, 2);
+    iml.process();
+    const float yb = iml.get_outputs()[0];
+    std::cout << "  outputs " << ya << ", " << yb << "\n";
+    if (std::abs(ya - out_a[0]) > 0.05f || std::abs(yb - out_b[0]) > 0.05f) {
+        std::cerr << "FAIL: Online update did not fit the examples\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_incremental_inference() {
+    std::cout << "--- Test: Incremental delta-propagation inference ---\n";
+
+    nisps::MLP<float> mlp({5, 16, 16, 2}, {nisps::TANH, nisps::TANH, nisps::SIGMOID});
+    mlp.SetSeed(3);
+    mlp.InitXavier();
+    nisps::IncrementalInference<float> inc(mlp, 0.0f, 64);
+
+    nisps::Random rng(11);
+    std::vector<float> x = {0.5f, 0.5f, 0.5f, 0.5f, 1.0f};
+    std::vector<float> expected;
+    const size_t full_work = 5 * 16 + 16 * 16 + 16 * 2;
+    size_t single_axis_work = 0;
+    for (int step = 0; step < 200; ++step) {
+        x[rng.Below(4)] = rng.Uniform<float>();  // One axis moves per tick
+        const std::vector<float>& out = inc.Process(x);
+        mlp.GetOutput(x, &expected);
+        for (size_t j = 0; j < out.size(); ++j) {
+            if (std::abs(out[j] - expected[j]) > 1e-4f) {
+                std::cerr << "FAIL: Drift at step " << step << ": " << out[j]
+                          << " vs " << expected[j] << "\n";
+                return false;
+            }
+        }
+        if (step == 1) single_axis_work = inc.GetLastWork();
+    }
+    if (single_axis_work == 0 || single_axis_work >= full_work) {
+        std::cerr << "FAIL: Single-axis update did full work (" << single_axis_work << ")\n";
+        return false;
+    }
+
+    // An unchanged input costs nothing
+    inc.Process(x);
+    if (inc.GetLastWork() != 0) {
+        std::cerr << "FAIL: Unchanged input was recomputed\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_jacobian_extrapolation() {
+    std::cout << "--- Test: Forward-mode Jacobian and output extrapolation ---\n";
+
+    nisps::MLP<float> mlp({3, 8, 2}, {nisps::TANH, nisps::SIGMOID});
+    mlp.SetSeed(8);
+    mlp.InitXavier();
+
+    std::vector<float> x = {0.4f, 0.6f, 1.0f};
+    std::vector<float> y, jac, plain;
+    mlp.GetOutputWithJacobian(x, &y, &jac);
+    mlp.GetOutput(x, &plain);
+    if (y != plain || jac.size() != 2 * 3) {
+        std::cerr << "FAIL: Outputs differ from GetOutput\n";
+        return false;
+    }
+
+    // Central differences
+    const float h = 1e-3f;
+    for (size_t i = 0; i < 2; ++i) {
+        std::vector<float> xp = x, xm = x, yp, ym;
+        xp[i] += h;
+        xm[i] -= h;
+        mlp.GetOutput(xp, &yp);
+        mlp.GetOutput(xm, &ym);
+        for (size_t k = 0; k < 2; ++k) {
+            const float numeric = (yp[k] - ym[k]) / (2 * h);
+            if (std::abs(numeric - jac[k * 3 + i]) > 1e-3f) {
+                std::cerr << "FAIL: d y" << k << " / d x" << i << " = " << jac[k * 3 + i]
+                          << ", numeric " << numeric << "\n";
+                return false;
+            }
+        }
+    }
+
+    // A small move between ticks is tracked to first order
+    nisps::OutputExtrapolator<float> extrapolator(3, 2);
+    extrapolator.SetOutputRange(0.0f, 1.0f);
+    extrapolator.Anchor(x, y, jac);
+    std::vector<float> moved = {0.42f, 0.59f, 1.0f}, estimate(2), exact;
+    extrapolator.Extrapolate(moved, estimate);
+    mlp.GetOutput(moved, &exact);
+    for (size_t k = 0; k < 2; ++k) {
+        if (std::abs(estimate[k] - exact[k]) > std::abs(y[k] - exact[k]) * 0.2f + 1e-5f) {
+            std::cerr << "FAIL: Extrapolation no better than holding the output\n";
+            return false;
+        }
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_change_notification() {
+    std::cout << "--- Test: Output change notification ---\n";
+
+    nisps::IML<float> iml(2, 3, {8});
+    const float in_a[2] = {0.2f, 0.8f};
+    iml.set_inputs(in_a, 2);
+    iml.process();
+    iml.set_change_epsilon(0.05f);
+
+    // Same input again: nothing to report
+    iml.set_inputs(in_a, 2);
+    if (iml.process() || iml.get_changed_mask() != 0) {
+        std::cerr << "FAIL: Unchanged input reported a change\n";
+        return false;
+    }
+
+    // Nothing new to process: no report either
+    if (iml.process() || iml.get_changed_mask() != 0) {
+        std::cerr << "FAIL: Idle process() reported a change\n";
+        return false;
+    }
+
+    // Each bit follows its own output
+    const float before[3] = {iml.get_outputs()[0], iml.get_outputs()[1], iml.get_outputs()[2]};
+    const float in_b[2] = {0.9f, 0.1f};
+    iml.set_inputs(in_b, 2);
+    const bool changed = iml.process();
+    for (size_t i = 0; i < 3; i++) {
+        const bool moved = std::abs(iml.get_outputs()[i] - before[i]) > 0.05f;
+        if (moved != (((iml.get_changed_mask() >> i) & 1) != 0)) {
+            std::cerr << "FAIL: Bit " << i << " does not match output " << i << "\n";
+            return false;
+        }
+    }
+    if (changed != (iml.get_changed_mask() != 0)) {
+        std::cerr << "FAIL: process() result disagrees with the mask\n";
+        return false;
+    }
+
+    // With no epsilon any movement is reported. Outputs that stayed within the
+    // old epsilon are still reported at their in_a values, so use a new input.
+    iml.set_change_epsilon(0.0f);
+    const float in_c[2] = {0.5f, 0.4f};
+    iml.set_inputs(in_c, 2);
+    if (!iml.process() || iml.get_changed_mask() == 0) {
+        std::cerr << "FAIL: Input change was not reported\n";
+        return false;
+    }
+
+    // Retraining moves the outputs without new input; the next process() reports it
+    iml.set_change_epsilon(0.05f);
+    iml.set_mode(nisps::IML<float>::Mode::Training);
+    for (int i = 0; i < 4; i++) {
+        const float x[2] = {i / 3.0f, 0.5f}, y[3] = {0.95f, 0.05f, 0.95f};
+        iml.add_example(x, 2, y, 3);
+    }
+    iml.set_mode(nisps::IML<float>::Mode::Inference);
+    if (!iml.process() || iml.get_changed_mask() == 0) {
+        std::cerr << "FAIL: Retrained outputs were not reported\n";
+        return false;
+    }
+    if (iml.process()) {
+        std::cerr << "FAIL: Retrained outputs were reported twice\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_magnitude_pruning() {
+    std::cout << "--- Test: Magnitude pruning and sparse inference ---\n";
+
+    nisps::MLP<float> mlp({3, 32, 32, 2}, {nisps::RELU, nisps::RELU, nisps::SIGMOID});
+    mlp.SetSeed(7);
+    mlp.InitXavier();
+    nisps::MLP<float>::training_pair_t data;
+    for (int i = 0; i < 16; i++) {
+        const float a = i / 15.0f, b = 1.0f - (i % 4) / 3.0f;
+        data.first.push_back({a, b, 1.0f});
+        data.second.push_back({a * b, 0.5f * (a + b)});
+    }
+    mlp.Train(data, 0.05f, 200, 0.0f, false);
+
+    nisps::MagnitudePruner<float> pruner(mlp);
+    if (!pruner.PruneGlobal(0.7f) || std::abs(pruner.GetSparsity() - 0.7f) > 0.01f) {
+        std::cerr << "FAIL: Global pruning missed the target, sparsity " << pruner.GetSparsity() << "\n";
+        return false;
+    }
+    const float loss = pruner.FineTune(data, 0.05f, 50);
+    std::cout << "  sparsity " << pruner.GetSparsity() << ", fine-tuned loss " << loss << "\n";
+    for (size_t l = 0; l < mlp.m_layers.size(); l++) {
+        const uint8_t *keep = pruner.GetMask(l).data();
+        for (const auto &node : mlp.m_layers[l].m_nodes) {
+            for (float w : node.m_weights) {
+                if (!*keep++ && w != 0.0f) {
+                    std::cerr << "FAIL: A pruned weight came back during fine-tuning\n";
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Per-layer targets are met layer by layer
+    const float targets[3] = {0.0f, 0.8f, 0.5f};
+    pruner.ClearMask();
+    if (!pruner.PruneLayers(targets) || pruner.GetSparsity(0) > 0.7f ||
+        std::abs(pruner.GetSparsity(1) - 0.8f) > 0.01f) {
+        std::cerr << "FAIL: Per-layer pruning missed its targets\n";
+        return false;
+    }
+
+    // Both kernels must agree with the network, whichever the benchmark picked
+    nisps::SparseInference<float> sparse(mlp);
+    std::vector<float> expected(2);
+    for (int pass = 0; pass < 3; pass++) {
+        for (size_t l = 0; l < mlp.m_layers.size(); l++) {
+            if (pass < 2) {
+                sparse.SetLayerSparse(l, pass == 1);
+            }
+        }
+        for (const auto &x : data.first) {
+            mlp.GetOutput(x, &expected);
+            const auto &y = sparse.Process(x);
+            for (size_t k = 0; k < 2; k++) {
+                if (std::abs(y[k] - expected[k]) > 1e-5f) {
+                    std::cerr << "FAIL: Sparse inference differs from the network\n";
+                    return false;
+                }
+            }
+        }
+        if (pass == 1) {
+            sparse.SelectKernels();
+        }
+    }
+    std::cout << "  layer 1 density " << sparse.GetLayerDensity(1)
+              << ", sparse kernel " << (sparse.IsLayerSparse(1) ? "yes" : "no") << "\n";
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_distillation() {
+    std::cout << "--- Test: Neuron pruning and distillation ---\n";
+
+    // Teacher: the default hidden stack trained on a smooth 2D mapping
+    nisps::MLP<float> teacher({3, 10, 10, 14, 2}, {nisps::RELU, nisps::RELU, nisps::RELU, nisps::SIGMOID});
+    teacher.SetSeed(11);
+    teacher.InitXavier();
+    nisps::MLP<float>::training_pair_t data;
+    for (int i = 0; i < 25; i++) {
+        const float a = (i % 5) / 4.0f, b = (i / 5) / 4.0f;
+        data.first.push_back({a, b, 1.0f});
+        data.second.push_back({0.2f + 0.6f * a * b, 0.8f - 0.5f * a});
+    }
+    teacher.Train(data, 0.05f, 500, 0.0f, false);
+
+    nisps::Distiller<float>::Config config;
+    config.train_samples = 256;
+    config.test_samples = 128;
+    config.epochs = 100;
+    config.seed = 5;
+    nisps::Distiller<float> distiller(teacher, {0.0f, 0.0f}, {1.0f, 1.0f}, config);
+    if (distiller.GetImportance(2).size() != 14) {
+        std::cerr << "FAIL: Expected one importance per neuron\n";
+        return false;
+    }
+
+    // Same depth, narrower: starts from the teacher's most important neurons
+    nisps::DistillReport<float> pruned;
+    nisps::MLP<float> narrow = distiller.Distil({6, 6, 6}, &pruned);
+    // Fewer layers: trained from scratch
+    nisps::DistillReport<float> shallow;
+    nisps::MLP<float> small = distiller.Distil({8}, &shallow);
+    std::cout << "  {6, 6, 6}: " << pruned.student_parameters << "/" << pruned.teacher_parameters
+              << " params, max error " << pruned.max_abs_error << "\n";
+    std::cout << "  {8}: " << shallow.student_parameters << " params, mean error "
+              << shallow.mean_abs_error << ", max error " << shallow.max_abs_error << "\n";
+
+    if (narrow.m_layers.size() != 4 || narrow.m_layers[1].GetOutputSize() != 6 ||
+        small.m_layers.size() != 2 || small.get_num_outputs() != 2) {
+        std::cerr << "FAIL: Student topology does not match the request\n";
+        return false;
+    }
+    if (pruned.student_parameters >= pruned.teacher_parameters ||
+        pruned.mean_abs_error > 0.05f || shallow.mean_abs_error > 0.05f) {
+        std::cerr << "FAIL: Students do not reproduce the teacher\n";
+        return false;
+    }
+    const auto check = distiller.Evaluate(small);
+    if (std::abs(check.max_abs_error - shallow.max_abs_error) > 1e-6f) {
+        std::cerr << "FAIL: Report does not match a re-evaluation\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_topology_search() {
+    std::cout << "--- Test: Topology search ---\n";
+
+    nisps::Dataset dataset;
+    for (int i = 0; i < 36; i++) {
+        const float a = (i % 6) / 5.0f, b = (i / 6) / 5.0f;
+        dataset.Add({a, b}, {0.2f + 0.6f * a * b});
+    }
+
+    nisps::TopologySearch<float>::Config config;
+    config.folds = 3;
+    config.epochs = 150;
+    config.num_threads = 4;
+    config.seed = 3;
+    nisps::TopologySearch<float> search(dataset, config);
+    const auto candidates = nisps::TopologySearch<float>::Grid(
+        {{}, {4}, {10, 10, 14}}, {nisps::RELU, nisps::TANH}, {0.05f}, {0, 6});
+    const auto &results = search.Run(candidates);
+    if (results.size() != candidates.size()) {
+        std::cerr << "FAIL: Expected one result per candidate\n";
+        return false;
+    }
+    const auto front = search.GetParetoFront();
+    for (size_t i : front) {
+        const auto &r = results[i];
+        std::cout << "  hidden " << r.candidate.hidden.size() << " layers, " << r.parameters
+                  << " params, loss " << r.validation_loss << ", " << r.inference_ns << " ns\n";
+        for (const auto &o : results) {
+            if (o.inference_ns < r.inference_ns && o.validation_loss < r.validation_loss) {
+                std::cerr << "FAIL: A dominated result is on the Pareto front\n";
+                return false;
+            }
+        }
+    }
+    if (front.empty()) {
+        std::cerr << "FAIL: Empty Pareto front\n";
+        return false;
+    }
+
+    const auto best = std::min_element(results.begin(), results.end(), [](const auto &a, const auto &b) {
+        return a.validation_loss < b.validation_loss;
+    });
+    const ptrdiff_t pick = search.SelectSmallest(best->validation_loss * 2);
+    if (pick < 0 || results[pick].parameters > best->parameters ||
+        search.SelectSmallest(-1.0f) != -1) {
+        std::cerr << "FAIL: SelectSmallest did not pick the smallest model meeting the target\n";
+        return false;
+    }
+    auto deployed = search.TrainFinal(results[pick].candidate);
+    if (deployed->GetNumParameters() != results[pick].parameters) {
+        std::cerr << "FAIL: Final model does not match the chosen candidate\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_training_telemetry() {
+    std::cout << "--- Test: Training telemetry ring ---\n";
+
+    nisps::MLP<float> mlp({3, 8, 1}, {nisps::RELU, nisps::SIGMOID});
+    mlp.SetSeed(9);
+    nisps::MLP<float>::training_pair_t data;
+    for (int i = 0; i < 16; i++) {
+        data.first.push_back({i / 15.0f, 0.5f, 1.0f});
+        data.second.push_back({i / 15.0f});
+    }
+
+    // Nobody drains: the trainer keeps going and counts what it dropped
+    nisps::TelemetryRing ring(8);
+    mlp.SetTelemetryRing(&ring);
+    mlp.TrainBatch(data, 0.01f, 20, 4, 0.0f, false);
+    nisps::TrainingTelemetry records[32];
+    size_t n = ring.TryPop(records, 32);
+    if (n != 8 || records[0].iteration != 0 || records[7].iteration != 7 ||
+        records[0].learning_rate != 0.01f || !(records[0].grad_norm > 0.0f)) {
+        std::cerr << "FAIL: Expected the first 8 iterations in the ring, got " << n << "\n";
+        return false;
+    }
+    // The 12 records that did not fit are reported with the next one delivered
+    mlp.TrainBatch(data, 0.01f, 1, 4, 0.0f, false);
+    if (!ring.TryPop(records[0]) || records[0].dropped != 12 || !records[0].last) {
+        std::cerr << "FAIL: Dropped records were not counted\n";
+        return false;
+    }
+
+    // A consumer on another thread drains a ring smaller than the run. It may
+    // fall behind, so records can be lost, but every loss is accounted for:
+    // each record carries the number dropped since the previous delivered one.
+    constexpr size_t kIterations = 200;
+    nisps::TelemetryRing live(16);
+    mlp.SetTelemetryRing(&live);
+    std::atomic<bool> running{true};
+    std::vector<nisps::TrainingTelemetry> seen;
+    std::thread consumer([&] {
+        nisps::TrainingTelemetry r;
+        while (running.load() || live.Size()) {
+            while (live.TryPop(r)) {
+                seen.push_back(r);
+            }
+            std::this_thread::yield();
+        }
+    });
+    mlp.Train(data, 0.01f, kIterations, 0.0f, false);
+    running = false;
+    consumer.join();
+
+    size_t accounted = 0;
+    for (size_t i = 0; i < seen.size(); i++) {
+        accounted += seen[i].dropped + 1;
+        if (seen[i].iteration + 1 != accounted ||
+            (i > 0 && seen[i].elapsed_s < seen[i - 1].elapsed_s)) {
+            std::cerr << "FAIL: Telemetry out of order or miscounted at record " << i << "\n";
+            return false;
+        }
+    }
+    if (!seen.empty() && seen.back().last && accounted != kIterations) {
+        std::cerr << "FAIL: Last record is not the last iteration\n";
+        return false;
+    }
+    // Records lost at the end of the run are reported with the next one delivered
+    mlp.Train(data, 0.01f, 1, 0.0f, false);
+    nisps::TrainingTelemetry tail;
+    if (!live.TryPop(tail) || !tail.last || accounted + tail.dropped != kIterations) {
+        std::cerr << "FAIL: Telemetry lost " << kIterations - accounted << " records unreported\n";
+        return false;
+    }
+    std::cout << "  " << seen.size() << " records delivered, " << kIterations - seen.size()
+              << " dropped and counted\n";
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_frozen_model() {
+    std::cout << "--- Test: Frozen inference model ---\n";
+
+    nisps::MLP<float> mlp({3, 10, 10, 14, 2}, {nisps::RELU, nisps::RELU, nisps::RELU, nisps::SIGMOID});
+    mlp.SetSeed(21);
+    mlp.InitXavier();
+    nisps::FrozenMLP<float> frozen = mlp.Freeze();
+    if (frozen.GetNumParameters() != mlp.GetNumParameters()) {
+        std::cerr << "FAIL: Frozen model has " << frozen.GetNumParameters() << " parameters\n";
+        return false;
+    }
+
+    // Inputs arrive in [0, 100]; outputs are wanted in [-1, 1]
+    nisps::FreezeNormalisation<float> norm;
+    norm.input_offset = {50.0f, 50.0f, 0.0f};
+    norm.input_scale = {0.01f, 0.01f, 1.0f};
+    norm.output_scale = {2.0f, 2.0f};
+    norm.output_offset = {-1.0f, -1.0f};
+    nisps::FrozenMLP<float> scaled = mlp.Freeze(norm);
+
+    std::vector<float> expected, y(2), ys(2);
+    for (int i = 0; i < 20; i++) {
+        const float a = i / 19.0f, b = 1.0f - a * a;
+        mlp.GetOutput({a, b, 1.0f}, &expected);
+        const float raw[3] = {a, b, 1.0f};
+        const float unscaled[3] = {a * 100.0f + 50.0f, b * 100.0f + 50.0f, 1.0f};
+        if (!frozen.Process(raw, y) || !scaled.Process(unscaled, ys)) {
+            std::cerr << "FAIL: Process() rejected the sizes\n";
+            return false;
+        }
+        for (size_t k = 0; k < 2; k++) {
+            if (std::abs(y[k] - expected[k]) > 1e-5f ||
+                std::abs(ys[k] - (expected[k] * 2.0f - 1.0f)) > 1e-4f) {
+                std::cerr << "FAIL: Frozen outputs differ from the network\n";
+                return false;
+            }
+        }
+    }
+
+    // A linear output layer takes the output map into its weights; softmax is kept
+    nisps::MLP<float> linear({3, 6, 2}, {nisps::TANH, nisps::LINEAR});
+    nisps::MLP<float> classifier({3, 6, 3}, {nisps::TANH, nisps::LINEAR},
+                                 nisps::loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY);
+    auto folded = linear.Freeze(norm);
+    auto frozen_classifier = classifier.Freeze();
+    std::vector<float> yc(3);
+    const float x[3] = {0.3f, 0.6f, 1.0f};
+    linear.GetOutput({(x[0] - 50.0f) * 0.01f, (x[1] - 50.0f) * 0.01f, 1.0f}, &expected);
+    folded.Process(x, y);
+    if (std::abs(y[0] - (expected[0] * 2.0f - 1.0f)) > 1e-4f) {
+        std::cerr << "FAIL: Folded linear output differs\n";
+        return false;
+    }
+    classifier.GetOutput({x[0], x[1], x[2]}, &expected);
+    frozen_classifier.Process(x, yc);
+    for (size_t k = 0; k < 3; k++) {
+        if (std::abs(yc[k] - expected[k]) > 1e-5f) {
+            std::cerr << "FAIL: Frozen softmax differs\n";
+            return false;
+        }
+    }
+
+    std::cout << "  " << frozen.GetNumParameters() << " parameters in " << frozen.GetFootprintBytes()
+              << " bytes\n";
+    if (frozen.GetFootprintBytes() > frozen.GetNumParameters() * sizeof(float) + 512) {
+        std::cerr << "FAIL: Frozen model carries more than its parameters\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_arena_allocation() {
+    std::cout << "--- Test: Model and workspace in one arena ---\n";
+
+    // Counts what reaches the arena; the arena refuses to fall back to the heap
+    struct CountingResource : std::pmr::memory_resource {
+        explicit CountingResource(std::pmr::memory_resource *upstream) : upstream(upstream) {}
+        std::pmr::memory_resource *upstream;
+        size_t allocations = 0;
+        void *do_allocate(size_t bytes, size_t align) override {
+            allocations++;
+            return upstream->allocate(bytes, align);
+        }
+        void do_deallocate(void *p, size_t bytes, size_t align) override {
+            upstream->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+    alignas(std::max_align_t) static std::byte buffer[64 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    CountingResource counting(&arena);
+
+    nisps::MLP<float> mlp({3, 8, 8, 1}, {nisps::RELU, nisps::RELU, nisps::SIGMOID},
+                          nisps::loss::LOSS_FUNCTIONS::LOSS_MSE, false, 0.5f, &counting);
+    mlp.SetSeed(3);
+    mlp.InitXavier();
+    const float *w = mlp.m_layers[1].m_nodes[0].m_weights.data();
+    if (mlp.GetMemoryResource() != &counting ||
+        reinterpret_cast<const std::byte *>(w) < buffer ||
+        reinterpret_cast<const std::byte *>(w) >= buffer + sizeof(buffer)) {
+        std::cerr << "FAIL: Weights were not placed in the arena\n";
+        return false;
+    }
+
+    nisps::MLP<float>::training_pair_t data;
+    for (int i = 0; i < 16; i++) {
+        const float a = i / 15.0f;
+        data.first.push_back({a, 1.0f - a, 1.0f});
+        data.second.push_back({a * 0.5f + 0.25f});
+    }
+    // Gradient accumulators are created by the first batch and reused afterwards
+    mlp.TrainBatch(data, 0.01f, 1, 4, 0, false);
+    const size_t after_first = counting.allocations;
+    mlp.TrainBatch(data, 0.01f, 50, 4, 0, false);
+    if (counting.allocations != after_first) {
+        std::cerr << "FAIL: Training allocated " << counting.allocations - after_first
+                  << " more times from the arena\n";
+        return false;
+    }
+
+    // Copies leave the arena; the frozen model can be placed in it
+    nisps::MLP<float> copy(mlp);
+    if (copy.GetMemoryResource() != std::pmr::get_default_resource()) {
+        std::cerr << "FAIL: Copy kept the arena\n";
+        return false;
+    }
+    auto frozen = mlp.Freeze({}, &counting);
+    std::vector<float> expected, y(1);
+    const float x[3] = {0.2f, 0.8f, 1.0f};
+    mlp.GetOutput({x[0], x[1], x[2]}, &expected);
+    copy.GetOutput({x[0], x[1], x[2]}, &y);
+    const float copied = y[0];
+    frozen.Process(x, y);
+    if (counting.allocations != after_first + 1 || std::abs(y[0] - expected[0]) > 1e-6f ||
+        copied != expected[0]) {
+        std::cerr << "FAIL: Frozen model or copy differs\n";
+        return false;
+    }
+    std::cout << "  " << after_first + 1 << " arena allocations\n";
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_fourier_features() {
+    std::cout << "--- Test: Random Fourier feature embedding ---\n";
+
+    nisps::FourierFeatures<float>::Config config;
+    config.num_features = 16;
+    config.bandwidth = 1.0f;
+    config.seed = 4;
+    nisps::FourierFeatures<float> features(2, config);
+    if (features.GetNumOutputs() != 34) {
+        std::cerr << "FAIL: Expected 34 outputs, got " << features.GetNumOutputs() << "\n";
+        return false;
+    }
+
+    // Each output pair is sin and cos of 2 pi b.x
+    const float x[2] = {0.3f, -0.7f};
+    std::vector<float> out(features.GetNumOutputs());
+    features.Process(x, out);
+    const auto freqs = features.GetFrequencies();
+    for (size_t f = 0; f < 16; f++) {
+        const double t = 2.0 * std::numbers::pi * (freqs[f * 2] * x[0] + freqs[f * 2 + 1] * x[1]);
+        if (std::abs(out[f] - std::sin(t)) > 1e-5 || std::abs(out[16 + f] - std::cos(t)) > 1e-5) {
+            std::cerr << "FAIL: Feature " << f << " is not sin/cos of the projection\n";
+            return false;
+        }
+    }
+    if (out[32] != x[0] || out[33] != x[1]) {
+        std::cerr << "FAIL: Inputs not appended\n";
+        return false;
+    }
+
+    // Stored and restored, the embedding is identical
+    std::vector<uint8_t> buffer(features.SerialisedSize());
+    nisps::FourierFeatures<float> restored;
+    std::vector<float> again(features.GetNumOutputs());
+    if (features.Serialise(buffer) != buffer.size() || !restored.FromSerialised(buffer) ||
+        !restored.Process(x, again) || again != out) {
+        std::cerr << "FAIL: Serialisation round trip\n";
+        return false;
+    }
+    buffer[0] = 'X';
+    if (restored.FromSerialised(buffer)) {
+        std::cerr << "FAIL: Accepted a bad magic number\n";
+        return false;
+    }
+
+    // Training rows get the embedding plus a constant bias input
+    const auto rows = features.Transform({{0.3f, -0.7f, 9.0f}}, 1);
+    if (rows.size() != 1 || rows[0].size() != 35 || rows[0][34] != 1.0f ||
+        !std::equal(out.begin(), out.end(), rows[0].begin())) {
+        std::cerr << "FAIL: Transform does not match Process\n";
+        return false;
+    }
+    if (!features.Transform({{0.3f, -0.7f}, {0.3f}}, 1).empty()) {
+        std::cerr << "FAIL: Transform accepted a short row\n";
+        return false;
+    }
+
+    // Sizes in the header are bounded before they are multiplied
+    nisps::binary_io::Store<uint32_t>(buffer.data() + 8, 0x80000000u);
+    nisps::binary_io::Store<uint32_t>(buffer.data() + 12, 0x80000000u);
+    std::memcpy(buffer.data(), nisps::FourierFeatures<float>::kMagic, 4);
+    if (nisps::FourierFeatures<float>::RecordSize(buffer) != 0 || restored.FromSerialised(buffer)) {
+        std::cerr << "FAIL: Accepted sizes that overflow\n";
+        return false;
+    }
+
+    // The model container carries the embedding when asked to
+    const char* path = "nisps_test_embedded.nspm";
+    nisps::MLP<float> mlp({35, 8, 1}, {nisps::RELU, nisps::SIGMOID});
+    nisps::MLP<float> loaded({3, 4, 1}, {nisps::RELU, nisps::SIGMOID});
+    if (loaded.SetInputEmbedding(features) || !mlp.SetInputEmbedding(features)) {
+        std::cerr << "FAIL: Embedding width not checked against the network inputs\n";
+        return false;
+    }
+    if (!mlp.SaveModel(path, nisps::ModelFormat::kSectionWeights | nisps::ModelFormat::kSectionEmbedding) ||
+        !loaded.LoadModel(path) || !loaded.GetInputEmbedding() ||
+        !loaded.GetInputEmbedding()->Process(x, again) || again != out) {
+        std::cerr << "FAIL: Embedding did not survive SaveModel/LoadModel\n";
+        return false;
+    }
+    // A container whose embedding does not feed the network is rejected,
+    // even with a valid checksum: here the raw inputs are no longer appended
+    const uint32_t sections = nisps::ModelFormat::kSectionWeights | nisps::ModelFormat::kSectionEmbedding;
+    std::vector<uint8_t> container(mlp.SerialisedSize(sections));
+    mlp.Serialise(container, sections);
+    const size_t crc_at = container.size() - nisps::ModelFormat::kCrcSize;
+    nisps::binary_io::Store<uint16_t>(container.data() + crc_at - features.SerialisedSize() + 6, 0);
+    nisps::binary_io::Store<uint32_t>(container.data() + crc_at, nisps::binary_io::Crc32(container.data(), crc_at));
+    if (loaded.LoadModel(std::span<const uint8_t>(container))) {
+        std::cerr << "FAIL: Loaded an embedding that does not match the network\n";
+        return false;
+    }
+
+    // A container without one drops the previous model's embedding
+    mlp.SaveModel(path);
+    if (!loaded.LoadModel(path) || loaded.GetInputEmbedding()) {
+        std::cerr << "FAIL: Stale embedding kept after LoadModel\n";
+        return false;
+    }
+    std::remove(path);
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_gru_streaming() {
+    std::cout << "--- Test: GRU streaming mapping ---\n";
+
+    // Output the input from three ticks ago: impossible without memory
+    nisps::Random rng(7);
+    auto make = [&](size_t len) {
+        nisps::GRU<float>::sequence_t seq;
+        for (size_t t = 0; t < len; t++) {
+            seq.first.push_back({rng.Uniform<float>()});
+            seq.second.push_back({0.1f + 0.8f * (t >= 3 ? seq.first[t - 3][0] : 0.5f)});
+        }
+        return seq;
+    };
+    std::vector<nisps::GRU<float>::sequence_t> sequences;
+    for (int i = 0; i < 16; i++) {
+        sequences.push_back(make(64));
+    }
+    nisps::GRU<float> gru(1, 12, 1, nisps::SIGMOID, 3);
+    const float loss = gru.Train(sequences, 0.01f, 100, 16);
+
+    const auto test = make(200);
+    std::vector<float> outputs(test.first.size());
+    double mse = 0;
+    for (size_t t = 0; t < test.first.size(); t++) {
+        gru.Step(test.first[t], std::span<float>(&outputs[t], 1));
+        if (t >= 3) {
+            mse += (outputs[t] - test.second[t][0]) * (outputs[t] - test.second[t][0]);
+        }
+    }
+    mse /= static_cast<double>(test.first.size() - 3);
+    std::cout << "  Training loss " << loss << ", streamed MSE " << mse << " (memoryless: ~0.053), "
+              << gru.GetNumParameters() << " parameters\n";
+    if (!(mse < 0.005)) {
+        std::cerr << "FAIL: GRU did not learn the delay\n";
+        return false;
+    }
+
+    // A restored network replays the same stream exactly
+    std::vector<uint8_t> buffer(gru.SerialisedSize());
+    nisps::GRU<float> restored;
+    if (gru.Serialise(buffer) != buffer.size() || !restored.FromSerialised(buffer) ||
+        restored.GetNumHidden() != 12) {
+        std::cerr << "FAIL: Serialisation round trip\n";
+        return false;
+    }
+    for (size_t t = 0; t < test.first.size(); t++) {
+        float y;
+        restored.Step(test.first[t], std::span<float>(&y, 1));
+        if (y != outputs[t]) {
+            std::cerr << "FAIL: Restored network differs at tick " << t << "\n";
+            return false;
+        }
+    }
+    float y2[2];
+    if (restored.Step(std::vector<float>{0.0f, 1.0f}, y2)) {
+        std::cerr << "FAIL: Accepted the wrong number of inputs\n";
+        return false;
+    }
+    // Training checks every row first and leaves the network alone if one is the wrong width
+    auto bad = sequences;
+    bad[5].first[10].clear();
+    bad[9].second[3].push_back(0.0f);
+    for (size_t i : {5, 9}) {
+        auto one_bad = sequences;
+        one_bad[i] = bad[i];
+        if (!std::isnan(restored.Train(one_bad, 0.01f, 1, 16))) {
+            std::cerr << "FAIL: Trained on a row of the wrong width\n";
+            return false;
+        }
+    }
+    std::vector<uint8_t> after(restored.SerialisedSize());
+    restored.Serialise(after);
+    if (after != buffer) {
+        std::cerr << "FAIL: Rejected training changed the network\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
+bool test_gesture_recogniser() {
+    std::cout << "--- Test: Streaming DTW gesture recogniser ---\n";
+
+    // Joystick gestures: a circle, a swipe and a zigzag, at parameter s in [0, 1]
+    auto shape = [](int gesture, float s) -> std::vector<float> {
+        switch (gesture) {
+            case 0: return {0.5f + 0.3f * std::cos(2 * std::numbers::pi_v<float> * s),
+                            0.5f + 0.3f * std::sin(2 * std::numbers::pi_v<float> * s)};
+            case 1: return {0.2f + 0.6f * s, 0.3f};
+            default: return {0.2f + 0.6f * s, 0.2f + 0.6f * std::abs(std::fmod(3 * s, 1.0f) * 2 - 1)};
+        }
+    };
+    nisps::Random rng(5);
+    auto jitter = [&](std::vector<float> p) {
+        for (auto &v : p) {
+            v += 0.01f * rng.Normal<float>();
+        }
+        return p;
+    };
+
+    nisps::GestureRecogniser::Config config;
+    config.template_length = 32;
+    config.band = 4;
+    config.reject_distance = 0.01f;
+    nisps::GestureRecogniser recogniser(2, config);
+    config.prune = false;
+    nisps::GestureRecogniser reference(2, config);
+    for (int gesture = 0; gesture < 3; gesture++) {
+        for (int take = 0; take < 2; take++) {
+            std::vector<std::vector<float>> frames;
+            for (int i = 0; i < 40; i++) {
+                frames.push_back(jitter(shape(gesture, i / 39.0f)));
+            }
+            recogniser.AddTemplate(frames, gesture);
+            reference.AddTemplate(frames, gesture);
+        }
+    }
+
+    // Rest at the centre between gestures, performed shorter and unevenly paced
+    const std::vector<int> performed = {0, 2, 1, 0};
+    std::vector<std::vector<float>> stream;
+    for (int gesture : performed) {
+        for (int i = 0; i < 40; i++) {
+            stream.push_back(jitter({0.5f, 0.5f}));
+        }
+        for (int i = 0; i < 36; i++) {
+            stream.push_back(jitter(shape(gesture, std::pow(i / 35.0f, 1.2f))));
+        }
+    }
+    for (int i = 0; i < 40; i++) {
+        stream.push_back(jitter({0.5f, 0.5f}));
+    }
+
+    std::vector<int> onsets;
+    for (const auto &frame : stream) {
+        nisps::GestureMatch match, exact;
+        recogniser.Process(frame, &match);
+        reference.Process(frame, &exact);
+        if (match.class_id != exact.class_id || match.distance != exact.distance ||
+            std::abs(match.confidence - exact.confidence) > 1e-6f) {
+            std::cerr << "FAIL: Pruning changed the result\n";
+            return false;
+        }
+        if (match.onset) {
+            onsets.push_back(match.class_id);
+        }
+    }
+    if (onsets != performed) {
+        std::cerr << "FAIL: Recognised " << onsets.size() << " gestures, not the four performed\n";
+        return false;
+    }
+
+    const auto &stats = recogniser.GetStats();
+    std::cout << "  " << stats.candidates << " comparisons: " << stats.pruned_kim << " LB_Kim, "
+              << stats.pruned_keogh << " LB_Keogh, " << stats.abandoned << " abandoned, " << stats.full
+              << " full\n";
+    if (stats.full * 10 > stats.candidates) {
+        std::cerr << "FAIL: Lower bounds pruned too little\n";
+        return false;
+    }
+    nisps::GestureMatch none;
+    if (recogniser.Process(std::vector<float>{0.5f}, &none)) {
+        std::cerr << "FAIL: Accepted a frame of the wrong size\n";
+        return false;
+    }
+
+    std::cout << "PASS\n\n";
+    return true;
+}
+
 int main() {
     std::cout << "\n=== NISPS Core Test Suite ===\n\n";
 
@@ -230,6 +1716,27 @@ int main() {
     run(test_add_example_api());
     run(test_training_convergence());
     run(test_multi_output_training());
+    run(test_dataset_file_roundtrip());
+    run(test_model_file_roundtrip());
+    run(test_in_memory_serialisation());
+    run(test_session_journal());
+    run(test_parameter_snapshots());
+    run(test_weight_morphing());
+    run(test_random_generator());
+    run(test_evolution_strategies());
+    run(test_online_adaptation());
+    run(test_incremental_inference());
+    run(test_jacobian_extrapolation());
+    run(test_change_notification());
+    run(test_magnitude_pruning());
+    run(test_distillation());
+    run(test_topology_search());
+    run(test_training_telemetry());
+    run(test_frozen_model());
+    run(test_arena_allocation());
+    run(test_fourier_features());
+    run(test_gru_streaming());
+    run(test_gesture_recogniser());
 
     std::cout << "=== Results: " << passed << " passed, " << failed << " failed ===\n\n";
 
@@ -0,0 +1,85 @@
+#include <nisps/nisps.hpp>
+#include <iostream>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const nisps::profile::SiteStats *Find(const std::vector<nisps::profile::SiteStats> &stats, const char *name) {
+    for (const auto &s : stats) {
+        if (std::strcmp(s.name, name) == 0) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+void print_line(const char *line) {
+    std::cout << "  " << line << "\n";
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "\n=== NISPS Profiling Hooks ===\n\n";
+
+    nisps::IML<float> iml(2, 2, {8, 8});
+    for (int i = 0; i < 8; i++) {
+        const float x[2] = {i / 7.0f, 1.0f - i / 7.0f};
+        const float y[2] = {i / 7.0f, 0.5f};
+        iml.add_example(x, 2, y, 2);
+    }
+    iml.set_mode(nisps::IML<float>::Mode::Training);
+    iml.set_mode(nisps::IML<float>::Mode::Inference);
+    for (int i = 0; i < 100; i++) {
+        iml.set_input(0, i / 99.0f);
+        iml.process();
+    }
+
+    // TrainBatch phases, recorded from two threads into separate slots
+    auto train = [] {
+        nisps::MLP<double> mlp({3, 8, 1}, {nisps::RELU, nisps::SIGMOID});
+        nisps::MLP<double>::training_pair_t data;
+        for (int i = 0; i < 16; i++) {
+            data.first.push_back({i / 15.0, 0.5, 1.0});
+            data.second.push_back({i / 15.0});
+        }
+        mlp.TrainBatch(data, 0.01f, 10, 4, 0.0f, false);
+    };
+    std::thread worker(train);
+    train();
+    worker.join();
+
+    const auto stats = nisps::profile::Snapshot();
+    nisps::profile::Dump(print_line);
+
+    int failed = 0;
+    auto expect = [&](const char *name, uint64_t min_count) {
+        const auto *s = Find(stats, name);
+        if (!s || s->count < min_count || !(s->p50_us <= s->p99_us && s->p99_us <= s->max_us)) {
+            std::cerr << "FAIL: " << name << " missing or inconsistent\n";
+            failed++;
+        }
+    };
+    expect("IML::process", 100);
+    expect("IML::train", 1);
+    expect("MLP::GetOutput", 100);
+    expect("Dataset::Add", 8);
+    // 2 threads x 10 epochs x 16 samples, 4 batches per epoch
+    expect("TrainBatch/forward", 320);
+    expect("TrainBatch/loss", 320);
+    expect("TrainBatch/backward", 320);
+    expect("TrainBatch/clip", 80);
+    expect("TrainBatch/apply", 80);
+
+    nisps::profile::Reset();
+    const auto after_stats = nisps::profile::Snapshot();
+    const auto *after = Find(after_stats, "IML::process");
+    if (!after || after->count != 0) {
+        std::cerr << "FAIL: Reset() kept samples\n";
+        failed++;
+    }
+
+    std::cout << (failed ? "FAILED" : "PASS") << "\n\n";
+    return failed ? 1 : 0;
+}
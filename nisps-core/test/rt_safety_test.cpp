@@ -0,0 +1,337 @@
+// Real-time safety check: interposes the allocator and the pthread mutex
+// calls, and fails if any of them is reached inside a NISPS_RT_SECTION.
+// Each violation is reported with a stack trace. Linux and glibc only.
+
+#include <nisps/nisps.hpp>
+#include <nisps/gru.hpp>
+#include <nisps/gesture.hpp>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <new>
+
+#if defined(__GLIBC__)
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+}
+
+namespace {
+
+std::atomic<int> g_violations{0};
+thread_local bool t_reporting = false;
+
+// Must not allocate: it runs inside the hooks
+void Check(const char *call, size_t bytes) {
+    if (!nisps::rt::InSection() || t_reporting) {
+        return;
+    }
+    t_reporting = true;
+    g_violations.fetch_add(1, std::memory_order_relaxed);
+    char line[160];
+    const int n = std::snprintf(line, sizeof(line), "RT violation: %s(%zu) in %s\n", call, bytes,
+                                nisps::rt::CurrentSection());
+    if (n > 0) {
+        (void)!write(STDERR_FILENO, line, std::min<size_t>(static_cast<size_t>(n), sizeof(line) - 1));
+    }
+    void *frames[32];
+    const int depth = backtrace(frames, 32);
+    backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+    t_reporting = false;
+}
+
+template<typename Fn>
+Fn Next(std::atomic<Fn> &cache, const char *name) {
+    // No function-local static: its guard could itself take a mutex
+    Fn fn = cache.load(std::memory_order_acquire);
+    if (!fn) {
+        fn = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+        cache.store(fn, std::memory_order_release);
+    }
+    return fn;
+}
+
+using mutex_fn = int (*)(pthread_mutex_t *);
+std::atomic<mutex_fn> g_next_lock{nullptr};
+std::atomic<mutex_fn> g_next_unlock{nullptr};
+
+}  // namespace
+
+extern "C" {
+
+void *malloc(size_t size) {
+    Check("malloc", size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    Check("calloc", n * size);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) {
+    Check("realloc", size);
+    return __libc_realloc(p, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    Check("aligned_alloc", size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+    Check("posix_memalign", size);
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *out = p;
+    return 0;
+}
+
+void free(void *p) {
+    if (p) {
+        Check("free", 0);
+    }
+    __libc_free(p);
+}
+
+// trylock is left alone: it never blocks, and is the usual way to share state with a real-time thread
+int pthread_mutex_lock(pthread_mutex_t *m) {
+    Check("pthread_mutex_lock", 0);
+    return Next(g_next_lock, "pthread_mutex_lock")(m);
+}
+
+int pthread_mutex_unlock(pthread_mutex_t *m) {
+    Check("pthread_mutex_unlock", 0);
+    return Next(g_next_unlock, "pthread_mutex_unlock")(m);
+}
+
+}  // extern "C"
+
+void *operator new(size_t size) {
+    Check("operator new", size);
+    if (void *p = __libc_malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    Check("operator new[]", size);
+    if (void *p = __libc_malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    if (p) {
+        Check("operator delete", 0);
+    }
+    __libc_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    if (p) {
+        Check("operator delete[]", 0);
+    }
+    __libc_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete[](p); }
+
+// The aligned and nothrow forms do not go through the plain ones, so each needs its own hook
+
+void *operator new(size_t size, std::align_val_t align) {
+    Check("operator new", size);
+    if (void *p = __libc_memalign(static_cast<size_t>(align), size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t align) {
+    Check("operator new[]", size);
+    if (void *p = __libc_memalign(static_cast<size_t>(align), size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    Check("operator new", size);
+    return __libc_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    Check("operator new[]", size);
+    return __libc_malloc(size ? size : 1);
+}
+
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    Check("operator new", size);
+    return __libc_memalign(static_cast<size_t>(align), size ? size : 1);
+}
+
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    Check("operator new[]", size);
+    return __libc_memalign(static_cast<size_t>(align), size ? size : 1);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { operator delete[](p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { operator delete[](p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { operator delete(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { operator delete[](p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { operator delete(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { operator delete[](p); }
+
+namespace {
+
+int Violations() {
+    return g_violations.exchange(0, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "\n=== NISPS Real-Time Safety ===\n\n";
+
+    // backtrace() loads its unwinder on first use; do that outside any section
+    void *warm[1];
+    backtrace(warm, 1);
+
+    int failed = 0;
+    auto expect = [&](const char *what, int expected) {
+        const int got = Violations();
+        if (got != expected) {
+            std::cerr << "FAIL: " << what << ": " << got << " violations, expected " << expected << "\n";
+            failed++;
+        } else {
+            std::cout << "  " << what << ": " << got << " violations\n";
+        }
+    };
+
+    // The checker catches what it should, and only inside a section
+    {
+        std::cout << "  Deliberate violations follow:\n";
+        std::mutex mutex;
+        void *(*volatile alloc)(size_t) = malloc;
+        void *(*volatile alloc_aligned)(size_t, size_t) = aligned_alloc;
+        int (*volatile memalign)(void **, size_t, size_t) = posix_memalign;
+        void *p = nullptr;
+        nisps::rt::Section section("probe");
+        free(alloc(16));
+        free(alloc_aligned(64, 64));
+        if (memalign(&p, 64, 16) == 0) {
+            free(p);
+        }
+        ::operator delete(::operator new(16));
+        ::operator delete(::operator new(16, std::align_val_t{64}), std::align_val_t{64});
+        ::operator delete(::operator new(16, std::nothrow), std::nothrow);
+        mutex.lock();
+        mutex.unlock();
+    }
+    expect("Probe section", 14);
+    ::operator delete(::operator new(16));
+    expect("Outside a section", 0);
+
+    // IML inference while another thread trains and allocates freely
+    nisps::IML<float> iml(3, 2, {8, 8});
+    iml.set_seed(5);
+    for (int i = 0; i < 16; i++) {
+        const float x[3] = {i / 15.0f, 1.0f - i / 15.0f, 0.5f};
+        const float y[2] = {i / 15.0f, 0.25f};
+        iml.add_example(x, 3, y, 2);
+    }
+    iml.set_mode(nisps::IML<float>::Mode::Training);
+    iml.set_mode(nisps::IML<float>::Mode::Inference);
+
+    std::atomic<bool> stop{false};
+    std::thread trainer([&] {
+        nisps::MLP<float> mlp({3, 16, 2}, {nisps::RELU, nisps::SIGMOID});
+        nisps::MLP<float>::training_pair_t data;
+        for (int i = 0; i < 32; i++) {
+            data.first.push_back({i / 31.0f, 0.5f, 1.0f});
+            data.second.push_back({i / 31.0f, 0.5f});
+        }
+        while (!stop.load()) {
+            mlp.TrainBatch(data, 0.01f, 5, 8, 0, false);
+        }
+    });
+    for (int i = 0; i < 2000; i++) {
+        iml.set_input(static_cast<size_t>(i % 3), static_cast<float>(i % 100) / 99.0f);
+        iml.process();
+    }
+    expect("IML::process", 0);
+
+    iml.set_incremental_inference(true);
+    for (int i = 0; i < 2000; i++) {
+        iml.set_input(static_cast<size_t>(i % 3), static_cast<float>(i % 100) / 99.0f);
+        iml.process();
+    }
+    expect("IML::process, incremental", 0);
+    stop.store(true);
+    trainer.join();
+
+    // Direct inference, including a softmax output, and a frozen model
+    nisps::MLP<float> classifier({3, 10, 10, 4}, {nisps::RELU, nisps::RELU, nisps::LINEAR},
+                                 nisps::loss::LOSS_FUNCTIONS::LOSS_CATEGORICAL_CROSSENTROPY);
+    const std::vector<float> x = {0.2f, 0.7f, 1.0f};
+    std::vector<float> y(4);
+    for (int i = 0; i < 1000; i++) {
+        classifier.GetOutput(x, &y);
+    }
+    expect("MLP::GetOutput", 0);
+
+    auto frozen = classifier.Freeze();
+    for (int i = 0; i < 1000; i++) {
+        frozen.Process(x, y);
+    }
+    expect("FrozenMLP::Process", 0);
+
+    nisps::GRU<float> gru(3, 16, 4);
+    for (int i = 0; i < 1000; i++) {
+        gru.Step(x, y);
+    }
+    expect("GRU::Step", 0);
+
+    nisps::GestureRecogniser recogniser(3, nisps::GestureRecogniser::Config());
+    recogniser.AddTemplate({{0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}}, 0);
+    nisps::GestureMatch match;
+    for (int i = 0; i < 1000; i++) {
+        recogniser.Process(x, &match);
+    }
+    expect("GestureRecogniser::Process", 0);
+
+    std::cout << "\n=== Results: " << (failed ? "FAIL" : "PASS") << " ===\n\n";
+    return failed ? 1 : 0;
+}
+
+#else
+
+int main() {
+    std::cout << "Real-time safety check skipped: needs glibc\n";
+    return 0;
+}
+
+#endif  // __GLIBC__
@@ -0,0 +1,69 @@
+// nisps-export: turns a saved model into a self-contained C++ header.
+//
+// Usage: nisps-export [--name Model] [--namespace nisps_model] [--fast] model header.hpp
+//
+// The model may be in the versioned container (SaveModel()) or the legacy
+// SaveMLPNetwork() format. See codegen.hpp for what the header contains.
+
+#include <nisps/codegen.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int Usage() {
+    std::cerr << "Usage: nisps-export [--name Model] [--namespace nisps_model] [--fast] model header.hpp\n";
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    nisps::CodegenOptions options;
+    const char *model = nullptr;
+    const char *header = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--fast") == 0) {
+            options.fast_activations = true;
+        } else if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            options.name = argv[++i];
+        } else if (std::strcmp(argv[i], "--namespace") == 0 && i + 1 < argc) {
+            options.name_space = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return Usage();
+        } else if (!model) {
+            model = argv[i];
+        } else if (!header) {
+            header = argv[i];
+        } else {
+            return Usage();
+        }
+    }
+    if (!model || !header) {
+        return Usage();
+    }
+
+    nisps::MLP<float> mlp{std::string(model)};
+    if (mlp.get_num_inputs() == 0) {
+        std::cerr << "Could not load " << model << "\n";
+        return 1;
+    }
+    const char *slash = std::strrchr(model, '/');
+    options.source = slash ? slash + 1 : model;
+    std::string text;
+    if (!nisps::GenerateHeader(mlp, options, &text)) {
+        std::cerr << "Could not export " << model << ": empty network or non-finite parameters\n";
+        return 1;
+    }
+    std::ofstream out(header);
+    out << text;
+    if (!out) {
+        std::cerr << "Could not write " << header << "\n";
+        return 1;
+    }
+    std::cerr << "Wrote " << header << " (" << mlp.GetNumParameters() << " parameters)\n";
+    return 0;
+}